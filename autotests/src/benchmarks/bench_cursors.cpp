@@ -0,0 +1,97 @@
+#include <QApplication>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+
+#include <katedocument.h>
+#include <kateglobal.h>
+#include <ktexteditor/movingcursor.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+static constexpr int cursors = 100000;
+
+static void printTime(const char *name, qint64 nsecs, int operations)
+{
+    printf("%-12s %10.1f ns/op (%d ops)\n", name, double(nsecs) / std::max(operations, 1), operations);
+}
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+
+    QCommandLineParser p;
+    p.setApplicationDescription(QStringLiteral("Performance benchmark for edits in documents with many moving cursors"));
+    p.addHelpOption();
+    QCommandLineOption cursorsOpt(QStringLiteral("c"), QStringLiteral("Number of moving cursors"), QStringLiteral("cursors"), QString::number(cursors));
+    p.addOption(cursorsOpt);
+    QCommandLineOption linesOpt(QStringLiteral("l"), QStringLiteral("Number of lines of text"), QStringLiteral("lines"), QStringLiteral("10000"));
+    p.addOption(linesOpt);
+    QCommandLineOption iterOpt(QStringLiteral("i"), QStringLiteral("Number of edits per kind"), QStringLiteral("iters"), QStringLiteral("10000"));
+    p.addOption(iterOpt);
+    p.process(app);
+
+    const int cursorCount = std::max(1, p.value(cursorsOpt).toInt());
+    const int lineCount = std::max(1, p.value(linesOpt).toInt());
+    const int iterations = std::max(1, p.value(iterOpt).toInt());
+
+    KTextEditor::EditorPrivate::enableUnitTestMode();
+
+    KTextEditor::DocumentPrivate doc;
+    QStringList lines;
+    for (int i = 0; i < lineCount; ++i) {
+        lines.push_back(QStringLiteral("This is a long long long sentence, number %1.").arg(i));
+    }
+    doc.setText(lines);
+
+    // spread the cursors over all lines and columns, like bookmarks, diagnostics or multi-cursors
+    QElapsedTimer timer;
+    timer.start();
+    std::vector<std::unique_ptr<KTextEditor::MovingCursor>> movingCursors;
+    movingCursors.reserve(cursorCount);
+    for (int i = 0; i < cursorCount; ++i) {
+        const int line = i % lineCount;
+        const int column = (i / lineCount) % doc.lineLength(line);
+        movingCursors.emplace_back(doc.newMovingCursor({line, column}));
+    }
+    printTime("create", timer.nsecsElapsed(), cursorCount);
+
+    // typing: insert and remove characters in the middle of lines
+    timer.restart();
+    for (int i = 0; i < iterations; ++i) {
+        doc.insertText({(i * 7) % lineCount, 10}, QStringLiteral("x"));
+    }
+    printTime("insertText", timer.nsecsElapsed(), iterations);
+
+    timer.restart();
+    for (int i = 0; i < iterations; ++i) {
+        doc.removeText(KTextEditor::Range((i * 7) % lineCount, 10, (i * 7) % lineCount, 11));
+    }
+    printTime("removeText", timer.nsecsElapsed(), iterations);
+
+    // line breaks: wrap and unwrap lines
+    timer.restart();
+    for (int i = 0; i < iterations; ++i) {
+        doc.editWrapLine((i * 7) % lineCount, 20);
+    }
+    printTime("wrapLine", timer.nsecsElapsed(), iterations);
+
+    timer.restart();
+    for (int i = 0; i < iterations; ++i) {
+        doc.editUnWrapLine((i * 7) % lineCount);
+    }
+    printTime("unwrapLine", timer.nsecsElapsed(), iterations);
+
+    // moving cursors around within their lines
+    timer.restart();
+    for (int i = 0; i < cursorCount; ++i) {
+        const auto position = movingCursors[i]->toCursor();
+        movingCursors[i]->setPosition({position.line(), (position.column() * 3) % std::max(1, doc.lineLength(position.line()))});
+    }
+    printTime("setPosition", timer.nsecsElapsed(), cursorCount);
+
+    return 0;
+}
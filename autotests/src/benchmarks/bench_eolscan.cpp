@@ -0,0 +1,144 @@
+#include <QApplication>
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QTemporaryDir>
+
+#include <katebuffer.h>
+#include <katedocument.h>
+#include <katetextbuffer.h>
+#include <katetextscanner.h>
+#include <kateglobal.h>
+
+#include <algorithm>
+#include <cstdio>
+
+static constexpr int lines = 1000000;
+
+using Kate::TextScanner::Implementation;
+
+static QString generateText(int linesInText, const QString &eol)
+{
+    QString text;
+    for (int i = 0; i < linesInText; ++i) {
+        text += QStringLiteral("This is a long long long sentence, number %1.").arg(i);
+        text += (eol.isEmpty() ? ((i % 3 == 0) ? QStringLiteral("\r\n") : (i % 3 == 1) ? QStringLiteral("\n") : QStringLiteral("\r")) : eol);
+    }
+    return text;
+}
+
+static const char *implementationName(Implementation implementation)
+{
+    switch (implementation) {
+    case Implementation::Scalar:
+        return "scalar";
+    case Implementation::SSE2:
+        return "sse2";
+    case Implementation::AVX2:
+        return "avx2";
+    }
+    return "unknown";
+}
+
+static double megaBytesPerSecond(qsizetype bytes, qint64 nsecs)
+{
+    return (double(bytes) / (1024.0 * 1024.0)) / (double(std::max<qint64>(nsecs, 1)) / 1e9);
+}
+
+static void benchmarkScanning(const char *name, const QString &text, int iterations)
+{
+    const qsizetype bytes = text.size() * sizeof(QChar);
+    for (const auto implementation : {Implementation::Scalar, Implementation::SSE2, Implementation::AVX2}) {
+        if (!Kate::TextScanner::isSupported(implementation)) {
+            continue;
+        }
+
+        // find line by line, like the loader does
+        QElapsedTimer timer;
+        timer.start();
+        qsizetype found = 0;
+        for (int i = 0; i < iterations; ++i) {
+            for (qsizetype pos = Kate::TextScanner::findLineTerminator(implementation, text.unicode(), 0, text.size()); pos < text.size();
+                 pos = Kate::TextScanner::findLineTerminator(implementation, text.unicode(), pos + 1, text.size())) {
+                ++found;
+            }
+        }
+        const qint64 findTime = timer.nsecsElapsed();
+
+        // count in bulk
+        timer.restart();
+        qsizetype counted = 0;
+        for (int i = 0; i < iterations; ++i) {
+            counted += Kate::TextScanner::countLineTerminators(implementation, text.unicode(), text.size());
+        }
+        const qint64 countTime = timer.nsecsElapsed();
+
+        printf("%-6s %-6s find: %8.1f MB/s (%lld terminators), count: %8.1f MB/s (%lld lines)\n",
+               name,
+               implementationName(implementation),
+               megaBytesPerSecond(bytes * iterations, findTime),
+               (long long)(found / iterations),
+               megaBytesPerSecond(bytes * iterations, countTime),
+               (long long)(counted / iterations));
+    }
+}
+
+static void benchmarkLoading(const char *name, const QString &text)
+{
+    QTemporaryDir dir;
+    const QString fileName = dir.path() + QStringLiteral("/bench.txt");
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return;
+    }
+    const QByteArray data = text.toUtf8();
+    file.write(data);
+    file.close();
+
+    KTextEditor::DocumentPrivate doc;
+    Kate::TextBuffer &buffer = doc.buffer();
+    buffer.setTextCodec(QStringLiteral("UTF-8"));
+    buffer.setFallbackTextCodec(QStringLiteral("UTF-8"));
+    bool encodingErrors = false;
+    bool tooLongLinesWrapped = false;
+    int longestLineLoaded = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    buffer.load(fileName, encodingErrors, tooLongLinesWrapped, longestLineLoaded, true);
+    printf("%-6s load:  %8.1f MB/s (%d lines)\n", name, megaBytesPerSecond(data.size(), timer.nsecsElapsed()), buffer.lines());
+}
+
+int main(int argc, char *argv[])
+{
+    QApplication app(argc, argv);
+
+    QCommandLineParser p;
+    p.setApplicationDescription(QStringLiteral("Performance benchmark for line terminator scanning"));
+    p.addHelpOption();
+    QCommandLineOption linesOpt(QStringLiteral("l"), QStringLiteral("Number of lines of text to scan"), QStringLiteral("lines"), QString::number(lines));
+    p.addOption(linesOpt);
+    QCommandLineOption iterOpt(QStringLiteral("i"), QStringLiteral("Number of iterations"), QStringLiteral("iters"), QStringLiteral("10"));
+    p.addOption(iterOpt);
+    p.process(app);
+
+    const int linesInText = std::max(1, p.value(linesOpt).toInt());
+    const int iterations = std::max(1, p.value(iterOpt).toInt());
+
+    KTextEditor::EditorPrivate::enableUnitTestMode();
+
+    const QString lf = generateText(linesInText, QStringLiteral("\n"));
+    const QString crlf = generateText(linesInText, QStringLiteral("\r\n"));
+    const QString mixed = generateText(linesInText, QString());
+
+    benchmarkScanning("lf", lf, iterations);
+    benchmarkScanning("crlf", crlf, iterations);
+    benchmarkScanning("mixed", mixed, iterations);
+
+    benchmarkLoading("lf", lf);
+    benchmarkLoading("crlf", crlf);
+    benchmarkLoading("mixed", mixed);
+
+    return 0;
+}
@@ -0,0 +1,179 @@
+/*
+    SPDX-FileCopyrightText: 2026 KTextEditor contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include <QCommandLineOption>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QSet>
+
+#include <KSyntaxHighlighting/Definition>
+#include <KSyntaxHighlighting/Repository>
+
+#include <katetextline.h>
+#include <spellcheck/prefixstore.h>
+
+#include <algorithm>
+#include <cstdio>
+
+static constexpr int lines = 100000;
+
+/**
+ * The hash based automaton KatePrefixStore used before, as reference.
+ */
+class HashPrefixStore
+{
+public:
+    void addPrefix(const QString &prefix)
+    {
+        unsigned long long state = 0;
+        for (const QChar c : prefix) {
+            auto &hash = m_transitionFunction[state];
+            auto it = hash.find(c.unicode());
+            if (it == hash.end()) {
+                state = ++m_lastAssignedState;
+                hash[c.unicode()] = qMakePair(1u, state);
+                continue;
+            }
+            ++it->first;
+            state = it->second;
+        }
+        m_acceptingStates.insert(state);
+    }
+
+    int prefixLength(const Kate::TextLine &line, int start) const
+    {
+        unsigned long long state = 0;
+        for (int i = start; i < line.length(); ++i) {
+            const auto &hash = m_transitionFunction[state];
+            const auto it = hash.find(line.at(i).unicode());
+            if (it == hash.end()) {
+                return 0;
+            }
+            state = it->second;
+            if (m_acceptingStates.contains(state)) {
+                return i + 1 - start;
+            }
+        }
+        return 0;
+    }
+
+private:
+    QHash<unsigned long long, QHash<unsigned short, QPair<unsigned int, unsigned long long>>> m_transitionFunction;
+    QSet<unsigned long long> m_acceptingStates;
+    unsigned long long m_lastAssignedState = 0;
+};
+
+static QStringList generateLatex(int linesInText)
+{
+    static const QStringList sentences = {
+        QStringLiteral("Die Schr\\\"odinger-Gleichung beschreibt die zeitliche Entwicklung eines Quantenzustands."),
+        QStringLiteral("Ein na\\\"{\\i}ver Ansatz f\\\"uhrt hier zu \\emph{gro\\ss{}en} Fehlern, siehe~\\cite{dirac1930}."),
+        QStringLiteral("\\section{\\'Etude des r\\'esultats} % commentaire \\`a propos de l'\\'equation"),
+        QStringLiteral("Let $f\\colon X \\to Y$ be continuous, then $f^{-1}(U)$ is open for every open $U \\subseteq Y$."),
+        QStringLiteral("\\item Se\\~nor Mu\\~noz visited K\\o{}benhavn and {\\AA}lesund in the summer."),
+    };
+    QStringList text;
+    text.reserve(linesInText);
+    for (int i = 0; i < linesInText; ++i) {
+        text.push_back(sentences.at(i % sentences.size()));
+    }
+    return text;
+}
+
+static double megaBytesPerSecond(qsizetype bytes, qint64 nsecs)
+{
+    return (double(bytes) / (1024.0 * 1024.0)) / (double(std::max<qint64>(nsecs, 1)) / 1e9);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QCommandLineParser p;
+    p.setApplicationDescription(QStringLiteral("Performance benchmark for the character encodings prefix store"));
+    p.addHelpOption();
+    QCommandLineOption linesOpt(QStringLiteral("l"), QStringLiteral("Number of generated lines of LaTeX"), QStringLiteral("lines"), QString::number(lines));
+    p.addOption(linesOpt);
+    QCommandLineOption iterOpt(QStringLiteral("i"), QStringLiteral("Number of iterations"), QStringLiteral("iters"), QStringLiteral("10"));
+    p.addOption(iterOpt);
+    QCommandLineOption fileOpt(QStringLiteral("f"), QStringLiteral("LaTeX document to scan instead of generated text"), QStringLiteral("file"));
+    p.addOption(fileOpt);
+    p.process(app);
+
+    const int iterations = std::max(1, p.value(iterOpt).toInt());
+
+    QStringList text;
+    if (p.isSet(fileOpt)) {
+        QFile file(p.value(fileOpt));
+        if (!file.open(QIODevice::ReadOnly)) {
+            fprintf(stderr, "cannot open %s\n", qPrintable(p.value(fileOpt)));
+            return 1;
+        }
+        text = QString::fromUtf8(file.readAll()).split(QLatin1Char('\n'));
+    } else {
+        text = generateLatex(std::max(1, p.value(linesOpt).toInt()));
+    }
+
+    std::vector<Kate::TextLine> textLines;
+    qsizetype bytes = 0;
+    for (const QString &line : std::as_const(text)) {
+        textLines.emplace_back(line);
+        bytes += line.size() * sizeof(QChar);
+    }
+    bytes *= iterations;
+
+    // the same encodings the LaTeX highlighting feeds into its prefix store
+    KSyntaxHighlighting::Repository repository;
+    const auto encodings = repository.definitionForName(QStringLiteral("LaTeX")).characterEncodings();
+    HashPrefixStore hashStore;
+    KatePrefixStore store;
+    for (const auto &encoding : encodings) {
+        hashStore.addPrefix(encoding.second);
+        store.addPrefix(encoding.second);
+    }
+    printf("%lld encodings, %lld lines\n", (long long)encodings.size(), (long long)textLines.size());
+
+    // column by column, like the callers did before
+    QElapsedTimer timer;
+    timer.start();
+    qsizetype hashMatches = 0;
+    for (int i = 0; i < iterations; ++i) {
+        for (const auto &line : textLines) {
+            for (int column = 0; column < line.length(); ++column) {
+                hashMatches += hashStore.prefixLength(line, column) > 0;
+            }
+        }
+    }
+    printf("hash   per column: %8.1f MB/s (%lld matches)\n", megaBytesPerSecond(bytes, timer.nsecsElapsed()), (long long)(hashMatches / iterations));
+
+    timer.restart();
+    qsizetype tableMatches = 0;
+    for (int i = 0; i < iterations; ++i) {
+        for (const auto &line : textLines) {
+            for (int column = 0; column < line.length(); ++column) {
+                tableMatches += !store.findPrefix(line, column).isEmpty();
+            }
+        }
+    }
+    printf("table  per column: %8.1f MB/s (%lld matches)\n", megaBytesPerSecond(bytes, timer.nsecsElapsed()), (long long)(tableMatches / iterations));
+
+    timer.restart();
+    qsizetype passMatches = 0;
+    for (int i = 0; i < iterations; ++i) {
+        for (const auto &line : textLines) {
+            const auto lengths = store.prefixLengths(line);
+            passMatches += std::count_if(lengths.begin(), lengths.end(), [](int length) {
+                return length > 0;
+            });
+        }
+    }
+    printf("table  one pass:   %8.1f MB/s (%lld matches)\n", megaBytesPerSecond(bytes, timer.nsecsElapsed()), (long long)(passMatches / iterations));
+
+    return (hashMatches == tableMatches && tableMatches == passMatches) ? 0 : 1;
+}
@@ -1,15 +1,78 @@
 #include <QApplication>
 #include <QCommandLineOption>
 #include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QRegularExpression>
 
 #include <KMainWindow>
+#include <katebuffer.h>
 #include <kateconfig.h>
 #include <katedocument.h>
+#include <kateplaintextsearch.h>
 #include <katesearchbar.h>
 #include <kateview.h>
 
+#include <cstdio>
+
 static constexpr int lines = 100000;
 
+// search all lines like KatePlainTextSearch did before: copy each line, QString::indexOf() or a \b...\b regex for whole words
+static qsizetype searchOld(const KTextEditor::DocumentPrivate &doc, const QString &pattern, Qt::CaseSensitivity caseSensitivity, bool wholeWords)
+{
+    const QRegularExpression regex(QStringLiteral("\\b%1\\b").arg(QRegularExpression::escape(pattern)),
+                                   QRegularExpression::UseUnicodePropertiesOption
+                                       | (caseSensitivity == Qt::CaseInsensitive ? QRegularExpression::CaseInsensitiveOption : QRegularExpression::NoPatternOption));
+    qsizetype found = 0;
+    for (int line = 0; line < doc.lines(); ++line) {
+        const QString text = doc.line(line);
+        if (wholeWords) {
+            for (auto it = regex.globalMatch(text); it.hasNext(); it.next()) {
+                ++found;
+            }
+        } else {
+            for (qsizetype pos = text.indexOf(pattern, 0, caseSensitivity); pos >= 0; pos = text.indexOf(pattern, pos + pattern.size(), caseSensitivity)) {
+                ++found;
+            }
+        }
+    }
+    return found;
+}
+
+// search all lines with a precompiled KatePlainTextMatcher, reading the lines by reference
+static qsizetype searchNew(const KTextEditor::DocumentPrivate &doc, const QString &pattern, Qt::CaseSensitivity caseSensitivity, bool wholeWords)
+{
+    const KatePlainTextMatcher matcher(pattern, caseSensitivity, wholeWords);
+    qsizetype found = 0;
+    for (int line = 0; line < doc.lines(); ++line) {
+        const QString &text = doc.buffer().lineText(line);
+        for (qsizetype pos = matcher.indexIn(text, 0, text.size()); pos >= 0; pos = matcher.indexIn(text, pos + matcher.length(), text.size())) {
+            ++found;
+        }
+    }
+    return found;
+}
+
+static void benchmarkPlainText(const KTextEditor::DocumentPrivate &doc, const QString &pattern, Qt::CaseSensitivity caseSensitivity, bool wholeWords)
+{
+    QElapsedTimer timer;
+    timer.start();
+    const qsizetype foundOld = searchOld(doc, pattern, caseSensitivity, wholeWords);
+    const qint64 oldTime = timer.nsecsElapsed();
+
+    timer.restart();
+    const qsizetype foundNew = searchNew(doc, pattern, caseSensitivity, wholeWords);
+    const qint64 newTime = timer.nsecsElapsed();
+
+    printf("%-12s %-16s %-11s old: %8.2f ms (%lld matches), new: %8.2f ms (%lld matches)\n",
+           qPrintable(pattern),
+           caseSensitivity == Qt::CaseSensitive ? "case sensitive" : "case insensitive",
+           wholeWords ? "whole words" : "",
+           oldTime / 1e6,
+           (long long)foundOld,
+           newTime / 1e6,
+           (long long)foundNew);
+}
+
 int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
@@ -45,6 +108,14 @@ int main(int argc, char *argv[])
     }
     doc.setText(l);
 
+    // compare the plain text search kernels
+    for (const auto &pattern : {QStringLiteral("long"), QStringLiteral("sentence"), QStringLiteral("long long sentence")}) {
+        for (const bool wholeWords : {false, true}) {
+            benchmarkPlainText(doc, pattern, Qt::CaseSensitive, wholeWords);
+            benchmarkPlainText(doc, pattern, Qt::CaseInsensitive, wholeWords);
+        }
+    }
+
     QObject::connect(&bar, &KateSearchBar::findOrReplaceAllFinished, [&w]() {
         w->close();
     });
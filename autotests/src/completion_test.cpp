@@ -543,6 +543,46 @@ void CompletionTest::testAsyncMatching()
     QCOMPARE(model->filteredItemCount(), (uint)1);
 }
 
+void CompletionTest::testNarrowingLargeList()
+{
+    KateCompletionModel *model = m_view->completionWidget()->model();
+
+    auto asyncModel = new AsyncCodeCompletionTestModel(m_view, QString());
+
+    m_view->document()->setText(QStringLiteral("matched"));
+
+    m_view->userInvokedCompletion();
+    QApplication::processEvents();
+
+    // large enough to be filtered in parallel chunks
+    QStringList items;
+    for (int i = 0; i < 20000; ++i) {
+        items << (i % 2 ? QStringLiteral("FooItem_%1") : QStringLiteral("bar_item%1")).arg(i);
+    }
+    asyncModel->setItems(items);
+
+    // typing more characters filters the items of the last result
+    const QString typed = QStringLiteral("item_12");
+    QList<uint> narrowedCounts;
+    for (int length = 1; length <= typed.size(); ++length) {
+        QMap<KTextEditor::CodeCompletionModel *, QString> currentMatch;
+        currentMatch.insert(asyncModel, typed.left(length));
+        model->setCurrentCompletion(currentMatch);
+        narrowedCounts << model->filteredItemCount();
+    }
+    QVERIFY(narrowedCounts.last() > 0);
+    QVERIFY(narrowedCounts.last() < narrowedCounts.first());
+
+    // filtering all items from scratch must give the same results
+    for (int length = 1; length <= typed.size(); ++length) {
+        QMap<KTextEditor::CodeCompletionModel *, QString> currentMatch;
+        currentMatch.insert(asyncModel, typed.left(length));
+        model->setCurrentCompletion({});
+        model->setCurrentCompletion(currentMatch);
+        QCOMPARE(model->filteredItemCount(), narrowedCounts[length - 1]);
+    }
+}
+
 void CompletionTest::benchCompletionModel()
 {
     const int testFactor = 1;
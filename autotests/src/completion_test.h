@@ -51,6 +51,7 @@ private Q_SLOTS:
     void testJumpToListBottomAfterCursorUpWhileAtTop();
     void testAbbrevAndContainsMatching();
     void testAsyncMatching();
+    void testNarrowingLargeList();
     void testAbbreviationEngine();
     void testAutoCompletionPreselectFirst();
     void testTabCompletion();
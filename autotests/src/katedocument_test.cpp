@@ -8,6 +8,7 @@
 #include "katedocument_test.h"
 #include "moc_katedocument_test.cpp"
 
+#include <katebuffer.h>
 #include <kateconfig.h>
 #include <katedocument.h>
 #include <kateglobal.h>
@@ -972,6 +973,30 @@ void KateDocumentTest::testCursorToOffset()
         QCOMPARE(doc.cursorToOffset(doc.documentEnd()), 7 + 128);
         QCOMPARE(doc.offsetToCursor(7 + 128), doc.documentEnd());
     }
+
+    // Many blocks, edits that split and merge blocks
+    {
+        QStringList lines;
+        for (int i = 0; i < 1000; ++i) {
+            lines.append(QString(i % 17, QLatin1Char('x')));
+        }
+        doc.setText(lines);
+        doc.insertText({500, 0}, QStringLiteral("a\nbb\nccc\n"));
+        doc.removeText(KTextEditor::Range(100, 0, 300, 0));
+        doc.insertText({10, 3}, QStringLiteral("yyy"));
+
+        qsizetype offset = 0;
+        qsizetype characters = 0;
+        for (int line = 0; line < doc.lines(); ++line) {
+            QCOMPARE(doc.cursorToOffset({line, 0}), offset);
+            QCOMPARE(doc.offsetToCursor(offset), Cursor(line, 0));
+            QCOMPARE(doc.offsetToCursor(offset + doc.lineLength(line)), Cursor(line, doc.lineLength(line)));
+            offset += doc.lineLength(line) + 1;
+            characters += doc.lineLength(line);
+        }
+        QCOMPARE(doc.totalCharacters(), characters);
+        QCOMPARE(doc.offsetToCursor(offset), KTextEditor::Cursor::invalid());
+    }
 }
 
 void KateDocumentTest::testBug329247()
@@ -1052,3 +1077,134 @@ void KateDocumentTest::testBugTextInsertedRange()
     QCOMPARE(doc.text(), QStringLiteral("01234567\n01234567\n\n\n\n\n          x\nxxxx"));
     QVERIFY(doc.lines() == 8);
 }
+
+static QList<int> attributeValues(const Kate::TextLine &line)
+{
+    QList<int> values;
+    for (const auto &attribute : line.attributesList()) {
+        values << attribute.offset << attribute.length << attribute.attributeValue;
+    }
+    return values;
+}
+
+void KateDocumentTest::testAsyncHighlighting()
+{
+    // a comment spanning the whole document, the state must survive the batches
+    QString text = QStringLiteral("/*\n");
+    for (int i = 0; i < 20000; ++i) {
+        text += QStringLiteral("int a = %1;\n").arg(i);
+    }
+    text += QStringLiteral("*/\nint b = 0;");
+
+    KTextEditor::DocumentPrivate doc;
+    doc.setText(text);
+    doc.setHighlightingMode(QStringLiteral("C++"));
+    KateBuffer &buffer = doc.buffer();
+
+    // far away line goes to the background job
+    const int lastLine = doc.lines() - 1;
+    QSignalSpy spy(&buffer, &KateBuffer::tagLines);
+    QVERIFY(!buffer.ensureHighlightedAsync(lastLine));
+    QTRY_VERIFY_WITH_TIMEOUT(buffer.ensureHighlightedAsync(lastLine), 20000);
+    QVERIFY(spy.count() > 1);
+    const auto asyncComment = attributeValues(buffer.plainLine(lastLine - 2));
+    const auto asyncCode = attributeValues(buffer.plainLine(lastLine));
+    QVERIFY(!asyncCode.isEmpty());
+
+    // same result as synchronous highlighting
+    buffer.invalidateHighlighting();
+    buffer.ensureHighlighted(lastLine);
+    QCOMPARE(attributeValues(buffer.plainLine(lastLine - 2)), asyncComment);
+    QCOMPARE(attributeValues(buffer.plainLine(lastLine)), asyncCode);
+
+    // edits drop running jobs, the job restarts and still ends with the right result
+    buffer.invalidateHighlighting();
+    QVERIFY(!buffer.ensureHighlightedAsync(lastLine));
+    doc.insertText(KTextEditor::Cursor(0, 0), QStringLiteral("int c = 0; "));
+    QTRY_VERIFY_WITH_TIMEOUT(buffer.ensureHighlightedAsync(lastLine), 20000);
+    QCOMPARE(attributeValues(buffer.plainLine(lastLine)), asyncCode);
+}
+
+void KateDocumentTest::testConcurrentHighlighting()
+{
+    // both documents share the definition, its rules and keyword lists, run this with the thread sanitizer
+    QString text;
+    for (int i = 0; i < 20000; ++i) {
+        text += QStringLiteral("if (a) { return static_cast<int>(%1); } // comment %1\n").arg(i);
+    }
+
+    KTextEditor::DocumentPrivate background;
+    background.setText(text);
+    background.setHighlightingMode(QStringLiteral("C++"));
+    KTextEditor::DocumentPrivate foreground;
+    foreground.setText(text);
+    foreground.setHighlightingMode(QStringLiteral("C++"));
+
+    // highlight the same lines on the GUI thread over and over while the background job runs
+    const int lastLine = background.lines() - 1;
+    QVERIFY(!background.buffer().ensureHighlightedAsync(lastLine));
+    int rounds = 0;
+    while (!background.buffer().ensureHighlightedAsync(lastLine)) {
+        foreground.buffer().invalidateHighlighting();
+        foreground.buffer().ensureHighlighted(500);
+        QCoreApplication::processEvents();
+        QVERIFY(++rounds < 100000);
+    }
+
+    // both got the same result
+    foreground.buffer().ensureHighlighted(lastLine);
+    for (int line = 0; line <= lastLine; line += 97) {
+        QCOMPARE(attributeValues(background.buffer().plainLine(line)), attributeValues(foreground.buffer().plainLine(line)));
+    }
+}
+
+void KateDocumentTest::testHighlightingConvergence()
+{
+    QString text = QStringLiteral("/*\n");
+    for (int i = 0; i < 20000; ++i) {
+        text += QStringLiteral("int a = %1;\n").arg(i);
+    }
+    text += QStringLiteral("*/\nint b = 0;");
+
+    KTextEditor::DocumentPrivate doc;
+    doc.setText(text);
+    doc.setHighlightingMode(QStringLiteral("C++"));
+    KateBuffer &buffer = doc.buffer();
+    const int lastLine = doc.lines() - 1;
+    buffer.ensureHighlighted(lastLine);
+    const auto comment = attributeValues(buffer.plainLine(lastLine - 2));
+    const auto code = attributeValues(buffer.plainLine(lastLine));
+
+    // invalidation keeps the old results, the first line reproduces them
+    buffer.invalidateHighlighting();
+    buffer.ensureHighlighted(0, 0);
+    QVERIFY(buffer.ensureHighlightedAsync(lastLine));
+    QCOMPARE(attributeValues(buffer.plainLine(lastLine)), code);
+
+    // switching back and forth only re-highlights what the other mode overwrote
+    doc.setHighlightingMode(QStringLiteral("Python"));
+    buffer.ensureHighlighted(100, 0);
+    doc.setHighlightingMode(QStringLiteral("C++"));
+    buffer.ensureHighlighted(200, 0);
+    QVERIFY(buffer.ensureHighlightedAsync(lastLine));
+    QCOMPARE(attributeValues(buffer.plainLine(lastLine - 2)), comment);
+    QCOMPARE(attributeValues(buffer.plainLine(lastLine)), code);
+
+    // closing the comment early changes the states until the old end of the comment
+    doc.insertText(KTextEditor::Cursor(1, 0), QStringLiteral("*/"));
+    buffer.ensureHighlighted(lastLine);
+    QVERIFY(attributeValues(buffer.plainLine(lastLine - 2)) != comment);
+
+    // opening it again converges with the results from before the edit
+    doc.removeText(KTextEditor::Range(1, 0, 1, 2));
+    buffer.ensureHighlighted(lastLine);
+    QCOMPARE(attributeValues(buffer.plainLine(lastLine - 2)), comment);
+    QCOMPARE(attributeValues(buffer.plainLine(lastLine)), code);
+
+    // edits behind the highlighted area are never taken as converged
+    buffer.invalidateHighlighting();
+    doc.insertText(KTextEditor::Cursor(lastLine - 2, 0), QStringLiteral("int x; "));
+    buffer.ensureHighlighted(lastLine);
+    QVERIFY(attributeValues(buffer.plainLine(lastLine - 2)) != comment);
+    QCOMPARE(attributeValues(buffer.plainLine(lastLine)), code);
+}
@@ -10,9 +10,16 @@
 #include "katebuffer.h"
 #include "katedocument.h"
 #include "katetextfolding.h"
+#include "katetextscanner.h"
 #include <kateglobal.h>
 #include <ktexteditor/movingcursor.h>
 
+#include <QCryptographicHash>
+#include <QFileInfo>
+
+#include <memory>
+#include <vector>
+
 QTEST_MAIN(KateTextBufferTest)
 
 KateTextBufferTest::KateTextBufferTest()
@@ -187,6 +194,99 @@ void KateTextBufferTest::cursorTest()
     QVERIFY(lastBufferContent == buffer.text());
 }
 
+void KateTextBufferTest::lazyStartLines()
+{
+    // construct a buffer spanning many blocks
+    KTextEditor::DocumentPrivate doc;
+    Kate::TextBuffer &buffer = doc.buffer();
+    buffer.startEditing();
+    for (int i = 0; i < 2000; ++i) {
+        buffer.insertText(KTextEditor::Cursor(i, 0), QString::number(i));
+        if (i < 1999) {
+            buffer.wrapLine(KTextEditor::Cursor(i, QString::number(i).size()));
+        }
+    }
+    buffer.finishEditing();
+    QCOMPARE(buffer.lines(), 2000);
+
+    // cursors spread over all blocks
+    std::vector<std::unique_ptr<KTextEditor::MovingCursor>> cursors;
+    for (int i = 0; i < 2000; i += 37) {
+        cursors.emplace_back(doc.newMovingCursor(KTextEditor::Cursor(i, 0)));
+    }
+
+    // insert empty lines at the top, this invalidates the start lines of all following blocks
+    // interleave with accesses near the end, to force lazy fixing in between
+    buffer.startEditing();
+    for (int i = 0; i < 300; ++i) {
+        buffer.wrapLine(KTextEditor::Cursor(i % 3, buffer.lineLength(i % 3)));
+        QCOMPARE(buffer.line(buffer.lines() - 1).text(), QStringLiteral("1999"));
+    }
+    buffer.finishEditing();
+    QCOMPARE(buffer.lines(), 2300);
+
+    for (size_t i = 0; i < cursors.size(); ++i) {
+        QCOMPARE(cursors[i]->line(), int(i) * 37 + (i == 0 ? 0 : 300));
+        QCOMPARE(buffer.line(cursors[i]->line()).text(), QString::number(int(i) * 37));
+    }
+
+    // remove them again, merges blocks
+    buffer.startEditing();
+    for (int i = 0; i < 300; ++i) {
+        buffer.unwrapLine(1);
+    }
+    buffer.finishEditing();
+    QCOMPARE(buffer.lines(), 2000);
+
+    for (int i = 0; i < 2000; ++i) {
+        QCOMPARE(buffer.line(i).text(), QString::number(i));
+    }
+    for (size_t i = 0; i < cursors.size(); ++i) {
+        QCOMPARE(cursors[i]->line(), int(i) * 37);
+    }
+}
+
+void KateTextBufferTest::splitBlockStartLines()
+{
+    KTextEditor::DocumentPrivate doc;
+    Kate::TextBuffer &buffer = doc.buffer();
+    buffer.startEditing();
+    for (int i = 0; i < 200; ++i) {
+        buffer.insertText(KTextEditor::Cursor(i, 0), QString::number(i));
+        if (i < 199) {
+            buffer.wrapLine(KTextEditor::Cursor(i, QString::number(i).size()));
+        }
+    }
+    buffer.finishEditing();
+
+    // cursors behind the block that will be split
+    std::vector<std::unique_ptr<KTextEditor::MovingCursor>> cursors;
+    for (int i = 101; i < 200; ++i) {
+        cursors.emplace_back(doc.newMovingCursor(KTextEditor::Cursor(i, 1)));
+    }
+
+    // grow the block containing line 100 until it is split
+    buffer.startEditing();
+    for (int i = 0; i < 2 * Kate::BufferBlockSize; ++i) {
+        buffer.wrapLine(KTextEditor::Cursor(100, 3));
+    }
+    buffer.finishEditing();
+
+    // edit above the split-off block, its start line must follow
+    buffer.startEditing();
+    for (int i = 0; i < 10; ++i) {
+        buffer.wrapLine(KTextEditor::Cursor(0, 1));
+    }
+    buffer.finishEditing();
+    QCOMPARE(buffer.lines(), 200 + 2 * Kate::BufferBlockSize + 10);
+
+    for (size_t i = 0; i < cursors.size(); ++i) {
+        const int line = 101 + int(i);
+        QCOMPARE(cursors[i]->line(), line + 2 * Kate::BufferBlockSize + 10);
+        QCOMPARE(buffer.line(cursors[i]->line()).text(), QString::number(line));
+    }
+}
+
 void KateTextBufferTest::foldingTest()
 {
     // construct an empty text buffer & folding info
@@ -407,6 +507,63 @@ void KateTextBufferTest::nestedFoldingTest()
     QVERIFY(folding.unfoldRange(1));
 }
 
+static void verifyLineMapping(const Kate::TextFolding &folding, int lines)
+{
+    // reference: walk all lines, hidden lines map to the visible line in front of them
+    int visibleLine = -1;
+    for (int line = 0; line < lines; ++line) {
+        if (folding.isLineVisible(line)) {
+            ++visibleLine;
+            QCOMPARE(folding.visibleLineToLine(visibleLine), line);
+        }
+        QCOMPARE(folding.lineToVisibleLine(line), visibleLine);
+    }
+    QCOMPARE(folding.visibleLines(), visibleLine + 1);
+}
+
+void KateTextBufferTest::manyFoldsLineMappingTest()
+{
+    KTextEditor::DocumentPrivate doc;
+    KateBuffer &buffer = doc.buffer();
+    Kate::TextFolding folding(buffer);
+
+    buffer.startEditing();
+    for (int i = 0; i < 3000; ++i) {
+        buffer.insertText(KTextEditor::Cursor(i, 0), QStringLiteral("1234567890"));
+        if (i < 2999) {
+            buffer.wrapLine(KTextEditor::Cursor(i, 10));
+        }
+    }
+    buffer.finishEditing();
+
+    // fold lots of small regions
+    std::vector<qint64> ids;
+    for (int i = 0; i < 500; ++i) {
+        ids.push_back(folding.newFoldingRange(KTextEditor::Range(i * 6, 0, i * 6 + 3, 0), Kate::TextFolding::Folded));
+        QVERIFY(ids.back() >= 0);
+    }
+    verifyLineMapping(folding, buffer.lines());
+
+    // unfold some of them in the middle and at the start
+    for (int i = 0; i < 500; i += 7) {
+        QVERIFY(folding.unfoldRange(ids[i]));
+    }
+    verifyLineMapping(folding, buffer.lines());
+
+    // add lines inside and outside of folded regions
+    buffer.startEditing();
+    buffer.wrapLine(KTextEditor::Cursor(61, 5));
+    buffer.wrapLine(KTextEditor::Cursor(1000, 5));
+    buffer.finishEditing();
+    verifyLineMapping(folding, buffer.lines());
+
+    // fold them again
+    for (int i = 0; i < 500; i += 7) {
+        QVERIFY(folding.foldRange(ids[i]));
+    }
+    verifyLineMapping(folding, buffer.lines());
+}
+
 void KateTextBufferTest::saveFileInUnwritableFolder()
 {
     // create temp dir and get file name inside
@@ -548,6 +705,186 @@ void KateTextBufferTest::lineLengthLimit()
     }
 }
 
+void KateTextBufferTest::mappedLoad()
+{
+    // create temp dir and get file name inside
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString file_path = dir.path() + QLatin1String("/foo");
+
+    // create a file large enough for the memory mapped parallel loader, with BOM, multi-byte chars and dos line endings
+    const int lineCount = 400000;
+    QByteArray content("\xEF\xBB\xBF");
+    for (int i = 0; i < lineCount; ++i) {
+        content += "line " + QByteArray::number(i) + " \xC3\xA4\xC3\xB6\xC3\xBC \xE2\x82\xAC some more text to fill the line\r\n";
+    }
+    QVERIFY(content.size() > 16 * 1024 * 1024);
+    {
+        QFile f(file_path);
+        QVERIFY(f.open(QIODevice::WriteOnly | QIODevice::Truncate));
+        f.write(content);
+        QVERIFY(f.flush());
+    }
+
+    // writable files are streamed by the TextLoader, they might get truncated while mapped, only read-only ones get mapped
+    for (const bool readOnly : {false, true}) {
+        if (readOnly) {
+            QVERIFY(QFile::setPermissions(file_path, QFileDevice::ReadOwner | QFileDevice::ReadUser | QFileDevice::ReadGroup | QFileDevice::ReadOther));
+        }
+
+        KTextEditor::DocumentPrivate doc;
+        Kate::TextBuffer buffer(&doc, true);
+        buffer.setTextCodec(QStringLiteral("UTF-8"));
+        buffer.setFallbackTextCodec(QStringLiteral("UTF-8"));
+        bool encodingErrors = false;
+        bool tooLongLinesWrapped = false;
+        int longestLineLoaded = 0;
+        QVERIFY(buffer.load(file_path, encodingErrors, tooLongLinesWrapped, longestLineLoaded, true));
+        QVERIFY(!encodingErrors);
+        QVERIFY(!tooLongLinesWrapped);
+        QVERIFY(buffer.generateByteOrderMark());
+        QCOMPARE(buffer.endOfLineMode(), Kate::TextBuffer::eolDos);
+
+        // trailing newline results in one more empty line
+        QCOMPARE(buffer.lines(), lineCount + 1);
+        for (int i = 0; i < lineCount; i += 997) {
+            QCOMPARE(buffer.line(i).text(), QStringLiteral("line %1 äöü € some more text to fill the line").arg(i));
+        }
+        QCOMPARE(buffer.line(lineCount - 1).text(), QStringLiteral("line %1 äöü € some more text to fill the line").arg(lineCount - 1));
+        QCOMPARE(buffer.line(lineCount).text(), QString());
+
+        // git compatible checksum of the file
+        QCryptographicHash digest(QCryptographicHash::Sha1);
+        digest.addData(QByteArray("blob " + QByteArray::number(content.size()) + '\0'));
+        digest.addData(content);
+        QCOMPARE(buffer.digest(), digest.result());
+    }
+}
+
+void KateTextBufferTest::lineTerminatorScanning()
+{
+    using Kate::TextScanner::Implementation;
+
+    // text with all kind of line terminators at different alignments
+    QString text;
+    for (int i = 0; i < 200; ++i) {
+        text += QString(i % 37, QLatin1Char('x'));
+        switch (i % 4) {
+        case 0:
+            text += QLatin1Char('\n');
+            break;
+        case 1:
+            text += QStringLiteral("\r\n");
+            break;
+        case 2:
+            text += QLatin1Char('\r');
+            break;
+        case 3:
+            text += QChar::LineSeparator;
+            break;
+        }
+    }
+
+    // scalar reference
+    QCOMPARE(Kate::TextScanner::countLineTerminators(Implementation::Scalar, text.unicode(), text.size()), qsizetype(200));
+    QCOMPARE(Kate::TextScanner::findLineTerminator(Implementation::Scalar, text.unicode(), 0, text.size()), qsizetype(0));
+    QCOMPARE(Kate::TextScanner::findLineTerminator(Implementation::Scalar, text.unicode(), 1, text.size()), qsizetype(2));
+
+    // all vectorized variants must match the scalar one
+    for (const auto implementation : {Implementation::SSE2, Implementation::AVX2}) {
+        if (!Kate::TextScanner::isSupported(implementation)) {
+            continue;
+        }
+
+        for (qsizetype size = 0; size <= text.size(); ++size) {
+            QCOMPARE(Kate::TextScanner::countLineTerminators(implementation, text.unicode(), size),
+                     Kate::TextScanner::countLineTerminators(Implementation::Scalar, text.unicode(), size));
+        }
+
+        for (qsizetype from = 0; from <= text.size(); ++from) {
+            QCOMPARE(Kate::TextScanner::findLineTerminator(implementation, text.unicode(), from, text.size()),
+                     Kate::TextScanner::findLineTerminator(Implementation::Scalar, text.unicode(), from, text.size()));
+        }
+    }
+}
+
+void KateTextBufferTest::saveDigest()
+{
+    // create temp dir and get file name inside
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString file_path = dir.path() + QLatin1String("/foo");
+
+    KTextEditor::DocumentPrivate doc;
+    Kate::TextBuffer buffer(&doc);
+    buffer.setTextCodec(QStringLiteral("UTF-16"));
+    buffer.setFallbackTextCodec(QStringLiteral("UTF-8"));
+    buffer.setEndOfLineMode(Kate::TextBuffer::eolDos);
+    buffer.startEditing();
+    buffer.insertText(KTextEditor::Cursor(0, 0), QStringLiteral("first line äöü"));
+    buffer.wrapLine(KTextEditor::Cursor(0, 5));
+    buffer.wrapLine(KTextEditor::Cursor(1, 0));
+    buffer.finishEditing();
+    QVERIFY(buffer.generateByteOrderMark());
+    QVERIFY(buffer.save(file_path));
+
+    // the checksum computed during writing must match the one of the file on disk
+    QFile f(file_path);
+    QVERIFY(f.open(QIODevice::ReadOnly));
+    const QByteArray content = f.readAll();
+    QCryptographicHash digest(QCryptographicHash::Sha1);
+    digest.addData(QByteArray("blob " + QByteArray::number(content.size()) + '\0'));
+    digest.addData(content);
+    QCOMPARE(buffer.digest(), digest.result());
+}
+
+void KateTextBufferTest::saveCompressed()
+{
+    // create temp dir and get file name inside
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString file_path = dir.path() + QLatin1String("/foo.gz");
+
+    // gzip compressed "first line\nsecond line\n"
+    {
+        QFile f(file_path);
+        QVERIFY(f.open(QIODevice::WriteOnly));
+        f.write(QByteArray("\x1f\x8b\x08\x00\x00\x00\x00\x00\x02\x03\x4b\xcb\x2c\x2a\x2e\x51\xc8\xc9\xcc\x4b\xe5\x2a\x4e\x4d\xce\xcf\x4b\x81\xb0\x01\x2c\x5a\x45\x5d\x17\x00\x00\x00", 38));
+    }
+
+    KTextEditor::DocumentPrivate doc;
+    Kate::TextBuffer buffer(&doc);
+    buffer.setTextCodec(QStringLiteral("UTF-8"));
+    buffer.setFallbackTextCodec(QStringLiteral("UTF-8"));
+    bool encodingErrors = false;
+    bool tooLongLinesWrapped = false;
+    int longestLineLoaded = 0;
+    QVERIFY(buffer.load(file_path, encodingErrors, tooLongLinesWrapped, longestLineLoaded, true));
+    QCOMPARE(buffer.lines(), 3);
+    QCOMPARE(buffer.line(1).text(), QStringLiteral("second line"));
+
+    buffer.startEditing();
+    buffer.insertText(KTextEditor::Cursor(0, 0), QStringLiteral("changed "));
+    buffer.finishEditing();
+    QVERIFY(buffer.save(file_path));
+
+    // the checksum covers the compressed data on disk
+    QFile f(file_path);
+    QVERIFY(f.open(QIODevice::ReadOnly));
+    const QByteArray content = f.readAll();
+    QVERIFY(content.startsWith("\x1f\x8b"));
+    QCryptographicHash digest(QCryptographicHash::Sha1);
+    digest.addData(QByteArray("blob " + QByteArray::number(content.size()) + '\0'));
+    digest.addData(content);
+    QCOMPARE(buffer.digest(), digest.result());
+
+    // a full disk must fail the save and keep the checksum of the last successful one
+    if (QFileInfo::exists(QStringLiteral("/dev/full"))) {
+        QVERIFY(!buffer.save(QStringLiteral("/dev/full")));
+        QCOMPARE(buffer.digest(), digest.result());
+    }
+}
+
 #if HAVE_KAUTH
 void KateTextBufferTest::saveFileWithElevatedPrivileges()
 {
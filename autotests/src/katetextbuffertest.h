@@ -29,8 +29,15 @@ private Q_SLOTS:
     void cursorTest();
     void foldingTest();
     void nestedFoldingTest();
+    void manyFoldsLineMappingTest();
     void saveFileInUnwritableFolder();
     void lineLengthLimit();
+    void mappedLoad();
+    void lineTerminatorScanning();
+    void saveDigest();
+    void saveCompressed();
+    void lazyStartLines();
+    void splitBlockStartLines();
 
 #if HAVE_KAUTH
     void saveFileWithElevatedPrivileges();
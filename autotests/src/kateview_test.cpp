@@ -11,13 +11,16 @@
 #include <katebuffer.h>
 #include <kateconfig.h>
 #include <katedocument.h>
+#include <kateshapedlayoutcache.h>
 #include <kateglobal.h>
 #include <kateview.h>
+#include <kateviewhelpers.h>
 #include <kateviewinternal.h>
 #include <ktexteditor/message.h>
 #include <ktexteditor/movingcursor.h>
 
 #include <QScrollBar>
+#include <QTextLayout>
 #include <QTemporaryFile>
 #include <QtTestWidgets>
 
@@ -95,6 +98,90 @@ void KateViewTest::testCursorToCoordinates()
     view->cursorToCoordinate(Cursor(-1, 0));
 }
 
+void KateViewTest::testLayoutsAfterEditingTransaction()
+{
+    KTextEditor::DocumentPrivate doc(false, false);
+    QStringList lines;
+    for (int i = 0; i < 40; ++i) {
+        lines.push_back(QString(i % 13 + 1, QLatin1Char('x')));
+    }
+    doc.setText(lines);
+
+    KTextEditor::ViewPrivate *view = new KTextEditor::ViewPrivate(&doc, nullptr);
+    view->resize(800, 600);
+    view->show();
+
+    // lay out all visible lines
+    for (int line = 0; line < doc.lines(); ++line) {
+        view->cursorToCoordinate(Cursor(line, doc.lineLength(line)));
+    }
+
+    // a mix of edits in one transaction, the layout cache applies them at once at the end
+    doc.editStart();
+    for (int i = 0; i < 30; ++i) {
+        const int line = (i * 7) % (doc.lines() - 1);
+        switch (i % 4) {
+        case 0:
+            doc.editWrapLine(line, std::min(2, doc.lineLength(line)));
+            break;
+        case 1:
+            doc.editUnWrapLine(line);
+            break;
+        case 2:
+            doc.editInsertText(line, 0, QStringLiteral("yyy"));
+            break;
+        case 3:
+            doc.editRemoveText(line, 0, 1);
+            break;
+        }
+    }
+    doc.editEnd();
+
+    // a new view lays out everything from scratch, both must agree
+    KTextEditor::ViewPrivate *freshView = new KTextEditor::ViewPrivate(&doc, nullptr);
+    freshView->resize(800, 600);
+    freshView->show();
+    for (int line = 0; line < doc.lines(); ++line) {
+        const Cursor lineEnd(line, doc.lineLength(line));
+        const QPoint expected = freshView->cursorToCoordinate(lineEnd);
+        if (expected.x() >= 0) {
+            QCOMPARE(view->cursorToCoordinate(lineEnd).x(), expected.x());
+        }
+    }
+
+    delete freshView;
+    delete view;
+}
+
+void KateViewTest::testSharedLineLayouts()
+{
+    KTextEditor::DocumentPrivate doc(false, false);
+    doc.setText(QStringLiteral("first line\nsecond line\nthird line"));
+
+    KTextEditor::ViewPrivate *view = new KTextEditor::ViewPrivate(&doc, nullptr);
+    view->resize(800, 600);
+    view->show();
+    KTextEditor::ViewPrivate *secondView = new KTextEditor::ViewPrivate(&doc, nullptr);
+    secondView->resize(800, 600);
+    secondView->show();
+
+    // both views use the same shaped layout
+    const QTextLayout *layout = view->textLayout(Cursor(1, 0));
+    QVERIFY(layout);
+    QCOMPARE(secondView->textLayout(Cursor(1, 0)), layout);
+    QVERIFY(doc.shapedLayoutCache().size() > 0);
+
+    // edits lead to a new layout, shared again
+    doc.insertText(Cursor(1, 0), QStringLiteral("new "));
+    layout = view->textLayout(Cursor(1, 0));
+    QVERIFY(layout);
+    QCOMPARE(layout->text(), QStringLiteral("new second line"));
+    QCOMPARE(secondView->textLayout(Cursor(1, 0)), layout);
+
+    delete secondView;
+    delete view;
+}
+
 void KateViewTest::testReloadMultipleViews()
 {
     QTemporaryFile file(QStringLiteral("XXXXXX.cpp"));
@@ -744,4 +831,49 @@ void KateViewTest::testUpdateFoldingMarkersHighlighting()
     QCOMPARE(foldingMarkerEnd->toRange(), firstDoMatching);
 }
 
+void KateViewTest::testMiniMapTiles()
+{
+    KTextEditor::DocumentPrivate doc;
+    doc.setHighlightingMode(QStringLiteral("C++"));
+
+    QString text;
+    for (int i = 0; i < 3000; ++i) {
+        text += QStringLiteral("int value%1 = %1; // comment\n\tif (value%1) { return \"%1\"; }\n").arg(i);
+    }
+    doc.setText(text);
+    doc.buffer().ensureHighlighted(doc.lines() - 1);
+
+    const auto showView = [](KTextEditor::ViewPrivate &view) {
+        view.setScrollBarMiniMap(true);
+        view.resize(600, 400);
+        view.show();
+        view.setScrollPosition({3000, 0});
+        return QTest::qWaitForWindowExposed(&view);
+    };
+    const auto miniMap = [](KTextEditor::ViewPrivate &view) {
+        return view.getViewInternal()->m_lineScroll->grab().toImage();
+    };
+
+    // the view the tiles are kept up to date in
+    KTextEditor::ViewPrivate view(&doc, nullptr);
+    QVERIFY(showView(view));
+
+    // let it render its tiles before they get outdated
+    QTest::qWait(1000);
+
+    // edits only redraw the affected tiles, a full invalidation all of them
+    doc.insertText({4000, 0}, QStringLiteral("\n\n\tinserted text\n"));
+    doc.removeLine(10);
+    view.setSelection(KTextEditor::Range(100, 4, 5000, 2));
+    view.setSelection(KTextEditor::Range());
+    doc.setModified(!doc.isModified());
+    doc.buffer().ensureHighlighted(doc.lines() - 1);
+
+    // the minimap must end up the same as the one of a fresh view, rendered from scratch
+    // the outdated tiles of the first view keep their images until they got redrawn, it is never blank
+    KTextEditor::ViewPrivate freshView(&doc, nullptr);
+    QVERIFY(showView(freshView));
+    QTRY_COMPARE_WITH_TIMEOUT(miniMap(view), miniMap(freshView), 10000);
+}
+
 // kate: indent-mode cstyle; indent-width 4; replace-tabs on;
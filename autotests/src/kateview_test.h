@@ -24,6 +24,8 @@ private Q_SLOTS:
     void testLowerCaseBlockSelection();
     void testCoordinatesToCursor();
     void testCursorToCoordinates();
+    void testLayoutsAfterEditingTransaction();
+    void testSharedLineLayouts();
     void testSelection();
     void testDeselectByArrowKeys_data();
     void testDeselectByArrowKeys();
@@ -38,6 +40,7 @@ private Q_SLOTS:
 
     void testFindMatchingFoldingMarker();
     void testUpdateFoldingMarkersHighlighting();
+    void testMiniMapTiles();
 };
 
 #endif // KATE_VIEW_TEST_H
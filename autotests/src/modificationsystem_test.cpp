@@ -736,3 +736,69 @@ void ModificationSystemTest::testNavigation()
     QCOMPARE(doc.findTouchedLine(2, up), 2);
     QCOMPARE(doc.findTouchedLine(3, up), -1);
 }
+
+void ModificationSystemTest::testDeepHistory()
+{
+    KTextEditor::DocumentPrivate doc;
+
+    const int lines = 200;
+    QStringList content;
+    for (int i = 0; i < lines; ++i) {
+        content.push_back(QString::number(i));
+    }
+    doc.setText(content);
+
+    // clear all modification flags, forces no flags
+    doc.setModified(false);
+    doc.undoManager()->updateLineModifications();
+    clearModificationFlags(&doc);
+
+    // one undo group per line
+    for (int i = 0; i < lines; ++i) {
+        doc.insertText(Cursor(i, 0), QStringLiteral("-"));
+        doc.undoManager()->undoSafePoint();
+    }
+    QCOMPARE(doc.undoCount(), uint(lines));
+
+    // save twice, the history is updated for the last save only
+    for (int save = 0; save < 2; ++save) {
+        doc.setModified(false);
+        markModifiedLinesAsSaved(&doc);
+        doc.undoManager()->updateLineModifications();
+    }
+
+    // an edit after the save doesn't change the state of the saved groups
+    doc.insertText(Cursor(0, 0), QStringLiteral("+"));
+    doc.undo();
+    QVERIFY(doc.isLineSaved(0));
+
+    // undo everything: all lines differ from the saved state
+    while (doc.undoCount() > 0) {
+        doc.undo();
+    }
+    for (int i = 0; i < lines; ++i) {
+        QVERIFY(doc.isLineModified(i));
+        QVERIFY(!doc.isLineSaved(i));
+    }
+
+    // save again and redo everything
+    doc.setModified(false);
+    markModifiedLinesAsSaved(&doc);
+    doc.undoManager()->updateLineModifications();
+    while (doc.redoCount() > 0) {
+        doc.redo();
+    }
+    for (int i = 0; i < lines; ++i) {
+        QVERIFY(doc.isLineModified(i));
+        QVERIFY(!doc.isLineSaved(i));
+    }
+
+    // undo everything: back at the saved state
+    while (doc.undoCount() > 0) {
+        doc.undo();
+    }
+    for (int i = 0; i < lines; ++i) {
+        QVERIFY(!doc.isLineModified(i));
+        QVERIFY(doc.isLineSaved(i));
+    }
+}
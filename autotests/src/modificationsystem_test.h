@@ -39,6 +39,8 @@ private Q_SLOTS:
     void testUnWrapLine2Empty();
 
     void testNavigation();
+
+    void testDeepHistory();
 };
 
 #endif
@@ -14,6 +14,10 @@
 
 #include <QTest>
 
+#include <algorithm>
+#include <memory>
+#include <vector>
+
 using namespace KTextEditor;
 
 QTEST_MAIN(MovingCursorTest)
@@ -324,3 +328,101 @@ void MovingCursorTest::testInvalidMovingCursor()
     // if it crashes: c is still in KateBuffer::m_invalidCursors -> double deletion
     delete doc;
 }
+
+// tests:
+// - many cursors sharing lines and columns stay correct across edits and moves
+void MovingCursorTest::testManyCursorsEdits()
+{
+    KTextEditor::DocumentPrivate doc;
+    QStringList lines;
+    for (int i = 0; i < 300; ++i) {
+        lines.push_back(QStringLiteral("line number %1 with some text").arg(i));
+    }
+    doc.setText(lines);
+
+    // cursors with both insert behaviors, several on the same positions
+    std::vector<std::unique_ptr<MovingCursor>> cursors;
+    std::vector<Cursor> expected;
+    auto addCursor = [&](Cursor position, int i) {
+        cursors.emplace_back(doc.newMovingCursor(position, (i % 2) ? MovingCursor::MoveOnInsert : MovingCursor::StayOnInsert));
+        expected.push_back(position);
+    };
+    for (int i = 0; i < 3000; ++i) {
+        const int line = (i * 7) % doc.lines();
+        addCursor(Cursor(line, (i * 3) % (doc.lineLength(line) + 1)), i);
+    }
+
+    auto verify = [&]() {
+        for (size_t i = 0; i < cursors.size(); ++i) {
+            QCOMPARE(cursors[i]->toCursor(), expected[i]);
+        }
+    };
+
+    for (int round = 0; round < 40; ++round) {
+        const int line = (round * 37) % (doc.lines() - 1) + 1;
+        const int column = (round * 5) % (doc.lineLength(line) + 1);
+
+        switch (round % 4) {
+        case 0:
+            // insert text, cursors at the position move only if asked to
+            doc.insertText(Cursor(line, column), QStringLiteral("abc"));
+            for (size_t i = 0; i < cursors.size(); ++i) {
+                if (expected[i].line() == line
+                    && (expected[i].column() > column || (expected[i].column() == column && cursors[i]->insertBehavior() == MovingCursor::MoveOnInsert))) {
+                    expected[i].setColumn(expected[i].column() + 3);
+                }
+            }
+            break;
+        case 1: {
+            // remove text, cursors inside collapse to the start
+            const int end = std::min(doc.lineLength(line), column + 4);
+            doc.removeText(Range(line, column, line, end));
+            for (auto &position : expected) {
+                if (position.line() == line && position.column() > column) {
+                    position.setColumn(position.column() <= end ? column : position.column() - (end - column));
+                }
+            }
+            break;
+        }
+        case 2:
+            // wrap line, cursors behind the position move to the new line
+            doc.editWrapLine(line, column);
+            for (size_t i = 0; i < cursors.size(); ++i) {
+                auto &position = expected[i];
+                if (position.line() > line) {
+                    position.setLine(position.line() + 1);
+                } else if (position.line() == line
+                           && (position.column() > column || (position.column() == column && cursors[i]->insertBehavior() == MovingCursor::MoveOnInsert))) {
+                    position = Cursor(line + 1, position.column() - column);
+                }
+            }
+            break;
+        case 3: {
+            // unwrap line, cursors move behind the text of the previous line
+            const int previousLength = doc.lineLength(line - 1);
+            doc.editUnWrapLine(line - 1);
+            for (auto &position : expected) {
+                if (position.line() > line) {
+                    position.setLine(position.line() - 1);
+                } else if (position.line() == line) {
+                    position = Cursor(line - 1, position.column() + previousLength);
+                }
+            }
+            break;
+        }
+        }
+        verify();
+
+        // move some cursors inside their lines and across lines, drop some others
+        for (size_t i = round; i < cursors.size(); i += 17) {
+            const int newLine = (round % 2) ? expected[i].line() : int(i % doc.lines());
+            expected[i] = Cursor(newLine, (int(i) + round) % (doc.lineLength(newLine) + 1));
+            cursors[i]->setPosition(expected[i]);
+        }
+        for (size_t i = round; i < cursors.size(); i += 101) {
+            cursors.erase(cursors.begin() + i);
+            expected.erase(expected.begin() + i);
+        }
+        verify();
+    }
+}
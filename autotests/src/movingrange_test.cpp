@@ -17,6 +17,8 @@
 
 #include <QTest>
 
+#include <memory>
+
 using namespace KTextEditor;
 
 QTEST_MAIN(MovingRangeTest)
@@ -512,3 +514,56 @@ void MovingRangeTest::testMultiline()
     QVERIFY(doc.buffer().rangesForLine(1, nullptr, false).contains(range));
     QVERIFY(doc.buffer().rangesForLine(2, nullptr, false).contains(range));
 }
+
+void MovingRangeTest::testMultilineRangesForLineIndex()
+{
+    KTextEditor::DocumentPrivate doc;
+    QStringList lines;
+    for (int i = 0; i < 1000; ++i) {
+        lines.push_back(QStringLiteral("line %1").arg(i));
+    }
+    doc.setText(lines);
+
+    // many overlapping multi-line ranges spanning several blocks, mixed with single-line ones
+    std::vector<std::unique_ptr<MovingRange>> ranges;
+    for (int i = 0; i < 400; ++i) {
+        const int start = (i * 37) % 1000;
+        const int length = (i * 13) % 150;
+        ranges.emplace_back(doc.newMovingRange({start, 1, std::min(start + length, 999), 2}));
+    }
+
+    // the index must return exactly the ranges a linear scan finds
+    auto verifyAllLines = [&doc, &ranges]() {
+        for (int line = 0; line < doc.lines(); ++line) {
+            QSet<MovingRange *> expected;
+            for (const auto &range : ranges) {
+                if (range->start().line() <= line && line <= range->end().line()) {
+                    expected.insert(range.get());
+                }
+            }
+            QSet<MovingRange *> found;
+            for (auto range : doc.buffer().rangesForLine(line, nullptr, false)) {
+                found.insert(range);
+            }
+            QCOMPARE(found, expected);
+        }
+    };
+    verifyAllLines();
+
+    // edits shift ranges within and across blocks
+    doc.insertLines(10, {QStringLiteral("a"), QStringLiteral("b"), QStringLiteral("c")});
+    verifyAllLines();
+    doc.removeText({100, 0, 180, 0});
+    verifyAllLines();
+    doc.editWrapLine(500, 2);
+    verifyAllLines();
+    doc.editUnWrapLine(300);
+    verifyAllLines();
+
+    // moving ranges around updates their intervals
+    for (size_t i = 0; i < ranges.size(); i += 3) {
+        const int start = (int(i) * 53) % 800;
+        ranges[i]->setRange({start, 0, start + int(i % 40), 0});
+    }
+    verifyAllLines();
+}
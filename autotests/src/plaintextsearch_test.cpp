@@ -12,6 +12,7 @@
 #include <kateglobal.h>
 #include <kateplaintextsearch.h>
 
+#include <QRegularExpression>
 #include <QTest>
 
 QTEST_MAIN(PlainTextSearchTest)
@@ -155,3 +156,61 @@ void PlainTextSearchTest::testMultilineSearch()
 
     QCOMPARE(m_search->search(pattern, inputRange, false), forwardResult);
 }
+
+void PlainTextSearchTest::testMatcher_data()
+{
+    QTest::addColumn<QString>("haystack");
+    QTest::addColumn<QString>("needle");
+    QTest::addColumn<bool>("caseInsensitive");
+    QTest::addColumn<bool>("wholeWords");
+
+    const QString text = QStringLiteral("Foo foobar barfoo_ FOO, (foo) foo-bar \u00C4rger \u00E4rger foofoo");
+    for (const bool caseInsensitive : {false, true}) {
+        for (const bool wholeWords : {false, true}) {
+            for (const auto needle : {"foo", "Foo", "fo", "o", "foobar", "bar foo", "-bar", "(foo)", "\u00E4rger", "oofoo", "xyz"}) {
+                QTest::addRow("%s ci=%d ww=%d", needle, caseInsensitive, wholeWords) << text << QString::fromUtf8(needle) << caseInsensitive << wholeWords;
+            }
+        }
+    }
+}
+
+void PlainTextSearchTest::testMatcher()
+{
+    QFETCH(QString, haystack);
+    QFETCH(QString, needle);
+    QFETCH(bool, caseInsensitive);
+    QFETCH(bool, wholeWords);
+
+    const KatePlainTextMatcher matcher(needle, caseInsensitive ? Qt::CaseInsensitive : Qt::CaseSensitive, wholeWords);
+    QVERIFY(matcher.isBuiltFor(needle, caseInsensitive ? Qt::CaseInsensitive : Qt::CaseSensitive, wholeWords));
+
+    // the regular expression whole word search used before is the reference
+    QRegularExpression::PatternOptions options = QRegularExpression::UseUnicodePropertiesOption;
+    if (caseInsensitive) {
+        options |= QRegularExpression::CaseInsensitiveOption;
+    }
+    const QString escaped = QRegularExpression::escape(needle);
+    const QRegularExpression reference(wholeWords ? QStringLiteral("\\b%1\\b").arg(escaped) : escaped, options);
+    QList<qsizetype> expected;
+    for (qsizetype pos = 0; pos < haystack.size(); ++pos) {
+        if (reference.match(haystack, pos, QRegularExpression::NormalMatch, QRegularExpression::AnchorAtOffsetMatchOption).hasMatch()) {
+            expected.push_back(pos);
+        }
+    }
+
+    // all matches, forwards and backwards, in every sub range
+    for (qsizetype from = 0; from <= haystack.size(); from += 3) {
+        for (qsizetype to = from; to <= haystack.size(); to += 5) {
+            qsizetype first = -1;
+            qsizetype last = -1;
+            for (const qsizetype pos : std::as_const(expected)) {
+                if (pos >= from && pos + needle.size() <= to) {
+                    first = (first < 0) ? pos : first;
+                    last = pos;
+                }
+            }
+            QCOMPARE(matcher.indexIn(haystack, from, to), first);
+            QCOMPARE(matcher.lastIndexIn(haystack, from, to), last);
+        }
+    }
+}
@@ -40,6 +40,9 @@ private Q_SLOTS:
     void testMultilineSearch_data();
     void testMultilineSearch();
 
+    void testMatcher_data();
+    void testMatcher();
+
 private:
     KTextEditor::DocumentPrivate *m_doc = nullptr;
     KatePlainTextSearch *m_search = nullptr;
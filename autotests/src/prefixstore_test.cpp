@@ -0,0 +1,88 @@
+/*
+    SPDX-FileCopyrightText: 2026 KTextEditor contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "prefixstore_test.h"
+
+#include <spellcheck/prefixstore.h>
+
+#include <QTest>
+
+QTEST_MAIN(PrefixStoreTest)
+
+static KatePrefixStore latexLikeStore()
+{
+    KatePrefixStore store;
+    for (const auto prefix : {u"\\\"a", u"\\\"{a}", u"{\\\"a}", u"\\ss", u"\\ss{}", u"ab", u"b", u"abc", u"bca", u"äö"}) {
+        store.addPrefix(QString::fromUtf16(prefix));
+    }
+    return store;
+}
+
+void PrefixStoreTest::testFindPrefix()
+{
+    const KatePrefixStore store = latexLikeStore();
+    QCOMPARE(store.longestPrefixLength(), 5);
+
+    // the shortest prefix wins
+    QCOMPARE(store.findPrefix(QStringLiteral("\\ss{}")), QStringLiteral("\\ss"));
+    QCOMPARE(store.findPrefix(QStringLiteral("abcd")), QStringLiteral("ab"));
+    QCOMPARE(store.findPrefix(QStringLiteral("xabc"), 1), QStringLiteral("ab"));
+    QCOMPARE(store.findPrefix(QStringLiteral("bca")), QStringLiteral("b"));
+    QCOMPARE(store.findPrefix(QStringLiteral("x\\\"ay"), 1), QStringLiteral("\\\"a"));
+    QCOMPARE(store.findPrefix(QString::fromUtf16(u"äöü")), QString::fromUtf16(u"äö"));
+
+    // prefixes must start at the given position
+    QCOMPARE(store.findPrefix(QStringLiteral("xab")), QString());
+    QCOMPARE(store.findPrefix(QStringLiteral("\\s")), QString());
+    QCOMPARE(store.findPrefix(Kate::TextLine(QStringLiteral("a\\ss")), 1), QStringLiteral("\\ss"));
+    QCOMPARE(store.findPrefix(Kate::TextLine(QStringLiteral("a\\ss")), 0), QString());
+}
+
+void PrefixStoreTest::testPrefixLengths_data()
+{
+    QTest::addColumn<QString>("text");
+
+    QTest::newRow("empty") << QString();
+    QTest::newRow("no match") << QStringLiteral("Hello World");
+    QTest::newRow("latex") << QStringLiteral("Schr\\\"{o}dinger na\\\"ive {\\\"a} Stra\\ss{}e \\\"a\\\"a");
+    QTest::newRow("overlapping") << QStringLiteral("abcabcbcaabbca");
+    QTest::newRow("unicode") << QString::fromUtf16(u"xäöäöü ab");
+}
+
+void PrefixStoreTest::testPrefixLengths()
+{
+    QFETCH(QString, text);
+
+    // the single pass must agree with the lookup for every single column
+    const KatePrefixStore store = latexLikeStore();
+    const Kate::TextLine line(text);
+    const std::vector<int> lengths = store.prefixLengths(line);
+    QCOMPARE(int(lengths.size()), text.size());
+    for (int column = 0; column < text.size(); ++column) {
+        QCOMPARE(lengths[column], store.findPrefix(line, column).size());
+    }
+}
+
+void PrefixStoreTest::testRemovePrefix()
+{
+    KatePrefixStore store = latexLikeStore();
+    store.removePrefix(QStringLiteral("ab"));
+    QCOMPARE(store.findPrefix(QStringLiteral("abcd")), QStringLiteral("abc"));
+    store.removePrefix(QStringLiteral("\\ss{}"));
+    QCOMPARE(store.longestPrefixLength(), 5);
+    store.removePrefix(QStringLiteral("\\\"{a}"));
+    store.removePrefix(QStringLiteral("{\\\"a}"));
+    QCOMPARE(store.longestPrefixLength(), 3);
+
+    const Kate::TextLine line(QStringLiteral("xabc \\ss"));
+    QVERIFY(store.prefixLengths(line) == std::vector<int>({0, 3, 1, 0, 0, 3, 0, 0}));
+
+    store.clear();
+    QCOMPARE(store.findPrefix(QStringLiteral("abc")), QString());
+    QVERIFY(store.prefixLengths(line).empty());
+}
+
+#include "moc_prefixstore_test.cpp"
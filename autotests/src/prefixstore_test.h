@@ -0,0 +1,23 @@
+/*
+    SPDX-FileCopyrightText: 2026 KTextEditor contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KATE_PREFIXSTORE_TEST_H
+#define KATE_PREFIXSTORE_TEST_H
+
+#include <QObject>
+
+class PrefixStoreTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void testFindPrefix();
+    void testPrefixLengths_data();
+    void testPrefixLengths();
+    void testRemovePrefix();
+};
+
+#endif // KATE_PREFIXSTORE_TEST_H
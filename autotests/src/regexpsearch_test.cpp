@@ -290,6 +290,83 @@ void RegExpSearchTest::testSearchBackwardInSelection()
     QCOMPARE(result, Range(0, 7, 0, 10));
 }
 
+void RegExpSearchTest::testMultiLineWindows()
+{
+    // more lines than one window of a multi-line search
+    QStringList lines;
+    for (int i = 0; i < 3000; ++i) {
+        lines.push_back(QStringLiteral("line %1").arg(i));
+    }
+    lines[1000] = QStringLiteral("foo");
+    lines[1001] = QStringLiteral("bar");
+    lines[2000] = QStringLiteral("start");
+    lines[2600] = QStringLiteral("end");
+
+    KTextEditor::DocumentPrivate doc;
+    doc.setText(lines.join(QLatin1Char('\n')));
+    const Range all = doc.documentRange();
+
+    KateRegExpSearch searcher(&doc);
+    QList<Range> result = searcher.search(QStringLiteral("(foo)\\n(bar)"), all, false);
+    QCOMPARE(result.size(), 3);
+    QCOMPARE(result[0], Range(1000, 0, 1001, 3));
+    QCOMPARE(result[1], Range(1000, 0, 1000, 3));
+    QCOMPARE(result[2], Range(1001, 0, 1001, 3));
+
+    // matches must end inside of the range
+    QCOMPARE(searcher.search(QStringLiteral("foo\\nbar"), Range(0, 0, 1001, 2), false)[0], Range::invalid());
+
+    // a match spanning more lines than a window
+    QCOMPARE(searcher.search(QStringLiteral("start\\n[^#]*end"), all, false)[0], Range(2000, 0, 2600, 3));
+
+    // backwards the last match wins
+    QCOMPARE(searcher.search(QStringLiteral("line \\d+\\n"), all, true)[0], Range(2998, 0, 2999, 0));
+
+    // successive searches reuse the assembled lines, edits must invalidate them
+    QCOMPARE(searcher.search(QStringLiteral("\\nline"), Range(1500, 0, 2999, 9), false)[0], Range(1500, 9, 1501, 4));
+    doc.insertText(KTextEditor::Cursor(1501, 0), QStringLiteral("X"));
+    QCOMPARE(searcher.search(QStringLiteral("\\nXline"), Range(1500, 0, 2999, 9), false)[0], Range(1500, 9, 1501, 5));
+    QCOMPARE(searcher.search(QStringLiteral("\\nline"), Range(1500, 0, 2999, 9), false)[0], Range(1501, 10, 1502, 4));
+}
+
+void RegExpSearchTest::testMultiLineWindowContext()
+{
+    // lookbehinds see the lines in front of the searched ones, also for matches far behind the range start
+    QStringList lines(1027);
+    lines[1024] = QStringLiteral("x");
+    lines[1026] = QStringLiteral("y");
+
+    KTextEditor::DocumentPrivate doc;
+    doc.setText(lines.join(QLatin1Char('\n')));
+
+    KateRegExpSearch searcher(&doc);
+    QCOMPARE(searcher.search(QStringLiteral("^\\n|(?<=x\\n\\n)y"), doc.documentRange(), true)[0], Range(1026, 0, 1026, 1));
+
+    // \A only matches at the range start
+    QCOMPARE(searcher.search(QStringLiteral("\\A\\n"), Range(1000, 0, 1026, 1), true)[0], Range(1000, 0, 1001, 0));
+    QCOMPARE(searcher.search(QStringLiteral("\\Ax\\n"), Range(1000, 0, 1026, 1), false)[0], Range::invalid());
+}
+
+void RegExpSearchTest::testMultiLineWindowSize()
+{
+    QStringList lines(100000, QStringLiteral("some text"));
+    lines.back() = QStringLiteral("match");
+
+    KTextEditor::DocumentPrivate doc;
+    doc.setText(lines.join(QLatin1Char('\n')));
+
+    // a search without matches doesn't assemble the whole range, the window slides along
+    KateRegExpSearch searcher(&doc);
+    QCOMPARE(searcher.search(QStringLiteral("nothing\n"), doc.documentRange(), false)[0], Range::invalid());
+    QVERIFY(doc.regExpSearchWindow().text().size() < 100000);
+    QCOMPARE(searcher.search(QStringLiteral("text\nmatch"), doc.documentRange(), false)[0], Range(99998, 5, 99999, 5));
+    QVERIFY(doc.regExpSearchWindow().text().size() < 100000);
+
+    // changes drop the window
+    doc.insertText(Cursor(0, 0), QStringLiteral("x"));
+    QVERIFY(doc.regExpSearchWindow().text().isEmpty());
+}
+
 void RegExpSearchTest::test()
 {
     KTextEditor::DocumentPrivate doc;
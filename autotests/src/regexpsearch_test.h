@@ -38,6 +38,10 @@ private Q_SLOTS:
 
     void testSearchBackwardInSelection();
 
+    void testMultiLineWindows();
+    void testMultiLineWindowContext();
+    void testMultiLineWindowSize();
+
     void test();
     void testUnicode();
 };
@@ -16,6 +16,9 @@
 
 #include <QTest>
 
+#include <algorithm>
+#include <vector>
+
 using namespace KTextEditor;
 
 QTEST_MAIN(RevisionTest)
@@ -138,3 +141,104 @@ void RevisionTest::testTransformRange()
     QCOMPARE(r2, Range(Cursor(1, 2), Cursor(1, 2)));
     QCOMPARE(invalidOnEmpty, Range::invalid());
 }
+
+// tests:
+// - transformCursor() and transformRange() over many edits match transforming revision by revision
+// - transformRanges() matches transformRange()
+void RevisionTest::testTransformManyEdits()
+{
+    KTextEditor::DocumentPrivate doc;
+    QStringList lines;
+    for (int i = 0; i < 200; ++i) {
+        lines.push_back(QStringLiteral("line %1 of the text").arg(i));
+    }
+    doc.setText(lines);
+
+    const qint64 firstRev = doc.revision();
+    doc.lockRevision(firstRev);
+
+    // edits spread over the document, mixed with edits hitting the same lines again
+    for (int i = 0; i < 400; ++i) {
+        const int line = (i % 3 == 0) ? 20 + (i % 5) : (i * 37) % doc.lines();
+        const int column = (i * 7) % (doc.lineLength(line) + 1);
+        switch (i % 4) {
+        case 0:
+            doc.insertText(Cursor(line, column), QStringLiteral("ab"));
+            break;
+        case 1:
+            doc.insertText(Cursor(line, column), QStringLiteral("x\ny"));
+            break;
+        case 2:
+            doc.removeText(Range(line, column, line, std::min(column + 3, doc.lineLength(line))));
+            break;
+        case 3:
+            if (line + 1 < doc.lines()) {
+                doc.removeText(Range(line, column, line + 1, 0));
+            }
+            break;
+        }
+    }
+    const qint64 lastRev = doc.revision();
+    QVERIFY(lastRev - firstRev > 400);
+
+    // ranges and cursors everywhere, some of them in the often edited lines
+    std::vector<Range> ranges;
+    for (int i = 0; i < 300; ++i) {
+        const int startLine = (i * 13) % 200;
+        const int endLine = std::min(199, startLine + (i % 4));
+        ranges.push_back(Range(startLine, i % 10, endLine, (i % 4) ? (i % 7) : (i % 10) + (i % 3)));
+    }
+
+    const std::vector<MovingRange::InsertBehaviors> behaviors = {MovingRange::DoNotExpand,
+                                                                 MovingRange::ExpandLeft,
+                                                                 MovingRange::ExpandRight,
+                                                                 MovingRange::ExpandLeft | MovingRange::ExpandRight};
+    for (const auto insertBehaviors : behaviors) {
+        for (const auto emptyBehavior : {MovingRange::AllowEmpty, MovingRange::InvalidateIfEmpty}) {
+            // forward and reverse
+            for (const bool forward : {true, false}) {
+                const qint64 fromRev = forward ? firstRev : lastRev;
+                const qint64 toRev = forward ? lastRev : firstRev;
+                const qint64 step = forward ? 1 : -1;
+
+                std::vector<Range> batch = ranges;
+                doc.transformRanges(batch, insertBehaviors, emptyBehavior, fromRev, toRev);
+
+                for (size_t i = 0; i < ranges.size(); ++i) {
+                    Range direct = ranges[i];
+                    doc.transformRange(direct, insertBehaviors, emptyBehavior, fromRev, toRev);
+
+                    Range stepwise = ranges[i];
+                    for (qint64 rev = fromRev; rev != toRev && stepwise.isValid(); rev += step) {
+                        doc.transformRange(stepwise, insertBehaviors, emptyBehavior, rev, rev + step);
+                    }
+
+                    QCOMPARE(direct, stepwise);
+                    QCOMPARE(batch[i], direct);
+                }
+            }
+        }
+    }
+
+    for (const auto &range : ranges) {
+        for (const auto insertBehavior : {MovingCursor::StayOnInsert, MovingCursor::MoveOnInsert}) {
+            Cursor direct = range.start();
+            doc.transformCursor(direct, insertBehavior, firstRev, lastRev);
+            Cursor stepwise = range.start();
+            for (qint64 rev = firstRev; rev != lastRev; ++rev) {
+                doc.transformCursor(stepwise, insertBehavior, rev, rev + 1);
+            }
+            QCOMPARE(direct, stepwise);
+
+            Cursor reverse = range.start();
+            doc.transformCursor(reverse, insertBehavior, lastRev, firstRev);
+            stepwise = range.start();
+            for (qint64 rev = lastRev; rev != firstRev; --rev) {
+                doc.transformCursor(stepwise, insertBehavior, rev, rev - 1);
+            }
+            QCOMPARE(reverse, stepwise);
+        }
+    }
+
+    doc.unlockRevision(firstRev);
+}
@@ -21,6 +21,7 @@ public:
 private Q_SLOTS:
     void testTransformCursor();
     void testTransformRange();
+    void testTransformManyEdits();
 };
 
 #endif // KATE_REVISION_TEST_H
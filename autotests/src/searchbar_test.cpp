@@ -18,6 +18,7 @@
 #include <kateview.h>
 #include <ktexteditor/movingrange.h>
 
+#include <QElapsedTimer>
 #include <QStringListModel>
 #include <QTest>
 
@@ -417,6 +418,208 @@ void SearchBarTest::testFindAll()
     QCOMPARE(bar.m_hlRanges.size(), 0);
 }
 
+static uint findAllMatchCount(int lines, KateSearchBar::SearchMode mode, const QString &pattern)
+{
+    KTextEditor::DocumentPrivate doc;
+    KTextEditor::ViewPrivate view(&doc, nullptr);
+    KateViewConfig config(&view);
+
+    QStringList text;
+    for (int i = 0; i < lines; ++i) {
+        text.push_back(QStringLiteral("ab ab"));
+    }
+    doc.setText(text.join(QLatin1Char('\n')));
+
+    KateSearchBar bar(true, &view, &config);
+    bar.setSearchMode(mode);
+    bar.setSearchPattern(pattern);
+    bar.findAll();
+
+    // large documents are searched in background jobs
+    if (!QTest::qWaitFor([&bar]() {
+            return bar.m_cancelFindOrReplace;
+        }, 30000)) {
+        return 0;
+    }
+    return bar.m_matchCounter;
+}
+
+void SearchBarTest::testFindAllParallel_data()
+{
+    QTest::addColumn<int>("mode");
+    QTest::addColumn<QString>("pattern");
+
+    testNewRow() << int(KateSearchBar::MODE_PLAIN_TEXT) << QStringLiteral("ab");
+    testNewRow() << int(KateSearchBar::MODE_WHOLE_WORDS) << QStringLiteral("ab");
+    testNewRow() << int(KateSearchBar::MODE_REGEX) << QStringLiteral("b*");
+    testNewRow() << int(KateSearchBar::MODE_REGEX) << QStringLiteral("^");
+    testNewRow() << int(KateSearchBar::MODE_REGEX) << QStringLiteral("\\bab$");
+}
+
+void SearchBarTest::testFindAllParallel()
+{
+    QFETCH(int, mode);
+    QFETCH(QString, pattern);
+
+    // small documents are searched sequentially, derive the matches per line from them
+    const auto searchMode = KateSearchBar::SearchMode(mode);
+    const uint oneLine = findAllMatchCount(1, searchMode, pattern);
+    const uint perLine = findAllMatchCount(2, searchMode, pattern) - oneLine;
+    QVERIFY(perLine > 0);
+
+    const int lines = 100000;
+    QCOMPARE(findAllMatchCount(lines, searchMode, pattern), oneLine + (lines - 1) * perLine);
+}
+
+void SearchBarTest::testFindAllParallelViewportOnly()
+{
+    KTextEditor::DocumentPrivate doc;
+    KTextEditor::ViewPrivate view(&doc, nullptr);
+    KateViewConfig config(&view);
+
+    QStringList text;
+    for (int i = 0; i < 60000; ++i) {
+        text.push_back(QStringLiteral("ab ab"));
+    }
+    doc.setText(text.join(QLatin1Char('\n')));
+
+    KateSearchBar bar(true, &view, &config);
+    bar.setSearchPattern(QStringLiteral("ab"));
+    bar.findAll();
+    QTRY_VERIFY_WITH_TIMEOUT(bar.m_cancelFindOrReplace, 30000);
+
+    // too many matches to highlight them all, only the displayed ones are
+    QCOMPARE(bar.m_matchCounter, 120000u);
+    QCOMPARE(bar.m_viewportMatches.size(), size_t(120000));
+    QVERIFY(bar.m_hlRanges.size() < 65536);
+    for (const auto range : std::as_const(bar.m_hlRanges)) {
+        QVERIFY(range->start().line() >= view.firstDisplayedLine());
+        QVERIFY(range->end().line() <= view.lastDisplayedLine());
+    }
+
+    // edits make the plain ranges useless
+    doc.insertText(Cursor(0, 0), QStringLiteral("x"));
+    bar.updateViewportHighlights();
+    QVERIFY(bar.m_viewportMatches.empty());
+}
+
+void SearchBarTest::testFindOrReplaceAllViewportOnly_data()
+{
+    QTest::addColumn<bool>("replace");
+
+    testNewRow() << false;
+    testNewRow() << true;
+}
+
+void SearchBarTest::testFindOrReplaceAllViewportOnly()
+{
+    QFETCH(bool, replace);
+
+    KTextEditor::DocumentPrivate doc;
+    KTextEditor::ViewPrivate view(&doc, nullptr);
+    KateViewConfig config(&view);
+
+    view.resize(400, 300);
+    view.show();
+
+    // too few lines for the parallel find all
+    QStringList text;
+    for (int i = 0; i < 40000; ++i) {
+        text.push_back(QStringLiteral("ab ab"));
+    }
+    doc.setText(text.join(QLatin1Char('\n')));
+
+    KateSearchBar bar(true, &view, &config);
+    bar.setSearchPattern(QStringLiteral("ab"));
+    if (replace) {
+        bar.setReplacementPattern(QStringLiteral("xyz"));
+        bar.replaceAll();
+    } else {
+        bar.findAll();
+    }
+    QTRY_VERIFY_WITH_TIMEOUT(bar.m_cancelFindOrReplace, 30000);
+
+    // too many matches to highlight them all, only the displayed ones are
+    QCOMPARE(bar.m_matchCounter, 80000u);
+    QCOMPARE(bar.m_viewportMatches.size(), size_t(80000));
+    QVERIFY(!bar.m_hlRanges.isEmpty());
+    QVERIFY(bar.m_hlRanges.size() < 65536);
+    const int length = replace ? 3 : 2;
+    for (const auto range : std::as_const(bar.m_hlRanges)) {
+        QVERIFY(range->start().line() >= view.firstDisplayedLine());
+        QVERIFY(range->end().line() <= view.lastDisplayedLine());
+        QCOMPARE(range->end().column() - range->start().column(), length);
+    }
+}
+
+void SearchBarTest::testScrollDuringFindOrReplaceAll_data()
+{
+    QTest::addColumn<bool>("replace");
+
+    testNewRow() << false;
+    testNewRow() << true;
+}
+
+void SearchBarTest::testScrollDuringFindOrReplaceAll()
+{
+    QFETCH(bool, replace);
+
+    KTextEditor::DocumentPrivate doc;
+    KTextEditor::ViewPrivate view(&doc, nullptr);
+    KateViewConfig config(&view);
+
+    view.resize(400, 300);
+    view.show();
+
+    // enough lines for the parallel find all and for several time slices of the replace all
+    QStringList text;
+    for (int i = 0; i < 120000; ++i) {
+        text.push_back(QStringLiteral("ab ab"));
+    }
+    doc.setText(text.join(QLatin1Char('\n')));
+
+    KateSearchBar bar(true, &view, &config);
+    bar.setSearchPattern(QStringLiteral("ab"));
+    if (replace) {
+        bar.setReplacementPattern(QStringLiteral("xyz"));
+        bar.replaceAll();
+    } else {
+        bar.findAll();
+    }
+
+    // scrolling must neither drop the collected matches nor touch the highlights of the running search
+    int line = 0;
+    QElapsedTimer timer;
+    timer.start();
+    while (!bar.m_cancelFindOrReplace && timer.elapsed() < 30000) {
+        line = (line + 5000) % 120000;
+        view.setScrollPosition(Cursor(line, 0));
+        QCoreApplication::processEvents();
+    }
+    QVERIFY(bar.m_cancelFindOrReplace);
+
+    QCOMPARE(bar.m_matchCounter, 240000u);
+    QCOMPARE(bar.m_viewportMatches.size(), size_t(240000));
+
+    // the displayed matches are highlighted, also after scrolling once done
+    const int length = replace ? 3 : 2;
+    for (const int scrollLine : {line, 60000}) {
+        view.setScrollPosition(Cursor(scrollLine, 0));
+        bar.updateViewportHighlights();
+        QVERIFY(!bar.m_hlRanges.isEmpty());
+        for (const auto range : std::as_const(bar.m_hlRanges)) {
+            QVERIFY(range->start().line() >= view.firstDisplayedLine());
+            QVERIFY(range->end().line() <= view.lastDisplayedLine());
+            QCOMPARE(range->end().column() - range->start().column(), length);
+        }
+    }
+
+    // the parallel find all streams its chunks in document order, the scroll bar marks start with the first match
+    if (!replace) {
+        QVERIFY(doc.marks().contains(0));
+    }
+}
+
 void SearchBarTest::testReplaceInSelectionOnly()
 {
     KTextEditor::DocumentPrivate doc;
@@ -42,6 +42,13 @@ private Q_SLOTS:
 
     void testFindAll_data();
     void testFindAll();
+    void testFindAllParallel_data();
+    void testFindAllParallel();
+    void testFindAllParallelViewportOnly();
+    void testFindOrReplaceAllViewportOnly_data();
+    void testFindOrReplaceAllViewportOnly();
+    void testScrollDuringFindOrReplaceAll_data();
+    void testScrollDuringFindOrReplaceAll();
 
     void testReplaceInSelectionOnly();
     void testReplaceAll();
@@ -0,0 +1,75 @@
+/*
+    SPDX-FileCopyrightText: 2026 KTextEditor contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "spellcheck_test.h"
+
+#include <katedocument.h>
+#include <kateglobal.h>
+#include <kateview.h>
+#include <spellcheck/spellcheckbar.h>
+
+#include <sonnet/backgroundchecker.h>
+#include <sonnet/speller.h>
+
+#include <QPushButton>
+#include <QRandomGenerator>
+#include <QSignalSpy>
+#include <QTest>
+
+QTEST_MAIN(SpellCheckTest)
+
+using namespace KTextEditor;
+
+void SpellCheckTest::initTestCase()
+{
+    KTextEditor::EditorPrivate::enableUnitTestMode();
+}
+
+void SpellCheckTest::testAddWordFromBar()
+{
+    // a new word each run, the personal dictionary is persistent
+    QString word = QStringLiteral("qzx");
+    for (int i = 0; i < 8; ++i) {
+        word += QLatin1Char(char('a' + QRandomGenerator::global()->bounded(26)));
+    }
+
+    Sonnet::Speller speller;
+    if (!speller.isValid() || speller.isCorrect(word)) {
+        QSKIP("no usable dictionary installed");
+    }
+
+    KTextEditor::DocumentPrivate doc;
+    doc.setDefaultDictionary(speller.language());
+    doc.setText(word);
+    auto view = static_cast<KTextEditor::ViewPrivate *>(doc.createView(nullptr));
+    view->resize(400, 300);
+    view->show();
+    doc.onTheFlySpellCheckingEnabled(true);
+
+    const Range wordRange(0, 0, 0, word.size());
+    QTRY_VERIFY(!doc.dictionaryForMisspelledRange(wordRange).isEmpty());
+
+    // add the word through the spell check bar, it has a speller of its own
+    Sonnet::BackgroundChecker checker(speller);
+    SpellCheckBar bar(&checker, nullptr);
+    QSignalSpy misspelling(&checker, &Sonnet::BackgroundChecker::misspelling);
+    bar.setBuffer(word);
+    bar.show();
+    QTRY_COMPARE(misspelling.count(), 1);
+    bar.findChild<QPushButton *>(QStringLiteral("m_addBtn"))->click();
+    QVERIFY(doc.dictionaryForMisspelledRange(wordRange).isEmpty());
+
+    // recheck the line, the cached verdict for the word must be gone,
+    // the other misspelling shows when the check of the line is done
+    const QString otherWord = QStringLiteral("zqx") + word.mid(3);
+    doc.insertText(Cursor(0, word.size()), QLatin1Char(' ') + otherWord);
+    QTRY_VERIFY(!doc.dictionaryForMisspelledRange(Range(0, word.size() + 1, 0, word.size() + 1 + otherWord.size())).isEmpty());
+    QVERIFY(doc.dictionaryForMisspelledRange(wordRange).isEmpty());
+
+    delete view;
+}
+
+#include "moc_spellcheck_test.cpp"
@@ -0,0 +1,22 @@
+/*
+    SPDX-FileCopyrightText: 2026 KTextEditor contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KATE_SPELLCHECK_TEST_H
+#define KATE_SPELLCHECK_TEST_H
+
+#include <QObject>
+
+class SpellCheckTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+
+    void testAddWordFromBar();
+};
+
+#endif // KATE_SPELLCHECK_TEST_H
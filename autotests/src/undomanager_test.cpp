@@ -278,4 +278,87 @@ void UndoManagerTest::testUndoAfterPastingWrappingLine()
     QCOMPARE(doc.text(), originalText);
 }
 
+void UndoManagerTest::testCompressedUndoGroups()
+{
+    KTextEditor::DocumentPrivate doc;
+    KateUndoManager *undoManager = doc.undoManager();
+
+    // many large undo groups, the old ones get compressed
+    const int groups = 64;
+    QStringList texts;
+    qsizetype textSize = 0;
+    for (int i = 0; i < groups; ++i) {
+        const QString text = QString(2048, QLatin1Char('a' + i % 26)) + QLatin1Char('\n');
+        doc.insertText(Cursor(i, 0), text);
+        undoManager->undoSafePoint();
+        texts.push_back(doc.text());
+        textSize += text.size() * qsizetype(sizeof(QChar));
+    }
+    QCOMPARE(doc.undoCount(), uint(groups));
+    QVERIFY(undoManager->memoryUsage() > 0);
+    QVERIFY(undoManager->memoryUsage() < textSize);
+
+    // undo restores the compressed groups
+    for (int i = groups - 1; i > 0; --i) {
+        doc.undo();
+        QCOMPARE(doc.text(), texts[i - 1]);
+    }
+    doc.undo();
+    QCOMPARE(doc.text(), QString());
+
+    // and redo brings back all of them
+    for (int i = 0; i < groups; ++i) {
+        doc.redo();
+        QCOMPARE(doc.text(), texts[i]);
+    }
+    QCOMPARE(doc.undoCount(), uint(groups));
+    QCOMPARE(doc.redoCount(), 0u);
+
+    // the redone groups got compressed again once they left the recent part
+    QVERIFY(undoManager->memoryUsage() < textSize);
+
+    undoManager->clearUndo();
+    QCOMPARE(undoManager->memoryUsage(), qsizetype(0));
+}
+
+void UndoManagerTest::testUndoMemoryBudget()
+{
+    KTextEditor::DocumentPrivate doc;
+    KateUndoManager *undoManager = doc.undoManager();
+
+    // no budget: all groups are kept
+    const int groups = 32;
+    for (int i = 0; i < groups; ++i) {
+        doc.insertText(Cursor(i, 0), QStringLiteral("line %1\n").arg(i));
+        undoManager->undoSafePoint();
+    }
+    QCOMPARE(doc.undoCount(), uint(groups));
+    const qsizetype usage = undoManager->memoryUsage();
+    QVERIFY(usage > 0);
+
+    // a budget for about half the history drops the oldest groups
+    undoManager->setMemoryBudget(usage / 2);
+    QVERIFY(doc.undoCount() < uint(groups));
+    QVERIFY(doc.undoCount() > 0);
+    QVERIFY(undoManager->memoryUsage() <= usage / 2);
+
+    // the remaining history is still consistent
+    const QString text = doc.text();
+    while (doc.undoCount() > 0) {
+        doc.undo();
+    }
+    QCOMPARE(doc.lines(), groups - int(doc.redoCount()) + 1);
+    while (doc.redoCount() > 0) {
+        doc.redo();
+        QVERIFY(undoManager->memoryUsage() <= usage / 2);
+    }
+    QCOMPARE(doc.text(), text);
+
+    // the most recent group is always kept
+    undoManager->setMemoryBudget(1);
+    QCOMPARE(doc.undoCount(), 1u);
+    doc.undo();
+    QCOMPARE(doc.redoCount(), 1u);
+}
+
 #include "moc_undomanager_test.cpp"
@@ -26,6 +26,8 @@ private Q_SLOTS:
     void testUndoWordWrapBug301367();
     void testUndoIndentBug373009();
     void testUndoAfterPastingWrappingLine();
+    void testCompressedUndoGroups();
+    void testUndoMemoryBudget();
 };
 
 #endif
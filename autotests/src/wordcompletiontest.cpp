@@ -6,8 +6,10 @@
 
 #include "wordcompletiontest.h"
 
+#include <kateconfig.h>
 #include <katedocument.h>
 #include <kateglobal.h>
+#include <kateview.h>
 #include <katewordcompletion.h>
 #include <ktexteditor/editor.h>
 #include <ktexteditor/view.h>
@@ -102,4 +104,78 @@ void WordCompletionTest::benchWordRetrievalDistinct()
     }
 }
 
+static QStringList sortedMatches(KateWordCompletionModel &model, KTextEditor::View *view)
+{
+    QStringList matches = model.allMatches(view, KTextEditor::Range::invalid());
+    matches.sort();
+    return matches;
+}
+
+void WordCompletionTest::testIncrementalIndex()
+{
+    m_doc->setText(QStringLiteral("alpha beta\ngamma delta\nepsilon"));
+    std::unique_ptr<KTextEditor::View> v(m_doc->createView(nullptr));
+    v->setCursorPosition({2, 0});
+
+    // keep one model alive, its index must follow all edits
+    KateWordCompletionModel model(nullptr);
+    QCOMPARE(sortedMatches(model, v.get()), QStringList({QStringLiteral("alpha"), QStringLiteral("beta"), QStringLiteral("delta"), QStringLiteral("gamma")}));
+
+    const auto verify = [&]() {
+        KateWordCompletionModel fresh(nullptr);
+        QCOMPARE(sortedMatches(model, v.get()), sortedMatches(fresh, v.get()));
+    };
+
+    m_doc->insertText({0, 5}, QStringLiteral("\nzeta eta\ntheta "));
+    verify();
+    m_doc->removeText(KTextEditor::Range(0, 3, 2, 2));
+    verify();
+    m_doc->insertText({1, 0}, QStringLiteral("iota_kappa "));
+    verify();
+    m_doc->removeText(KTextEditor::Range(0, 0, 1, 0));
+    verify();
+    m_doc->replaceText(KTextEditor::Range(0, 0, 0, 4), QStringLiteral("lambda"));
+    verify();
+    m_doc->undo();
+    m_doc->undo();
+    verify();
+    m_doc->insertLine(0, QStringLiteral("omicron"));
+    m_doc->removeLine(m_doc->lines() - 1);
+    verify();
+
+    // words vanish once their last occurrence is gone
+    m_doc->setText(QStringLiteral("alpha alpha\nbeta"));
+    v->setCursorPosition({1, 0});
+    QCOMPARE(sortedMatches(model, v.get()), QStringList({QStringLiteral("alpha")}));
+    m_doc->removeText(KTextEditor::Range(0, 0, 0, 6));
+    QCOMPARE(sortedMatches(model, v.get()), QStringList({QStringLiteral("alpha")}));
+    m_doc->removeText(KTextEditor::Range(0, 0, 0, 5));
+    QCOMPARE(sortedMatches(model, v.get()), QStringList());
+}
+
+void WordCompletionTest::testAllDocuments()
+{
+    m_doc->setText(QStringLiteral("alpha beta "));
+    std::unique_ptr<KTextEditor::Document> other(KTextEditor::Editor::instance()->createDocument(nullptr));
+    other->setText(QStringLiteral("gamma delta"));
+
+    std::unique_ptr<KTextEditor::View> v(m_doc->createView(nullptr));
+    v->setCursorPosition({0, 11});
+    auto config = static_cast<KTextEditor::ViewPrivate *>(v.get())->config();
+    KateWordCompletionModel model(nullptr);
+
+    config->setValue(KateViewConfig::WordCompletionAllDocuments, false);
+    QCOMPARE(sortedMatches(model, v.get()), QStringList({QStringLiteral("alpha"), QStringLiteral("beta")}));
+
+    config->setValue(KateViewConfig::WordCompletionAllDocuments, true);
+    QCOMPARE(sortedMatches(model, v.get()),
+             QStringList({QStringLiteral("alpha"), QStringLiteral("beta"), QStringLiteral("delta"), QStringLiteral("gamma")}));
+
+    // the index of a closed document is gone with it
+    other.reset();
+    QCOMPARE(sortedMatches(model, v.get()), QStringList({QStringLiteral("alpha"), QStringLiteral("beta")}));
+
+    config->setValue(KateViewConfig::WordCompletionAllDocuments, false);
+}
+
 #include "moc_wordcompletiontest.cpp"
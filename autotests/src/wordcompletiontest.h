@@ -24,6 +24,9 @@ private Q_SLOTS:
     void benchWordRetrievalSame();
     void benchWordRetrievalMixed();
 
+    void testIncrementalIndex();
+    void testAllDocuments();
+
 private:
     KTextEditor::Document *m_doc;
 };
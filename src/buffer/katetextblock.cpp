@@ -9,10 +9,38 @@
 #include "katetextcursor.h"
 #include "katetextrange.h"
 
+#include <algorithm>
+
 namespace Kate
 {
+namespace
+{
+/**
+ * Find the first cursor in a column sorted list of cursors with at least the given column.
+ */
+std::vector<TextCursor *>::iterator firstCursorAtOrBehind(std::vector<TextCursor *> &cursors, int column)
+{
+    return std::lower_bound(cursors.begin(), cursors.end(), column, [](const TextCursor *cursor, int column) {
+        return cursor->column() < column;
+    });
+}
+
+/**
+ * Merge the cursors to the column sorted list, keeps it sorted.
+ */
+void mergeCursors(std::vector<TextCursor *> &cursors, const std::vector<TextCursor *> &newCursors)
+{
+    const auto oldSize = cursors.size();
+    cursors.insert(cursors.end(), newCursors.begin(), newCursors.end());
+    std::inplace_merge(cursors.begin(), cursors.begin() + oldSize, cursors.end(), [](const TextCursor *left, const TextCursor *right) {
+        return left->column() < right->column();
+    });
+}
+}
+
 TextBlock::TextBlock(TextBuffer *buffer, int startLine)
     : m_buffer(buffer)
+    , m_validStartLines(&buffer->m_validStartLines)
     , m_startLine(startLine)
 {
     // reserve the block size
@@ -24,18 +52,24 @@ TextBlock::~TextBlock()
     // blocks should be empty before they are deleted!
     Q_ASSERT(m_blockSize == 0);
     Q_ASSERT(m_lines.empty());
-    Q_ASSERT(m_cursors.empty());
+    Q_ASSERT(m_cursorCount == 0);
 
     // it only is a hint for ranges for this block, not the storage of them
 }
 
-void TextBlock::setStartLine(int startLine)
+void TextBlock::setStartLine(int startLine, int blockIndex)
 {
     // allow only valid lines
     Q_ASSERT(startLine >= 0);
     Q_ASSERT(startLine < m_buffer->lines());
 
     m_startLine = startLine;
+    m_blockIndex = blockIndex;
+}
+
+void TextBlock::updateStartLine() const
+{
+    m_buffer->updateStartLines(this);
 }
 
 TextLine TextBlock::line(int line) const
@@ -70,6 +104,37 @@ void TextBlock::clearLines()
     m_blockSize = 0;
 }
 
+void TextBlock::insertCursor(Kate::TextCursor *cursor)
+{
+    const size_t line = cursor->m_line;
+    if (m_cursorsForLine.size() <= line) {
+        m_cursorsForLine.resize(line + 1);
+    }
+
+    // sort in behind all cursors with the same column
+    auto &cursors = m_cursorsForLine[line];
+    const auto it = std::upper_bound(cursors.begin(), cursors.end(), cursor->m_column, [](int column, const TextCursor *cursor) {
+        return column < cursor->column();
+    });
+    cursors.insert(it, cursor);
+    ++m_cursorCount;
+}
+
+void TextBlock::removeCursor(Kate::TextCursor *cursor)
+{
+    Q_ASSERT((size_t)cursor->m_line < m_cursorsForLine.size());
+    auto &cursors = m_cursorsForLine[cursor->m_line];
+
+    // search the cursor between all cursors with the same column
+    auto it = firstCursorAtOrBehind(cursors, cursor->m_column);
+    while (it != cursors.end() && *it != cursor) {
+        ++it;
+    }
+    Q_ASSERT(it != cursors.end());
+    cursors.erase(it);
+    --m_cursorCount;
+}
+
 void TextBlock::text(QString &text) const
 {
     // combine all lines
@@ -132,50 +197,50 @@ void TextBlock::wrapLine(const KTextEditor::Cursor position, int fixStartLinesSt
 
     // no cursors will leave or join this block
 
-    // no cursors in this block, no work to do..
-    if (m_cursors.empty()) {
+    // no cursors on the wrapped line or behind it, no work to do..
+    if (m_cursorCount == 0 || (size_t)line >= m_cursorsForLine.size()) {
         return;
     }
 
-    // move all cursors on the line which has the text inserted
     // remember all ranges modified, optimize for the standard case of a few ranges
     QVarLengthArray<TextRange *, 32> changedRanges;
-    for (TextCursor *cursor : m_cursors) {
-        // skip cursors on lines in front of the wrapped one!
-        if (cursor->lineInBlock() < line) {
-            continue;
+    auto rememberRange = [&changedRanges](TextCursor *cursor) {
+        // remember range, if any, avoid double insert
+        auto range = cursor->kateRange();
+        if (range && !range->isValidityCheckRequired()) {
+            range->setValidityCheckRequired();
+            changedRanges.push_back(range);
         }
+    };
 
-        // either this is simple, line behind the wrapped one
-        if (cursor->lineInBlock() > line) {
+    // cursors on lines behind the wrapped one just move down
+    for (size_t i = line + 1; i < m_cursorsForLine.size(); ++i) {
+        for (TextCursor *cursor : m_cursorsForLine[i]) {
             // patch line of cursor
             cursor->m_line++;
+            rememberRange(cursor);
         }
+    }
 
-        // this is the wrapped line
-        else {
-            // skip cursors with too small column
-            if (cursor->column() <= position.column()) {
-                if (cursor->column() < position.column() || !cursor->m_moveOnInsert) {
-                    continue;
-                }
-            }
-
-            // move cursor
-
-            // patch line of cursor
-            cursor->m_line++;
-
-            // patch column
-            cursor->m_column -= position.column();
-        }
+    // cursors on the wrapped line behind the position move to the new line
+    // cursors at the position stay if they don't move on insert, partition them in front
+    auto &wrappedCursors = m_cursorsForLine[line];
+    auto firstMoved = firstCursorAtOrBehind(wrappedCursors, position.column());
+    firstMoved = std::partition(firstMoved, firstCursorAtOrBehind(wrappedCursors, position.column() + 1), [](const TextCursor *cursor) {
+        return !cursor->m_moveOnInsert;
+    });
+    std::vector<TextCursor *> movedCursors(firstMoved, wrappedCursors.end());
+    wrappedCursors.erase(firstMoved, wrappedCursors.end());
+    for (TextCursor *cursor : movedCursors) {
+        // patch line and column of cursor, this keeps the order
+        cursor->m_line++;
+        cursor->m_column -= position.column();
+        rememberRange(cursor);
+    }
 
-        // remember range, if any, avoid double insert
-        auto range = cursor->kateRange();
-        if (range && !range->isValidityCheckRequired()) {
-            range->setValidityCheckRequired();
-            changedRanges.push_back(range);
-        }
+    // the new line needs its own entry if it got cursors or later lines have some
+    if (!movedCursors.empty() || (size_t)line + 1 < m_cursorsForLine.size()) {
+        m_cursorsForLine.insert(m_cursorsForLine.begin() + line + 1, std::move(movedCursors));
     }
 
     // we might need to invalidate ranges or notify about their changes
@@ -207,6 +272,10 @@ void TextBlock::unwrapLine(int line, TextBlock *previousBlock, int fixStartLines
         m_lines[0] = previousBlock->m_lines.back();
         previousBlock->m_lines.erase(previousBlock->m_lines.begin() + (previousBlock->lines() - 1));
 
+        // the characters of the moved line now belong to this block
+        previousBlock->m_blockSize -= m_lines[0].length();
+        m_blockSize += m_lines[0].length();
+
         const int oldSizeOfPreviousLine = m_lines[0].text().size();
         if (oldFirst.length() > 0) {
             // append text
@@ -216,12 +285,8 @@ void TextBlock::unwrapLine(int line, TextBlock *previousBlock, int fixStartLines
             m_lines[0].markAsModified(true);
         }
 
-        // patch startLine of this block
-        --m_startLine;
-
-        // fix all start lines
-        // we need to do this NOW, else the range update will FAIL!
-        // bug 313759
+        // fix all start lines, including the one of this block
+        // they are recomputed on next access, the range update below relies on that, bug 313759
         m_buffer->fixStartLines(fixStartLinesStartIndex);
 
         // notify the text history in advance
@@ -230,49 +295,47 @@ void TextBlock::unwrapLine(int line, TextBlock *previousBlock, int fixStartLines
         // cursor and range handling below
 
         // no cursors in this block and the previous one, no work to do..
-        if (m_cursors.empty() && previousBlock->m_cursors.empty()) {
+        if (m_cursorCount == 0 && previousBlock->m_cursorCount == 0) {
             return;
         }
 
-        // move all cursors because of the unwrapped line
         // remember all ranges modified, optimize for the standard case of a few ranges
         QVarLengthArray<TextRange *, 32> changedRanges;
-        for (TextCursor *cursor : m_cursors) {
-            // this is the unwrapped line
-            if (cursor->lineInBlock() == 0) {
+        auto rememberRange = [&changedRanges](TextCursor *cursor) {
+            // remember range, if any, avoid double insert
+            auto range = cursor->kateRange();
+            if (range && !range->isValidityCheckRequired()) {
+                range->setValidityCheckRequired();
+                changedRanges.push_back(range);
+            }
+        };
+
+        // move all cursors of the unwrapped line behind the text of the moved line
+        if (!m_cursorsForLine.empty()) {
+            for (TextCursor *cursor : m_cursorsForLine[0]) {
                 // patch column
                 cursor->m_column += oldSizeOfPreviousLine;
-
-                // remember range, if any, avoid double insert
-                auto range = cursor->kateRange();
-                if (range && !range->isValidityCheckRequired()) {
-                    range->setValidityCheckRequired();
-                    changedRanges.push_back(range);
-                }
+                rememberRange(cursor);
             }
         }
 
         // move cursors of the moved line from previous block to this block now
-        for (auto it = previousBlock->m_cursors.begin(); it != previousBlock->m_cursors.end();) {
-            auto cursor = *it;
-            if (cursor->lineInBlock() == lastLineOfPreviousBlock) {
+        if ((size_t)lastLineOfPreviousBlock < previousBlock->m_cursorsForLine.size()) {
+            const std::vector<TextCursor *> movedCursors = std::move(previousBlock->m_cursorsForLine[lastLineOfPreviousBlock]);
+            previousBlock->m_cursorsForLine.erase(previousBlock->m_cursorsForLine.begin() + lastLineOfPreviousBlock);
+            previousBlock->m_cursorCount -= movedCursors.size();
+
+            for (TextCursor *cursor : movedCursors) {
                 cursor->m_line = 0;
                 cursor->m_block = this;
-                m_cursors.insert(cursor);
-
-                // remember range, if any, avoid double insert
-                auto range = cursor->kateRange();
-                if (range && !range->isValidityCheckRequired()) {
-                    range->setValidityCheckRequired();
-                    changedRanges.push_back(range);
-                }
-
-                // remove from previous block
-                it = previousBlock->m_cursors.erase(it);
-            } else {
-                // keep in previous block
-                ++it;
+                rememberRange(cursor);
+            }
+
+            if (m_cursorsForLine.empty()) {
+                m_cursorsForLine.resize(1);
             }
+            mergeCursors(m_cursorsForLine[0], movedCursors);
+            m_cursorCount += movedCursors.size();
         }
 
         // fixup the ranges that might be effected, because they moved from last line to this block
@@ -317,36 +380,41 @@ void TextBlock::unwrapLine(int line, TextBlock *previousBlock, int fixStartLines
 
     // cursor and range handling below
 
-    // no cursors in this block, no work to do..
-    if (m_cursors.empty()) {
+    // no cursors on the unwrapped line or behind it, no work to do..
+    if (m_cursorCount == 0 || (size_t)line >= m_cursorsForLine.size()) {
         return;
     }
 
-    // move all cursors because of the unwrapped line
     // remember all ranges modified, optimize for the standard case of a few ranges
     QVarLengthArray<TextRange *, 32> changedRanges;
-    for (TextCursor *cursor : m_cursors) {
-        // skip cursors in lines in front of removed one
-        if (cursor->lineInBlock() < line) {
-            continue;
-        }
-
-        // this is the unwrapped line
-        if (cursor->lineInBlock() == line) {
-            // patch column
-            cursor->m_column += oldSizeOfPreviousLine;
-        }
-
-        // patch line of cursor
-        cursor->m_line--;
-
+    auto rememberRange = [&changedRanges](TextCursor *cursor) {
         // remember range, if any, avoid double insert
         auto range = cursor->kateRange();
         if (range && !range->isValidityCheckRequired()) {
             range->setValidityCheckRequired();
             changedRanges.push_back(range);
         }
+    };
+
+    // cursors on lines behind the unwrapped one just move up
+    for (size_t i = line + 1; i < m_cursorsForLine.size(); ++i) {
+        for (TextCursor *cursor : m_cursorsForLine[i]) {
+            // patch line of cursor
+            cursor->m_line--;
+            rememberRange(cursor);
+        }
+    }
+
+    // cursors of the unwrapped line move behind the text of the previous line
+    const std::vector<TextCursor *> movedCursors = std::move(m_cursorsForLine[line]);
+    m_cursorsForLine.erase(m_cursorsForLine.begin() + line);
+    for (TextCursor *cursor : movedCursors) {
+        // patch line and column of cursor
+        cursor->m_line--;
+        cursor->m_column += oldSizeOfPreviousLine;
+        rememberRange(cursor);
     }
+    mergeCursors(m_cursorsForLine[line - 1], movedCursors);
 
     // we might need to invalidate ranges or notify about their changes
     // checkValidity might trigger delete of the range!
@@ -384,26 +452,23 @@ void TextBlock::insertText(const KTextEditor::Cursor position, const QString &te
 
     // cursor and range handling below
 
-    // no cursors in this block, no work to do..
-    if (m_cursors.empty()) {
+    // no cursors on this line, no work to do..
+    if (m_cursorCount == 0 || (size_t)line >= m_cursorsForLine.size()) {
         return;
     }
 
-    // move all cursors on the line which has the text inserted
+    // move all cursors on the line which has the text inserted, skip cursors with too small column
+    // cursors at the position stay if they don't move on insert, partition them in front to keep the order
+    auto &cursors = m_cursorsForLine[line];
+    auto firstMoved = firstCursorAtOrBehind(cursors, position.column());
+    firstMoved = std::partition(firstMoved, firstCursorAtOrBehind(cursors, position.column() + 1), [](const TextCursor *cursor) {
+        return !cursor->m_moveOnInsert;
+    });
+
     // remember all ranges modified, optimize for the standard case of a few ranges
     QVarLengthArray<TextRange *, 32> changedRanges;
-    for (TextCursor *cursor : m_cursors) {
-        // skip cursors not on this line!
-        if (cursor->lineInBlock() != line) {
-            continue;
-        }
-
-        // skip cursors with too small column
-        if (cursor->column() <= position.column()) {
-            if (cursor->column() < position.column() || !cursor->m_moveOnInsert) {
-                continue;
-            }
-        }
+    for (auto it = firstMoved; it != cursors.end(); ++it) {
+        TextCursor *cursor = *it;
 
         // patch column of cursor
         if (cursor->m_column <= oldLength) {
@@ -460,24 +525,17 @@ void TextBlock::removeText(KTextEditor::Range range, QString &removedText)
 
     // cursor and range handling below
 
-    // no cursors in this block, no work to do..
-    if (m_cursors.empty()) {
+    // no cursors on this line, no work to do..
+    if (m_cursorCount == 0 || (size_t)line >= m_cursorsForLine.size()) {
         return;
     }
 
-    // move all cursors on the line which has the text removed
+    // move all cursors on the line which has the text removed, skip cursors with too small column
     // remember all ranges modified, optimize for the standard case of a few ranges
+    auto &cursors = m_cursorsForLine[line];
     QVarLengthArray<TextRange *, 32> changedRanges;
-    for (TextCursor *cursor : m_cursors) {
-        // skip cursors not on this line!
-        if (cursor->lineInBlock() != line) {
-            continue;
-        }
-
-        // skip cursors with too small column
-        if (cursor->column() <= range.start().column()) {
-            continue;
-        }
+    for (auto it = firstCursorAtOrBehind(cursors, range.start().column() + 1); it != cursors.end(); ++it) {
+        TextCursor *cursor = *it;
 
         // patch column of cursor
         if (cursor->column() <= range.end().column()) {
@@ -520,7 +578,10 @@ TextBlock *TextBlock::splitBlock(int fromLine)
     int linesOfNewBlock = lines() - fromLine;
 
     // create and insert new block
+    // it is not yet part of the buffer, mark its start line as trusted for the range updates below,
+    // the buffer sets its real index once it is inserted
     TextBlock *newBlock = new TextBlock(m_buffer, startLine() + fromLine);
+    newBlock->m_blockIndex = -1;
 
     // move lines
     newBlock->m_lines.reserve(linesOfNewBlock);
@@ -534,19 +595,19 @@ TextBlock *TextBlock::splitBlock(int fromLine)
     m_lines.resize(fromLine);
 
     // move cursors
-    for (auto it = m_cursors.begin(); it != m_cursors.end();) {
-        auto cursor = *it;
-        if (cursor->lineInBlock() >= fromLine) {
+    for (size_t i = fromLine; i < m_cursorsForLine.size(); ++i) {
+        for (TextCursor *cursor : m_cursorsForLine[i]) {
             cursor->m_line = cursor->lineInBlock() - fromLine;
             cursor->m_block = newBlock;
-
-            // add to new, remove from current
-            newBlock->m_cursors.insert(cursor);
-            it = m_cursors.erase(it);
-        } else {
-            // keep in current
-            ++it;
         }
+
+        // add to new, remove from current
+        newBlock->m_cursorsForLine.push_back(std::move(m_cursorsForLine[i]));
+        newBlock->m_cursorCount += newBlock->m_cursorsForLine.back().size();
+    }
+    if ((size_t)fromLine < m_cursorsForLine.size()) {
+        m_cursorsForLine.resize(fromLine);
+        m_cursorCount -= newBlock->m_cursorCount;
     }
 
     // fix ALL ranges!
@@ -556,7 +617,9 @@ TextBlock *TextBlock::splitBlock(int fromLine)
     std::for_each(m_cachedLineForRanges.keyBegin(), m_cachedLineForRanges.keyEnd(), [&allRanges](TextRange *range) {
         allRanges.push_back(range);
     });
-    allRanges.insert(allRanges.end(), m_uncachedRanges.begin(), m_uncachedRanges.end());
+    for (const auto &entry : m_uncachedRanges) {
+        allRanges.push_back(entry.range);
+    }
     for (TextRange *range : allRanges) {
         // update both blocks
         updateRange(range);
@@ -570,12 +633,20 @@ TextBlock *TextBlock::splitBlock(int fromLine)
 void TextBlock::mergeBlock(TextBlock *targetBlock)
 {
     // move cursors, do this first, now still lines() count is correct for target
-    for (TextCursor *cursor : m_cursors) {
-        cursor->m_line = cursor->lineInBlock() + targetBlock->lines();
-        cursor->m_block = targetBlock;
-        targetBlock->m_cursors.insert(cursor);
+    if (!m_cursorsForLine.empty()) {
+        Q_ASSERT(targetBlock->m_cursorsForLine.size() <= (size_t)targetBlock->lines());
+        targetBlock->m_cursorsForLine.resize(targetBlock->lines());
+        for (auto &cursors : m_cursorsForLine) {
+            for (TextCursor *cursor : cursors) {
+                cursor->m_line = cursor->lineInBlock() + targetBlock->lines();
+                cursor->m_block = targetBlock;
+            }
+            targetBlock->m_cursorsForLine.push_back(std::move(cursors));
+        }
+        targetBlock->m_cursorCount += m_cursorCount;
+        m_cursorsForLine.clear();
+        m_cursorCount = 0;
     }
-    m_cursors.clear();
 
     // move lines
     targetBlock->m_lines.reserve(targetBlock->lines() + lines());
@@ -592,7 +663,9 @@ void TextBlock::mergeBlock(TextBlock *targetBlock)
     std::for_each(m_cachedLineForRanges.keyBegin(), m_cachedLineForRanges.keyEnd(), [&allRanges](TextRange *range) {
         allRanges.push_back(range);
     });
-    allRanges.insert(allRanges.end(), m_uncachedRanges.begin(), m_uncachedRanges.end());
+    for (const auto &entry : m_uncachedRanges) {
+        allRanges.push_back(entry.range);
+    }
     for (TextRange *range : allRanges) {
         // update both blocks
         updateRange(range);
@@ -603,20 +676,17 @@ void TextBlock::mergeBlock(TextBlock *targetBlock)
 void TextBlock::deleteBlockContent()
 {
     // kill cursors, if not belonging to a range
-    // we can do in-place editing of the current set of cursors as
-    // we remove them before deleting
-    for (auto it = m_cursors.begin(); it != m_cursors.end();) {
-        auto cursor = *it;
-        if (!cursor->kateRange()) {
-            // remove it and advance to next element
-            it = m_cursors.erase(it);
-
-            // delete after cursor is gone from the set
-            // else the destructor will modify it!
+    // we remove them from the lists before deleting, else the destructor will modify them!
+    for (auto &cursors : m_cursorsForLine) {
+        const auto firstKilled = std::stable_partition(cursors.begin(), cursors.end(), [](const TextCursor *cursor) {
+            return cursor->kateRange();
+        });
+        const std::vector<TextCursor *> killedCursors(firstKilled, cursors.end());
+        cursors.erase(firstKilled, cursors.end());
+        m_cursorCount -= killedCursors.size();
+        for (TextCursor *cursor : killedCursors) {
+            cursor->m_block = nullptr;
             delete cursor;
-        } else {
-            // keep this cursor
-            ++it;
         }
     }
 
@@ -627,21 +697,19 @@ void TextBlock::deleteBlockContent()
 void TextBlock::clearBlockContent(TextBlock *targetBlock)
 {
     // move cursors, if not belonging to a range
-    // we can do in-place editing of the current set of cursors
-    for (auto it = m_cursors.begin(); it != m_cursors.end();) {
-        auto cursor = *it;
-        if (!cursor->kateRange()) {
+    for (auto &cursors : m_cursorsForLine) {
+        const auto firstMoved = std::stable_partition(cursors.begin(), cursors.end(), [](const TextCursor *cursor) {
+            return cursor->kateRange();
+        });
+        for (auto it = firstMoved; it != cursors.end(); ++it) {
+            TextCursor *cursor = *it;
             cursor->m_column = 0;
             cursor->m_line = 0;
             cursor->m_block = targetBlock;
-            targetBlock->m_cursors.insert(cursor);
-
-            // remove it and advance to next element
-            it = m_cursors.erase(it);
-        } else {
-            // keep this cursor
-            ++it;
+            targetBlock->insertCursor(cursor);
         }
+        m_cursorCount -= cursors.end() - firstMoved;
+        cursors.erase(firstMoved, cursors.end());
     }
 
     // kill lines
@@ -687,7 +755,72 @@ void TextBlock::rangesForLine(int line, KTextEditor::View *view, bool rangesWith
     if (cachedRanges) {
         std::copy_if(cachedRanges->begin(), cachedRanges->end(), std::back_inserter(outRanges), predicate);
     }
-    std::copy_if(m_uncachedRanges.begin(), m_uncachedRanges.end(), std::back_inserter(outRanges), predicate);
+
+    if (m_uncachedRanges.empty()) {
+        return;
+    }
+
+    // rebuild the subtree maxima of the interval tree after changes
+    if (m_uncachedMaxEnd.size() != m_uncachedRanges.size()) {
+        m_uncachedMaxEnd.resize(m_uncachedRanges.size());
+        updateUncachedMaxEnd(0, m_uncachedRanges.size());
+    }
+
+    // only visit the multi-line ranges containing the line, then filter them like the cached ones
+    const auto firstUncached = outRanges.size();
+    collectUncachedRanges(0, m_uncachedRanges.size(), line - startLine(), outRanges);
+    outRanges.erase(std::remove_if(outRanges.begin() + firstUncached,
+                                   outRanges.end(),
+                                   [&predicate](TextRange *range) {
+                                       return !predicate(range);
+                                   }),
+                    outRanges.end());
+}
+
+std::vector<TextBlock::UncachedRange>::iterator TextBlock::findUncachedRange(TextRange *range, int start)
+{
+    auto it = std::lower_bound(m_uncachedRanges.begin(), m_uncachedRanges.end(), start, [range](const UncachedRange &entry, int start) {
+        return entry.start < start || (entry.start == start && std::less<TextRange *>()(entry.range, range));
+    });
+    Q_ASSERT(it != m_uncachedRanges.end() && it->range == range);
+    return it;
+}
+
+int TextBlock::updateUncachedMaxEnd(size_t begin, size_t end) const
+{
+    if (begin >= end) {
+        return std::numeric_limits<int>::min();
+    }
+
+    const size_t middle = begin + (end - begin) / 2;
+    const int maxEnd = std::max({m_uncachedRanges[middle].end, updateUncachedMaxEnd(begin, middle), updateUncachedMaxEnd(middle + 1, end)});
+    m_uncachedMaxEnd[middle] = maxEnd;
+    return maxEnd;
+}
+
+void TextBlock::collectUncachedRanges(size_t begin, size_t end, int line, QList<TextRange *> &outRanges) const
+{
+    if (begin >= end) {
+        return;
+    }
+
+    // nothing in this subtree reaches the line
+    const size_t middle = begin + (end - begin) / 2;
+    if (m_uncachedMaxEnd[middle] < line) {
+        return;
+    }
+
+    collectUncachedRanges(begin, middle, line, outRanges);
+
+    // the right subtree only contains ranges starting behind the middle one
+    const UncachedRange &entry = m_uncachedRanges[middle];
+    if (entry.start > line) {
+        return;
+    }
+    if (line <= entry.end) {
+        outRanges.push_back(entry.range);
+    }
+    collectUncachedRanges(middle + 1, end, line, outRanges);
 }
 
 void TextBlock::markModifiedLinesAsSaved()
@@ -702,13 +835,15 @@ void TextBlock::markModifiedLinesAsSaved()
 
 void TextBlock::updateRange(TextRange *range)
 {
+    const int blockStartLine = this->startLine();
+
     // get some simple facts about our nice range
     const int startLine = range->startInternal().lineInternal();
     const int endLine = range->endInternal().lineInternal();
     const bool isSingleLine = startLine == endLine;
 
     // perhaps remove range and be done
-    if ((endLine < m_startLine) || (startLine >= (m_startLine + lines()))) {
+    if ((endLine < blockStartLine) || (startLine >= (blockStartLine + lines()))) {
         removeRange(range);
         return;
     }
@@ -716,14 +851,27 @@ void TextBlock::updateRange(TextRange *range)
     // The range is still a single-line range, and is still cached to the correct line.
     if (isSingleLine) {
         auto it = m_cachedLineForRanges.find(range);
-        if (it != m_cachedLineForRanges.end() && it.value() == startLine - m_startLine) {
+        if (it != m_cachedLineForRanges.end() && it.value() == startLine - blockStartLine) {
             return;
         }
     }
 
-    // The range is still a multi-line range, and is already in the correct set.
-    if (!isSingleLine && m_uncachedRanges.contains(range)) {
-        return;
+    // The range spans multiple lines, compute its interval relative to this block.
+    // Endpoints outside of the block are clamped, they can't move without an update.
+    const int uncachedStart = std::max(startLine - blockStartLine, -1);
+    const int uncachedEnd = (endLine - blockStartLine >= lines()) ? std::numeric_limits<int>::max() : (endLine - blockStartLine);
+
+    // The range is still a multi-line range with the same start, just adjust its end.
+    if (!isSingleLine) {
+        auto it = m_uncachedStartForRanges.find(range);
+        if (it != m_uncachedStartForRanges.end() && it.value() == uncachedStart) {
+            auto entry = findUncachedRange(range, uncachedStart);
+            if (entry->end != uncachedEnd) {
+                entry->end = uncachedEnd;
+                m_uncachedMaxEnd.clear();
+            }
+            return;
+        }
     }
 
     // remove, if already there!
@@ -731,13 +879,19 @@ void TextBlock::updateRange(TextRange *range)
 
     // simple case: multi-line range
     if (!isSingleLine) {
-        // The range cannot be cached per line, as it spans multiple lines
-        m_uncachedRanges.append(range);
+        // The range cannot be cached per line, as it spans multiple lines, keep the index sorted
+        const UncachedRange entry{uncachedStart, uncachedEnd, range};
+        auto it = std::lower_bound(m_uncachedRanges.begin(), m_uncachedRanges.end(), entry, [](const UncachedRange &a, const UncachedRange &b) {
+            return a.start < b.start || (a.start == b.start && std::less<TextRange *>()(a.range, b.range));
+        });
+        m_uncachedRanges.insert(it, entry);
+        m_uncachedStartForRanges.insert(range, uncachedStart);
+        m_uncachedMaxEnd.clear();
         return;
     }
 
     // The range is contained by a single line, put it into the line-cache
-    const int lineOffset = startLine - m_startLine;
+    const int lineOffset = startLine - blockStartLine;
 
     // enlarge cache if needed
     if (m_cachedRangesForLine.size() <= (size_t)lineOffset) {
@@ -754,9 +908,11 @@ void TextBlock::updateRange(TextRange *range)
 void TextBlock::removeRange(TextRange *range)
 {
     // uncached range? remove it and be done
-    int pos = m_uncachedRanges.indexOf(range);
-    if (pos != -1) {
-        m_uncachedRanges.remove(pos);
+    auto uncachedIt = m_uncachedStartForRanges.find(range);
+    if (uncachedIt != m_uncachedStartForRanges.end()) {
+        m_uncachedRanges.erase(findUncachedRange(range, uncachedIt.value()));
+        m_uncachedStartForRanges.erase(uncachedIt);
+        m_uncachedMaxEnd.clear();
         // must be only uncached!
         Q_ASSERT(m_cachedLineForRanges.find(range) == m_cachedLineForRanges.end());
         return;
@@ -766,7 +922,7 @@ void TextBlock::removeRange(TextRange *range)
     auto it = m_cachedLineForRanges.find(range);
     if (it != m_cachedLineForRanges.end()) {
         // must be only cached!
-        Q_ASSERT(!m_uncachedRanges.contains(range));
+        Q_ASSERT(!m_uncachedStartForRanges.contains(range));
 
         int line = it.value();
 
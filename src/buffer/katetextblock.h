@@ -9,13 +9,16 @@
 
 #include "katetextline.h"
 
+#include <QHash>
 #include <QList>
-#include <QSet>
 #include <QVarLengthArray>
 
 #include <ktexteditor/cursor.h>
 #include <ktexteditor_export.h>
 
+#include <limits>
+#include <vector>
+
 namespace KTextEditor
 {
 class View;
@@ -49,18 +52,25 @@ public:
 
     /**
      * Start line of this block.
+     * The buffer fixes start lines lazily after edits, blocks behind the last edit get fixed on first access.
+     * This modifies the shared start line state of the buffer, only call it from the GUI thread.
      * @return start line of this block
      */
     int startLine() const
     {
+        if (m_blockIndex >= *m_validStartLines) {
+            updateStartLine();
+        }
         return m_startLine;
     }
 
     /**
-     * Set start line of this block.
+     * Set start line of this block and its index in the buffer.
+     * Done by the buffer when it fixes the start lines.
      * @param startLine new start line of this block
+     * @param blockIndex index of this block in the buffer
      */
-    void setStartLine(int startLine);
+    void setStartLine(int startLine, int blockIndex);
 
     /**
      * Retrieve a text line.
@@ -87,6 +97,18 @@ public:
         return m_lines[line - startLine()].length();
     }
 
+    /**
+     * Retrieve the text of @p line by reference, cheaper than copying the whole line().
+     * The reference is only valid until the next change of the buffer.
+     * @param line wanted line number
+     * @return text of the line
+     */
+    const QString &lineText(int line) const
+    {
+        Q_ASSERT(line >= startLine() && (line - startLine()) < lines());
+        return m_lines[line - startLine()].text();
+    }
+
     /**
      * Append a new line with given text.
      * @param textOfLine text of the line to append
@@ -194,7 +216,7 @@ public:
      */
     bool containsRange(TextRange *range) const
     {
-        return m_cachedLineForRanges.find(range) != m_cachedLineForRanges.end() || m_uncachedRanges.contains(range);
+        return m_cachedLineForRanges.find(range) != m_cachedLineForRanges.end() || m_uncachedStartForRanges.contains(range);
     }
 
     /**
@@ -204,21 +226,17 @@ public:
 
     /**
      * Insert cursor into this block.
+     * The cursor's line and column must already be set, it is sorted in by them.
      * @param cursor cursor to insert
      */
-    void insertCursor(Kate::TextCursor *cursor)
-    {
-        m_cursors.insert(cursor);
-    }
+    void insertCursor(Kate::TextCursor *cursor);
 
     /**
      * Remove cursor from this block.
+     * The cursor's line and column must be unchanged since it was inserted.
      * @param cursor cursor to remove
      */
-    void removeCursor(Kate::TextCursor *cursor)
-    {
-        m_cursors.remove(cursor);
-    }
+    void removeCursor(Kate::TextCursor *cursor);
 
     /**
      * Update a range from this block.
@@ -251,7 +269,7 @@ private:
      */
     const QVarLengthArray<TextRange *, 6> *cachedRangesForLine(int line) const
     {
-        line -= m_startLine;
+        line -= startLine();
         if (line >= 0 && (size_t)line < m_cachedRangesForLine.size()) {
             return &m_cachedRangesForLine[line];
         } else {
@@ -259,12 +277,55 @@ private:
         }
     }
 
+    /**
+     * Let the buffer fix the start lines up to this block.
+     * Out of line slow path of startLine().
+     */
+    KTEXTEDITOR_EXPORT void updateStartLine() const;
+
+    /**
+     * Entry of the interval index for ranges spanning multiple lines.
+     * Lines are relative to the block start, endpoints in front of or behind the
+     * block are clamped to -1 and the maximal int, they stay valid if only other lines change.
+     */
+    struct UncachedRange {
+        int start;
+        int end;
+        TextRange *range;
+    };
+
+    /**
+     * Find the entry of the given uncached range, it must be in the index.
+     * @param range range to search
+     * @param start start line the range is stored with
+     * @return iterator to the entry
+     */
+    KTEXTEDITOR_NO_EXPORT std::vector<UncachedRange>::iterator findUncachedRange(TextRange *range, int start);
+
+    /**
+     * Compute the maximal end line for the subtree of the implicit interval tree
+     * formed by the uncached ranges in [begin, end), its root is the middle element.
+     * @return maximal end line of the subtree
+     */
+    KTEXTEDITOR_NO_EXPORT int updateUncachedMaxEnd(size_t begin, size_t end) const;
+
+    /**
+     * Append all uncached ranges in [begin, end) that contain the given line relative to the block.
+     * Visits only subtrees that may contain matches, O(log n + k).
+     */
+    KTEXTEDITOR_NO_EXPORT void collectUncachedRanges(size_t begin, size_t end, int line, QList<TextRange *> &outRanges) const;
+
 private:
     /**
      * parent text buffer
      */
     TextBuffer *m_buffer;
 
+    /**
+     * Number of blocks with up-to-date start line in the parent buffer.
+     */
+    const int *m_validStartLines;
+
     /**
      * Lines contained in this buffer.
      * We need no sharing, use STL.
@@ -276,16 +337,29 @@ private:
      */
     int m_startLine;
 
+    /**
+     * Index of this block in the buffer, only up-to-date if smaller than the number of valid start lines.
+     * -1 for a block split off that is not yet inserted into the buffer, its start line is trusted.
+     * Blocks with unknown index use the maximal value, their start line will be computed on access.
+     */
+    int m_blockIndex = std::numeric_limits<int>::max();
+
     /**
      * size of block i.e., number of QChars
      */
     int m_blockSize = 0;
 
     /**
-     * Set of cursors for this block.
-     * using QSet is better than unordered_set for perf reasons
+     * Cursors of this block, for each line-offset sorted by column.
+     * Edits only need to visit the cursors of the changed line behind the edit position.
+     * Lines behind the end of the vector contain no cursors.
      */
-    QSet<TextCursor *> m_cursors;
+    std::vector<std::vector<TextCursor *>> m_cursorsForLine;
+
+    /**
+     * Number of cursors in m_cursorsForLine.
+     */
+    int m_cursorCount = 0;
 
     /**
      * Contains for each line-offset the ranges that were cached into it.
@@ -299,9 +373,21 @@ private:
     QHash<TextRange *, int> m_cachedLineForRanges;
 
     /**
-     * This contains all the ranges that are not cached.
+     * This contains all the ranges that are not cached, they span multiple lines.
+     * Sorted by start line and pointer, the vector is an implicit balanced interval tree.
+     */
+    std::vector<UncachedRange> m_uncachedRanges;
+
+    /**
+     * Maximal end line for each node of the implicit interval tree over m_uncachedRanges.
+     * Cleared on changes and rebuilt by the next query.
+     */
+    mutable std::vector<int> m_uncachedMaxEnd;
+
+    /**
+     * Maps for each uncached range the start line it is sorted in with.
      */
-    QVarLengthArray<TextRange *, 1> m_uncachedRanges;
+    QHash<TextRange *, int> m_uncachedStartForRanges;
 };
 
 }
@@ -8,6 +8,7 @@
 
 #include "katetextbuffer.h"
 #include "katetextloader.h"
+#include "katetextscanner.h"
 
 #include "katedocument.h"
 
@@ -24,12 +25,17 @@
 #define CAN_USE_ERRNO
 #endif
 
+#include <algorithm>
+#include <cstring>
+
 #include <QBuffer>
 #include <QCryptographicHash>
 #include <QFile>
 #include <QFileInfo>
 #include <QStringEncoder>
 #include <QTemporaryFile>
+#include <QThread>
+#include <QThreadPool>
 
 #if HAVE_KAUTH
 #include "katesecuretextbuffer_p.h"
@@ -47,6 +53,133 @@
 
 namespace Kate
 {
+namespace
+{
+/**
+ * Init the given hash with the header of a git compatible checksum.
+ * @param digest hash to init, must be fresh
+ * @param size size of the file in bytes
+ */
+void addDigestHeader(QCryptographicHash &digest, qint64 size)
+{
+    const QString header = QStringLiteral("blob %1").arg(size);
+    digest.addData(QByteArray(header.toLatin1() + '\0'));
+}
+
+/**
+ * String to write for the given end of line mode.
+ */
+QString endOfLineString(TextBuffer::EndOfLineMode mode)
+{
+    if (mode == TextBuffer::eolDos) {
+        return QStringLiteral("\r\n");
+    } else if (mode == TextBuffer::eolMac) {
+        return QStringLiteral("\r");
+    }
+    return QStringLiteral("\n");
+}
+
+/**
+ * One chunk of a memory mapped file, decoded and split into blocks by one task of the parallel loader.
+ */
+struct MappedChunk {
+    const char *data = nullptr;
+    qsizetype size = 0;
+    bool isLastChunk = false;
+
+    // results of loadMappedChunk
+    std::vector<TextBlock *> blocks;
+    int lines = 0;
+    bool encodingError = false;
+    bool foundLf = false;
+    bool foundCrLf = false;
+    bool foundCr = false;
+    bool tooLongLinesWrapped = false;
+    int longestLineLoaded = 0;
+};
+
+/**
+ * Decode the given chunk as UTF-8 and split it into lines and blocks.
+ * Mirrors the line splitting and line length limit handling of TextLoader::readLine.
+ * Chunks always end after a line feed, beside the last one, therefore only the last chunk has a trailing line.
+ */
+void loadMappedChunk(TextBuffer *buffer, MappedChunk &chunk, int lineLengthLimit)
+{
+    QStringDecoder decoder(QStringConverter::Utf8, QStringConverter::Flag::ConvertInitialBom);
+    const QString text = decoder.decode(QByteArrayView(chunk.data, chunk.size));
+    if (decoder.hasError()) {
+        chunk.encodingError = true;
+        return;
+    }
+
+    // we know the number of lines ahead, beside wrapped ones
+    chunk.blocks.reserve(TextScanner::countLineTerminators(text.unicode(), text.size()) / BufferBlockSize + 1);
+
+    const auto appendLine = [buffer, &chunk, &text](qsizetype start, qsizetype length) {
+        if (chunk.blocks.empty() || chunk.blocks.back()->lines() >= BufferBlockSize) {
+            chunk.blocks.push_back(new TextBlock(buffer, 0));
+        }
+        chunk.blocks.back()->appendLine(QString(text.constData() + start, length));
+        ++chunk.lines;
+    };
+
+    // honor the line length limit, same wrapping as the TextLoader does
+    const auto appendLineWrapped = [&chunk, &text, &appendLine, lineLengthLimit](qsizetype start, qsizetype length) {
+        while (lineLengthLimit > 0 && length > lineLengthLimit) {
+            chunk.tooLongLinesWrapped = true;
+            chunk.longestLineLoaded = std::max(chunk.longestLineLoaded, static_cast<int>(length));
+
+            // search for place to wrap
+            int spacePosition = lineLengthLimit - 1;
+            for (int testPosition = lineLengthLimit - 1; (testPosition >= 0) && (testPosition >= (lineLengthLimit - (lineLengthLimit / 10)));
+                 --testPosition) {
+                if (text[start + testPosition].isSpace() || text[start + testPosition].isPunct()) {
+                    spacePosition = testPosition;
+                    break;
+                }
+            }
+
+            appendLine(start, spacePosition + 1);
+            start += spacePosition + 1;
+            length -= spacePosition + 1;
+        }
+        appendLine(start, length);
+    };
+
+    const qsizetype size = text.size();
+    qsizetype lineStart = 0;
+    for (qsizetype position = TextScanner::findLineTerminator(text.unicode(), 0, size); position < size;
+         position = TextScanner::findLineTerminator(text.unicode(), position + 1, size)) {
+        const QChar c = text[position];
+        if (c == QLatin1Char('\n')) {
+            chunk.foundLf = true;
+            appendLineWrapped(lineStart, position - lineStart);
+            lineStart = position + 1;
+        } else if (c == QLatin1Char('\r')) {
+            appendLineWrapped(lineStart, position - lineStart);
+            if ((position + 1) < size && text[position + 1] == QLatin1Char('\n')) {
+                chunk.foundCrLf = true;
+                ++position;
+            } else {
+                chunk.foundCr = true;
+            }
+            lineStart = position + 1;
+        } else {
+            Q_ASSERT(c == QChar::LineSeparator);
+            appendLineWrapped(lineStart, position - lineStart);
+            lineStart = position + 1;
+        }
+    }
+
+    // the last chunk always has a last line, even if empty
+    if (chunk.isLastChunk) {
+        appendLineWrapped(lineStart, size - lineStart);
+    } else {
+        Q_ASSERT(lineStart == size);
+    }
+}
+}
+
 TextBuffer::TextBuffer(KTextEditor::DocumentPrivate *parent, bool alwaysUseKAuth)
     : QObject(parent)
     , m_document(parent)
@@ -131,6 +264,7 @@ void TextBuffer::clear()
 
     // reset lines and last used block
     m_lines = 1;
+    resetBlockOffsets();
 
     // reset revision
     m_revision = 0;
@@ -166,59 +300,81 @@ void TextBuffer::setLineMetaData(int line, const TextLine &textLine)
     return m_blocks.at(blockIndex)->setLineMetaData(line, textLine);
 }
 
-int TextBuffer::cursorToOffset(KTextEditor::Cursor c) const
+qsizetype TextBuffer::cursorToOffset(KTextEditor::Cursor c) const
 {
-    if (!c.isValid() || c > document()->documentEnd()) {
+    // invalid or behind the document end
+    if (!c.isValid() || c.line() >= m_lines || (c.line() == m_lines - 1 && c.column() > lineLength(c.line()))) {
         return -1;
     }
 
-    int off = 0;
-    int line = 0;
-    for (auto block : m_blocks) {
-        if (block->startLine() + block->lines() < c.line()) {
-            off += block->blockSize();
-            line += block->lines();
-        } else {
-            const int lines = block->lines();
-            for (int i = 0; i < lines; ++i) {
-                if (line >= c.line()) {
-                    off += qMin(c.column(), block->lineLength(line));
-                    return off;
-                }
-                off += block->lineLength(line) + 1;
-                line++;
-            }
-        }
+    // start at the offset of the block, then walk the lines inside the block
+    const int blockIndex = blockForLine(c.line());
+    updateBlockOffsets(blockIndex);
+    const TextBlock *block = m_blocks.at(blockIndex);
+    qsizetype off = m_blockOffsets[blockIndex];
+    for (int line = block->startLine(); line < c.line(); ++line) {
+        off += block->lineLength(line) + 1;
     }
-
-    Q_ASSERT(false);
-    return -1;
+    return off + qMin(c.column(), block->lineLength(c.line()));
 }
 
-KTextEditor::Cursor TextBuffer::offsetToCursor(int offset) const
+KTextEditor::Cursor TextBuffer::offsetToCursor(qsizetype offset) const
 {
-    if (offset >= 0) {
-        int off = 0;
-        for (auto block : m_blocks) {
-            if (off + block->blockSize() < offset) {
-                off += block->blockSize();
-            } else {
-                const int lines = block->lines();
-                int start = block->startLine();
-                int end = start + lines;
-                for (int line = start; line < end; ++line) {
-                    const int len = block->lineLength(line);
-                    if (off + len >= offset) {
-                        return KTextEditor::Cursor(line, offset - off);
-                    }
-                    off += len + 1;
-                }
-            }
+    if (offset < 0) {
+        return KTextEditor::Cursor::invalid();
+    }
+
+    // find the last block starting at or before the offset
+    updateBlockOffsets(m_blocks.size() - 1);
+    const auto offsetsEnd = m_blockOffsets.begin() + m_blocks.size();
+    const size_t blockIndex = std::upper_bound(m_blockOffsets.begin(), offsetsEnd, offset) - m_blockOffsets.begin() - 1;
+
+    // walk the lines inside the block
+    const TextBlock *block = m_blocks.at(blockIndex);
+    qsizetype off = m_blockOffsets[blockIndex];
+    const int end = block->startLine() + block->lines();
+    for (int line = block->startLine(); line < end; ++line) {
+        const int len = block->lineLength(line);
+        if (off + len >= offset) {
+            return KTextEditor::Cursor(line, offset - off);
         }
+        off += len + 1;
     }
     return KTextEditor::Cursor::invalid();
 }
 
+void TextBuffer::updateBlockOffsets(size_t blockIndex) const
+{
+    Q_ASSERT(blockIndex < m_blocks.size());
+
+    // blocks might have been inserted or removed
+    if (m_blockOffsets.size() != m_blocks.size()) {
+        m_blockOffsets.resize(m_blocks.size());
+        m_validBlockOffsets = std::min(m_validBlockOffsets, m_blocks.size());
+    }
+
+    // first block always starts at 0
+    if (m_validBlockOffsets == 0) {
+        m_blockOffsets[0] = 0;
+        m_validBlockOffsets = 1;
+    }
+
+    // extend the prefix sums up to the wanted block
+    for (; m_validBlockOffsets <= blockIndex; ++m_validBlockOffsets) {
+        m_blockOffsets[m_validBlockOffsets] = m_blockOffsets[m_validBlockOffsets - 1] + m_blocks[m_validBlockOffsets - 1]->blockSize();
+    }
+}
+
+void TextBuffer::resetBlockOffsets()
+{
+    m_validStartLines = 0;
+    m_validBlockOffsets = 0;
+    m_characters = 0;
+    for (const TextBlock *block : m_blocks) {
+        m_characters += block->blockSize() - block->lines();
+    }
+}
+
 QString TextBuffer::text() const
 {
     QString text;
@@ -319,6 +475,9 @@ void TextBuffer::wrapLine(const KTextEditor::Cursor position)
         m_editingMaximalLineChanged = position.line() + 1;
     }
 
+    // blocks behind the changed one have a new offset
+    invalidateBlockOffsets(blockIndex + 1);
+
     // balance the changed block if needed
     balanceBlock(blockIndex);
 
@@ -369,6 +528,9 @@ void TextBuffer::unwrapLine(int line)
         m_editingMaximalLineChanged = line - 1;
     }
 
+    // blocks behind the changed one have a new offset
+    invalidateBlockOffsets(blockIndex + 1);
+
     // balance the changed block if needed
     balanceBlock(blockIndex);
 
@@ -394,6 +556,8 @@ void TextBuffer::insertText(const KTextEditor::Cursor position, const QString &t
 
     // let the block handle the insertText
     m_blocks.at(blockIndex)->insertText(position, text);
+    m_characters += text.size();
+    invalidateBlockOffsets(blockIndex + 1);
 
     // remember changes
     ++m_revision;
@@ -437,6 +601,8 @@ void TextBuffer::removeText(KTextEditor::Range range)
     // let the block handle the removeText, retrieve removed text
     QString text;
     m_blocks.at(blockIndex)->removeText(range, text);
+    m_characters -= text.size();
+    invalidateBlockOffsets(blockIndex + 1);
 
     // remember changes
     ++m_revision;
@@ -461,31 +627,23 @@ int TextBuffer::blockForLine(int line) const
         qFatal("out of range line requested in text buffer (%d out of [0, %d])", line, lines());
     }
 
-    size_t b = line / BufferBlockSize;
-    if (b >= m_blocks.size()) {
-        b = m_blocks.size() - 1;
-    }
-
-    auto block = m_blocks[b];
-    if (block->startLine() <= line && line < block->startLine() + block->lines()) {
-        return b;
-    }
-
-    if (block->startLine() > line) {
-        for (int i = b - 1; i >= 0; --i) {
-            auto block = m_blocks[i];
-            if (block->startLine() <= line && line < block->startLine() + block->lines()) {
-                return i;
-            }
+    // line inside the blocks with up-to-date start lines? binary search there
+    if (m_validStartLines > 0) {
+        const TextBlock *lastValid = m_blocks[m_validStartLines - 1];
+        if (line < lastValid->startLine() + lastValid->lines()) {
+            const auto it = std::upper_bound(m_blocks.begin(), m_blocks.begin() + m_validStartLines, line, [](int line, const TextBlock *block) {
+                return line < block->startLine();
+            });
+            return int(it - m_blocks.begin()) - 1;
         }
     }
 
-    if (block->startLine() < line || (block->lines() == 0)) {
-        for (size_t i = b + 1; i < m_blocks.size(); ++i) {
-            auto block = m_blocks[i];
-            if (block->startLine() <= line && line < block->startLine() + block->lines()) {
-                return i;
-            }
+    // else fix the start lines behind the last edit until we reach the line
+    while (m_validStartLines < (int)m_blocks.size()) {
+        const TextBlock *block = m_blocks[m_validStartLines];
+        updateStartLines(block);
+        if (line < block->startLine() + block->lines()) {
+            return m_validStartLines - 1;
         }
     }
 
@@ -493,25 +651,25 @@ int TextBuffer::blockForLine(int line) const
     return -1;
 }
 
-void TextBuffer::fixStartLines(int startBlock)
+void TextBuffer::updateStartLines(const TextBlock *block) const
 {
-    // only allow valid start block
-    Q_ASSERT(startBlock >= 0);
-    Q_ASSERT(startBlock < (int)m_blocks.size());
-
-    // new start line for next block
-    TextBlock *block = m_blocks.at(startBlock);
-    int newStartLine = block->startLine() + block->lines();
-
-    // fixup block
-    for (size_t index = startBlock + 1; index < m_blocks.size(); ++index) {
-        // set new start line
-        block = m_blocks.at(index);
-        block->setStartLine(newStartLine);
+    // walk from the last valid start line to the wanted block, cost is bounded by the blocks behind the last edit
+    while (m_validStartLines < (int)m_blocks.size()) {
+        TextBlock *current = m_blocks[m_validStartLines];
+        if (m_validStartLines == 0) {
+            current->setStartLine(0, 0);
+        } else {
+            const TextBlock *previous = m_blocks[m_validStartLines - 1];
+            current->setStartLine(previous->startLine() + previous->lines(), m_validStartLines);
+        }
 
-        // calculate next start line
-        newStartLine += block->lines();
+        ++m_validStartLines;
+        if (current == block) {
+            return;
+        }
     }
+
+    Q_ASSERT_X(false, "TextBuffer::updateStartLines", "block not part of buffer");
 }
 
 void TextBuffer::balanceBlock(int index)
@@ -529,6 +687,12 @@ void TextBuffer::balanceBlock(int index)
         Q_ASSERT(newBlock);
         m_blocks.insert(m_blocks.begin() + index + 1, newBlock);
 
+        // give it its real index, it was marked as not yet part of the buffer,
+        // and let it recompute its start line on the next access behind any later edit
+        newBlock->setStartLine(newBlock->startLine(), index + 1);
+        fixStartLines(index);
+        invalidateBlockOffsets(index + 1);
+
         // split is done
         return;
     }
@@ -555,6 +719,8 @@ void TextBuffer::balanceBlock(int index)
     // delete old block
     delete blockToBalance;
     m_blocks.erase(m_blocks.begin() + index);
+    fixStartLines(index - 1);
+    invalidateBlockOffsets(index);
 }
 
 void TextBuffer::debugPrint(const QString &title) const
@@ -582,6 +748,14 @@ bool TextBuffer::load(const QString &filename, bool &encodingErrors, bool &tooLo
     // construct the file loader for the given file, with correct prober type
     Kate::TextLoader file(filename, m_encodingProberType, m_lineLengthLimit);
 
+    // fast path: large local files in UTF-8 can be decoded in parallel from a memory mapping
+    if (loadMapped(filename, file.mimeTypeForFilterDev(), tooLongLinesWrapped, longestLineLoaded)) {
+        encodingErrors = false;
+        BUFFER_DEBUG << "Loaded file " << filename << "memory mapped with codec" << m_textCodec;
+        Q_EMIT loaded(filename, encodingErrors);
+        return true;
+    }
+
     // triple play, maximal three loading rounds
     // 0) use the given encoding, be done, if no encoding errors happen
     // 1) use BOM to decided if Unicode or if that fails, use encoding prober, if no encoding errors happen, be done
@@ -595,6 +769,7 @@ bool TextBuffer::load(const QString &filename, bool &encodingErrors, bool &tooLo
             delete block;
         }
         m_blocks.resize(1);
+        fixStartLines(0);
 
         // remove lines in first block
         m_blocks.back()->clearLines();
@@ -619,6 +794,7 @@ bool TextBuffer::load(const QString &filename, bool &encodingErrors, bool &tooLo
             // create one dummy textline, in any case
             m_blocks.back()->appendLine(QString());
             m_lines++;
+            resetBlockOffsets();
             return false;
         }
 
@@ -655,6 +831,9 @@ bool TextBuffer::load(const QString &filename, bool &encodingErrors, bool &tooLo
         }
     }
 
+    // blocks got replaced
+    resetBlockOffsets();
+
     // save checksum of file on disk
     setDigest(file.digest());
 
@@ -690,6 +869,138 @@ bool TextBuffer::load(const QString &filename, bool &encodingErrors, bool &tooLo
     return true;
 }
 
+bool TextBuffer::loadMapped(const QString &filename, const QString &mimeType, bool &tooLongLinesWrapped, int &longestLineLoaded)
+{
+    // only UTF-8, the only encoding we can split at line feed bytes, decoding stateless per chunk
+    if (QStringConverter::encodingForName(m_textCodec.toUtf8().constData()) != QStringConverter::Utf8) {
+        return false;
+    }
+
+    // no compressed files, we need the raw bytes
+    if (KCompressionDevice::compressionTypeForMimeType(mimeType) != KCompressionDevice::None) {
+        return false;
+    }
+
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < KATE_FILE_MAPPED_LOADER_MIN_SIZE) {
+        return false;
+    }
+
+    // accessing the mapping after the file got truncated is killed with SIGBUS
+    // only map files nobody is supposed to write to, others are streamed by the TextLoader
+    if (file.permissions() & (QFileDevice::WriteOwner | QFileDevice::WriteUser | QFileDevice::WriteGroup | QFileDevice::WriteOther)) {
+        return false;
+    }
+
+    const qint64 fileSize = file.size();
+    uchar *mapping = file.map(0, fileSize);
+    if (!mapping) {
+        return false;
+    }
+    const char *data = reinterpret_cast<const char *>(mapping);
+
+    // skip the UTF-8 byte order mark
+    const bool bomFound = fileSize >= 3 && data[0] == '\xEF' && data[1] == '\xBB' && data[2] == '\xBF';
+    const qint64 textStart = bomFound ? 3 : 0;
+
+    // split the file into chunks ending after a line feed, UTF-8 multi-byte sequences never contain one
+    std::vector<MappedChunk> chunks;
+    for (qint64 chunkStart = textStart; chunkStart < fileSize;) {
+        qint64 chunkEnd = std::min(chunkStart + KATE_FILE_MAPPED_LOADER_CHUNK_SIZE, fileSize);
+        if (chunkEnd < fileSize) {
+            const void *lf = memchr(data + chunkEnd, '\n', fileSize - chunkEnd);
+            chunkEnd = lf ? (static_cast<const char *>(lf) - data + 1) : fileSize;
+        }
+
+        MappedChunk chunk;
+        chunk.data = data + chunkStart;
+        chunk.size = chunkEnd - chunkStart;
+        chunks.push_back(chunk);
+        chunkStart = chunkEnd;
+    }
+    chunks.back().isLastChunk = true;
+
+    // decode and split the chunks in parallel
+    QThreadPool pool;
+    pool.setMaxThreadCount(std::max(1, std::min(QThread::idealThreadCount(), static_cast<int>(chunks.size()))));
+    const int lineLengthLimit = m_lineLengthLimit;
+    for (MappedChunk &chunk : chunks) {
+        pool.start([this, &chunk, lineLengthLimit]() {
+            loadMappedChunk(this, chunk, lineLengthLimit);
+        });
+    }
+
+    // meanwhile: compute the git compatible checksum of the file on disk
+    QCryptographicHash digest(QCryptographicHash::Sha1);
+    addDigestHeader(digest, fileSize);
+    digest.addData(QByteArrayView(data, fileSize));
+
+    pool.waitForDone();
+    file.unmap(mapping);
+
+    // on encoding errors, throw away all work and let the normal loader handle the detection and fallback
+    // same if the file changed its size meanwhile, we did read some inconsistent state
+    const bool encodingError = std::any_of(chunks.begin(), chunks.end(), [](const MappedChunk &chunk) {
+        return chunk.encodingError;
+    });
+    if (encodingError || QFileInfo(filename).size() != fileSize) {
+        for (MappedChunk &chunk : chunks) {
+            for (TextBlock *block : chunk.blocks) {
+                block->clearLines();
+                delete block;
+            }
+        }
+        return false;
+    }
+
+    // stitch the blocks together, the first one is merged into our existing first block, it might hold cursors
+    Q_ASSERT(m_blocks.size() == 1);
+    m_blocks.back()->clearLines();
+    m_lines = 0;
+    tooLongLinesWrapped = false;
+    longestLineLoaded = 0;
+    bool foundLf = false;
+    bool foundCrLf = false;
+    bool foundCr = false;
+    for (MappedChunk &chunk : chunks) {
+        for (TextBlock *block : chunk.blocks) {
+            if (m_blocks.back()->lines() == 0) {
+                block->mergeBlock(m_blocks.back());
+                delete block;
+            } else {
+                m_blocks.push_back(block);
+            }
+        }
+        m_lines += chunk.lines;
+        tooLongLinesWrapped = tooLongLinesWrapped || chunk.tooLongLinesWrapped;
+        longestLineLoaded = std::max(longestLineLoaded, chunk.longestLineLoaded);
+        foundLf = foundLf || chunk.foundLf;
+        foundCrLf = foundCrLf || chunk.foundCrLf;
+        foundCr = foundCr || chunk.foundCr;
+    }
+
+    // the blocks were created without knowing their start lines, they are computed lazily
+    Q_ASSERT(m_lines > 0);
+    resetBlockOffsets();
+
+    // same eol detection result as the TextLoader: dos wins, then unix, then mac
+    if (foundCrLf) {
+        setEndOfLineMode(eolDos);
+    } else if (foundLf) {
+        setEndOfLineMode(eolUnix);
+    } else if (foundCr) {
+        setEndOfLineMode(eolMac);
+    }
+
+    setTextCodec(QStringLiteral("UTF-8"));
+    setDigest(digest.result());
+    if (bomFound) {
+        setGenerateByteOrderMark(true);
+    }
+    m_mimeTypeForFilterDev = mimeType;
+    return true;
+}
+
 const QByteArray &TextBuffer::digest() const
 {
     return m_digest;
@@ -738,6 +1049,7 @@ bool TextBuffer::save(const QString &filename)
     }
 
     // remember this revision as last saved
+    // the checksum was already updated during writing
     m_history.setLastSavedRevision();
 
     // inform that we have saved the state
@@ -748,26 +1060,29 @@ bool TextBuffer::save(const QString &filename)
     return true;
 }
 
-bool TextBuffer::saveBuffer(const QString &filename, KCompressionDevice &saveFile)
+bool TextBuffer::saveBuffer(const QString &filename, KCompressionDevice &saveFile, QCryptographicHash *digest)
 {
     QStringEncoder encoder(m_textCodec.toUtf8().constData(), generateByteOrderMark() ? QStringConverter::Flag::WriteBom : QStringConverter::Flag::Default);
 
     // our loved eol string ;)
-    QString eol = QStringLiteral("\n");
-    if (endOfLineMode() == eolDos) {
-        eol = QStringLiteral("\r\n");
-    } else if (endOfLineMode() == eolMac) {
-        eol = QStringLiteral("\r");
-    }
+    const QString eol = endOfLineString(endOfLineMode());
+
+    // write encoded data, update checksum on the fly
+    const auto write = [&saveFile, digest](const QByteArray &data) {
+        saveFile.write(data);
+        if (digest) {
+            digest->addData(data);
+        }
+    };
 
     // just dump the lines out ;)
     for (int i = 0; i < m_lines; ++i) {
         // dump current line
-        saveFile.write(encoder.encode(line(i).text()));
+        write(encoder.encode(line(i).text()));
 
         // append correct end of line string
         if ((i + 1) < m_lines) {
-            saveFile.write(encoder.encode(eol));
+            write(encoder.encode(eol));
         }
 
         // early out on stream errors
@@ -791,6 +1106,32 @@ bool TextBuffer::saveBuffer(const QString &filename, KCompressionDevice &saveFil
     return true;
 }
 
+qint64 TextBuffer::encodedSize() const
+{
+    // same encoding as saveBuffer, the BOM handling is part of the encoder state
+    QStringEncoder encoder(m_textCodec.toUtf8().constData(), generateByteOrderMark() ? QStringConverter::Flag::WriteBom : QStringConverter::Flag::Default);
+    const QString eol = endOfLineString(endOfLineMode());
+
+    // encode into a scratch buffer we reuse for all lines
+    QByteArray scratch;
+    qint64 size = 0;
+    const auto addSize = [&encoder, &scratch, &size](QStringView text) {
+        const qsizetype requiredSpace = encoder.requiredSpace(text.size());
+        if (scratch.size() < requiredSpace) {
+            scratch.resize(requiredSpace);
+        }
+        size += encoder.appendToBuffer(scratch.data(), text) - scratch.data();
+    };
+
+    for (int i = 0; i < m_lines; ++i) {
+        addSize(line(i).text());
+        if ((i + 1) < m_lines) {
+            addSize(eol);
+        }
+    }
+    return size;
+}
+
 TextBuffer::SaveResult TextBuffer::saveBufferUnprivileged(const QString &filename)
 {
     if (m_alwaysUseKAuthForSave) {
@@ -801,9 +1142,51 @@ TextBuffer::SaveResult TextBuffer::saveBufferUnprivileged(const QString &filenam
     // construct correct filter device
     // we try to use the same compression as for opening
     const KCompressionDevice::CompressionType type = KCompressionDevice::compressionTypeForMimeType(m_mimeTypeForFilterDev);
-    auto saveFile = std::make_unique<KCompressionDevice>(filename, type);
+    QCryptographicHash digest(QCryptographicHash::Sha1);
 
-    if (!saveFile->open(QIODevice::WriteOnly)) {
+    // uncompressed: the encoded data is the file content, compute the checksum while writing it
+    if (type == KCompressionDevice::None) {
+        auto saveFile = std::make_unique<KCompressionDevice>(filename, type);
+        if (!saveFile->open(QIODevice::WriteOnly)) {
+#ifdef CAN_USE_ERRNO
+            if (errno != EACCES) {
+                return SaveResult::Failed;
+            }
+#endif
+            return SaveResult::MissingPermissions;
+        }
+
+        addDigestHeader(digest, encodedSize());
+        if (!saveBuffer(filename, *saveFile, &digest)) {
+            return SaveResult::Failed;
+        }
+
+        setDigest(digest.result());
+        return SaveResult::Success;
+    }
+
+    // compressed: compress into memory first, compute the checksum of the compressed data and write that out
+    // the file is only truncated once the compression did work, a failure leaves the old content alone
+    QBuffer compressedBuffer;
+    if (!compressedBuffer.open(QIODevice::WriteOnly)) {
+        return SaveResult::Failed;
+    }
+
+    // saveBuffer closes the device, that flushes the compressor and reports its errors
+    KCompressionDevice saveFile(&compressedBuffer, false, type);
+    if (!saveFile.open(QIODevice::WriteOnly) || !saveBuffer(filename, saveFile)) {
+        return SaveResult::Failed;
+    }
+
+    // even empty content has a header, no data means the compressor failed
+    const QByteArray &compressed = compressedBuffer.data();
+    if (compressed.isEmpty()) {
+        BUFFER_DEBUG << "Compressing file " << filename << "failed";
+        return SaveResult::Failed;
+    }
+
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
 #ifdef CAN_USE_ERRNO
         if (errno != EACCES) {
             return SaveResult::Failed;
@@ -812,10 +1195,17 @@ TextBuffer::SaveResult TextBuffer::saveBufferUnprivileged(const QString &filenam
         return SaveResult::MissingPermissions;
     }
 
-    if (!saveBuffer(filename, *saveFile)) {
+    // a full disk might only show up on flush or close
+    const bool written = file.write(compressed) == compressed.size() && file.flush();
+    file.close();
+    if (!written || file.error() != QFileDevice::NoError) {
+        BUFFER_DEBUG << "Saving file " << filename << "failed with error" << file.errorString();
         return SaveResult::Failed;
     }
 
+    addDigestHeader(digest, compressed.size());
+    digest.addData(compressed);
+    setDigest(digest.result());
     return SaveResult::Success;
 }
 
@@ -869,11 +1259,15 @@ bool TextBuffer::saveBufferEscalated(const QString &filename)
     temporaryBuffer->seek(0);
 
     // read contents of QBuffer and add them to checksum utility as well as to QTemporaryFile
+    // in addition, compute the git compatible checksum of the final file content
     char buffer[bufferLength];
     qint64 read = -1;
     QCryptographicHash cryptographicHash(SecureTextBuffer::checksumAlgorithm);
+    QCryptographicHash digest(QCryptographicHash::Sha1);
+    addDigestHeader(digest, temporaryBuffer->size());
     while ((read = temporaryBuffer->read(buffer, bufferLength)) > 0) {
         cryptographicHash.addData(QByteArrayView(buffer, read));
+        digest.addData(QByteArrayView(buffer, read));
         if (tempFile.write(buffer, read) == -1) {
             return false;
         }
@@ -906,6 +1300,7 @@ bool TextBuffer::saveBufferEscalated(const QString &filename)
         }
     }
 
+    setDigest(digest.result());
     return true;
 #else
     Q_UNUSED(filename);
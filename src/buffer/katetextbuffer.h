@@ -24,6 +24,7 @@ class DocumentPrivate;
 }
 
 class KCompressionDevice;
+class QCryptographicHash;
 
 namespace Kate
 {
@@ -243,15 +244,38 @@ public:
         return m_blocks.at(blockIndex)->lineLength(line);
     }
 
+    /**
+     * Retrieve the text of @p line by reference, cheaper than copying the whole line().
+     * The reference is only valid until the next change of the buffer.
+     * @param line wanted line number
+     * @return text of the line
+     */
+    const QString &lineText(int line) const
+    {
+        // get block, this will assert on invalid line
+        return m_blocks.at(blockForLine(line))->lineText(line);
+    }
+
     /**
      * Retrieve offset in text for the given cursor position
+     * Uses the cumulative block offsets, no scan over all blocks needed.
      */
-    int cursorToOffset(KTextEditor::Cursor c) const;
+    qsizetype cursorToOffset(KTextEditor::Cursor c) const;
 
     /**
      * Retrieve cursor in text for the given offset
+     * Uses a binary search on the cumulative block offsets.
      */
-    KTextEditor::Cursor offsetToCursor(int offset) const;
+    KTextEditor::Cursor offsetToCursor(qsizetype offset) const;
+
+    /**
+     * Number of characters in this buffer, line breaks not counted.
+     * @return number of characters
+     */
+    qsizetype totalCharacters() const
+    {
+        return m_characters;
+    }
 
     /**
      * Retrieve text of complete buffer.
@@ -407,6 +431,8 @@ private:
 
     /**
      * Find block containing given line.
+     * This fixes the lazily computed start lines of the blocks it passes,
+     * it must only be used from the GUI thread, like all other buffer access.
      * @param line we want to find block for this line
      * @return index of found block
      */
@@ -414,11 +440,22 @@ private:
     // exported for movingrange_test
 
     /**
-     * Fix start lines of all blocks after the given one
+     * Fix start lines of all blocks after the given one.
+     * This is O(1), the start lines are recomputed lazily on access, see updateStartLines.
+     * Must be called whenever the line count of a block changes or blocks are inserted or removed.
      * @param startBlock index of block from which we start to fix
      */
+    void fixStartLines(int startBlock)
+    {
+        m_validStartLines = std::min(m_validStartLines, startBlock + 1);
+    }
+
+    /**
+     * Compute the start lines of all blocks up to the given one.
+     * @param block block that needs a valid start line, must be part of this buffer
+     */
     KTEXTEDITOR_NO_EXPORT
-    void fixStartLines(int startBlock);
+    void updateStartLines(const TextBlock *block) const;
 
     /**
      * Balance the given block. Look if it is too small or too large.
@@ -427,6 +464,29 @@ private:
     KTEXTEDITOR_NO_EXPORT
     void balanceBlock(int index);
 
+    /**
+     * Ensure the cumulative offsets of all blocks up to the given one are computed.
+     * @param blockIndex index of block that needs a valid offset
+     */
+    KTEXTEDITOR_NO_EXPORT
+    void updateBlockOffsets(size_t blockIndex) const;
+
+    /**
+     * Invalidate the cumulative offsets of the blocks starting with the given one.
+     * Must be called whenever a block changes its size or blocks are inserted or removed.
+     * @param blockIndex index of first block with a changed offset
+     */
+    void invalidateBlockOffsets(size_t blockIndex)
+    {
+        m_validBlockOffsets = std::min(m_validBlockOffsets, blockIndex);
+    }
+
+    /**
+     * Recompute the character count and invalidate all block offsets and start lines, after the blocks got replaced.
+     */
+    KTEXTEDITOR_NO_EXPORT
+    void resetBlockOffsets();
+
     /**
      * A range changed, notify the views, in case of attributes or feedback.
      * @param view which view is affected? nullptr for all views
@@ -442,14 +502,38 @@ private:
     KTEXTEDITOR_NO_EXPORT
     void markModifiedLinesAsSaved();
 
+    /**
+     * Load the given file via a memory mapping, decoding it and building the blocks in parallel.
+     * Only large local uncompressed read-only files in UTF-8 are handled, writable files might get
+     * truncated while mapped. For all other files, if the file has encoding errors or if its size
+     * changed during the load, this will return false and the normal TextLoader must be used.
+     * On success, the blocks, line count, digest, eol mode, BOM and mime-type are set.
+     * @param filename file to open
+     * @param mimeType mime-type detected for the filter device
+     * @param tooLongLinesWrapped were too long lines found and wrapped?
+     * @param longestLineLoaded the longest line in the file (before wrapping)
+     * @return success, the file got loaded without encoding errors
+     */
+    KTEXTEDITOR_NO_EXPORT
+    bool loadMapped(const QString &filename, const QString &mimeType, bool &tooLongLinesWrapped, int &longestLineLoaded);
+
     /**
      * Save the current buffer content to the given already opened device
      *
      * @param filename path name for display/debugging purposes
      * @param saveFile open device to write the buffer to
+     * @param digest if not null, all encoded data written is added to this checksum
+     */
+    KTEXTEDITOR_NO_EXPORT
+    bool saveBuffer(const QString &filename, KCompressionDevice &saveFile, QCryptographicHash *digest = nullptr);
+
+    /**
+     * Size of the buffer content encoded like saveBuffer() would write it, without writing anything.
+     * Needed ahead for the header of the git compatible checksum computed during save.
+     * @return size in bytes of the encoded buffer content
      */
     KTEXTEDITOR_NO_EXPORT
-    bool saveBuffer(const QString &filename, KCompressionDevice &saveFile);
+    qint64 encodedSize() const;
 
     /**
      * Attempt to save the buffer content in the given filename location using
@@ -522,7 +606,7 @@ public:
 public:
     /**
      * Checksum of the document on disk, set either through file loading
-     * in openFile() or in KTextEditor::DocumentPrivate::saveFile()
+     * in load() or while writing the file in save()
      * @return git compatible sha1 checksum for this document
      */
     const QByteArray &digest() const;
@@ -553,11 +637,33 @@ private:
      */
     std::vector<TextBlock *> m_blocks;
 
+    /**
+     * Number of blocks at the front of m_blocks with up-to-date start line and block index.
+     * Edits only lower this, the start lines behind are recomputed on access.
+     */
+    mutable int m_validStartLines = 0;
+
+    /**
+     * Offset of the first character of each block in the text, lazily computed.
+     * Only the first m_validBlockOffsets entries are up-to-date.
+     */
+    mutable std::vector<qsizetype> m_blockOffsets;
+
+    /**
+     * Number of up-to-date entries in m_blockOffsets
+     */
+    mutable size_t m_validBlockOffsets = 0;
+
     /**
      * Number of lines in buffer
      */
     int m_lines;
 
+    /**
+     * Number of characters in buffer, line breaks not counted
+     */
+    qsizetype m_characters = 0;
+
     /**
      * Revision of the buffer.
      */
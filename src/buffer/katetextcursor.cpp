@@ -47,7 +47,7 @@ TextCursor::~TextCursor()
 
 void TextCursor::setPosition(const TextCursor &position)
 {
-    if (m_block && m_block != position.m_block) {
+    if (m_block) {
         m_block->removeCursor(this);
     }
 
@@ -70,8 +70,11 @@ void TextCursor::setPosition(KTextEditor::Cursor position, bool init)
         }
 
         // ok, too: both old and new column are valid, we can just adjust the column and be done
+        // the block keeps its cursors sorted by column, sort us in again
         if (position.column() >= 0 && m_column >= 0) {
+            m_block->removeCursor(this);
             m_column = position.column();
+            m_block->insertCursor(this);
             return;
         }
 
@@ -92,15 +95,15 @@ void TextCursor::setPosition(KTextEditor::Cursor position, bool init)
     }
 
     // find new block if m_block doesn't contain the line or if the block is null
+    // the block sorts its cursors by position, remove us before the change
     TextBlock *oldBlock = m_block;
     int startLine = oldBlock ? oldBlock->startLine() : -1;
+    if (oldBlock) {
+        oldBlock->removeCursor(this);
+    }
     if (!oldBlock || position.line() < startLine || position.line() >= startLine + oldBlock->lines()) {
-        if (oldBlock) {
-            oldBlock->removeCursor(this);
-        }
         m_block = m_buffer.m_blocks[m_buffer.blockForLine(position.line())];
         Q_ASSERT(m_block);
-        m_block->insertCursor(this);
         startLine = m_block->startLine();
     }
 
@@ -113,6 +116,7 @@ void TextCursor::setPosition(KTextEditor::Cursor position, bool init)
     // else: valid cursor
     m_line = position.line() - startLine;
     m_column = position.column();
+    m_block->insertCursor(this);
 }
 
 KTextEditor::Document *Kate::TextCursor::document() const
@@ -66,6 +66,7 @@ void TextFolding::clearFoldingRanges()
     // cleanup
     m_idToFoldingRange.clear();
     m_foldedFoldingRanges.clear();
+    invalidateHiddenLines(0);
     qDeleteAll(m_foldingRanges);
     m_foldingRanges.clear();
 
@@ -268,10 +269,9 @@ int TextFolding::visibleLines() const
         return visibleLines;
     }
 
-    // count all folded lines and subtract them from visible lines
-    for (FoldingRange *range : m_foldedFoldingRanges) {
-        visibleLines -= (range->end->line() - range->start->line());
-    }
+    // subtract all folded lines from visible lines
+    updateHiddenLines();
+    visibleLines -= m_hiddenLines.back();
 
     // be done, assert we did no trash
     Q_ASSERT(visibleLines > 0);
@@ -283,38 +283,28 @@ int TextFolding::lineToVisibleLine(int line) const
     // valid input needed!
     Q_ASSERT(line >= 0);
 
-    // start with identity
-    int visibleLine = line;
-
     // skip if nothing folded or first line
     if (m_foldedFoldingRanges.isEmpty() || (line == 0)) {
-        return visibleLine;
+        return line;
     }
 
-    // walk over all folded ranges until we reach the line
-    // keep track of seen visible lines, for the case we want to convert a hidden line!
-    int seenVisibleLines = 0;
-    int lastLine = 0;
-    for (FoldingRange *range : m_foldedFoldingRanges) {
-        // abort if we reach our line!
-        if (range->start->line() >= line) {
-            break;
-        }
-
-        // count visible lines
-        seenVisibleLines += (range->start->line() - lastLine);
-        lastLine = range->end->line();
+    // search the last folded range starting before our line, nothing before it => identity
+    const auto rangesBefore = std::lower_bound(m_foldedFoldingRanges.begin(), m_foldedFoldingRanges.end(), line, compareRangeByLineWithStart)
+        - m_foldedFoldingRanges.begin();
+    if (rangesBefore == 0) {
+        return line;
+    }
 
-        // we might be contained in the region, then we return last visible line
-        if (line <= range->end->line()) {
-            return seenVisibleLines;
-        }
+    updateHiddenLines();
 
-        // subtrace folded lines
-        visibleLine -= (range->end->line() - range->start->line());
+    // we might be contained in the region, then we return the visible line of its start
+    const FoldingRange *range = m_foldedFoldingRanges[rangesBefore - 1];
+    if (line <= range->end->line()) {
+        return range->start->line() - m_hiddenLines[rangesBefore - 1];
     }
 
-    // be done, assert we did no trash
+    // else subtract all lines folded before us
+    const int visibleLine = line - m_hiddenLines[rangesBefore];
     Q_ASSERT(visibleLine >= 0);
     return visibleLine;
 }
@@ -324,42 +314,66 @@ int TextFolding::visibleLineToLine(int visibleLine) const
     // valid input needed!
     Q_ASSERT(visibleLine >= 0);
 
-    // start with identity
-    int line = visibleLine;
-
     // skip if nothing folded or first line
     if (m_foldedFoldingRanges.isEmpty() || (visibleLine == 0)) {
-        return line;
+        return visibleLine;
     }
 
-    // last visible line seen, as line in buffer
-    int seenVisibleLines = 0;
-    int lastLine = 0;
-    int lastLineVisibleLines = 0;
-    for (FoldingRange *range : m_foldedFoldingRanges) {
-        // else compute visible lines and move last seen
-        lastLineVisibleLines = seenVisibleLines;
-        seenVisibleLines += (range->start->line() - lastLine);
+    updateHiddenLines();
 
-        // bail out if enough seen
-        if (seenVisibleLines >= visibleLine) {
-            break;
+    // binary search for the first folded range that starts at or behind our visible line
+    qsizetype first = 0;
+    qsizetype count = m_foldedFoldingRanges.size();
+    while (count > 0) {
+        const qsizetype step = count / 2;
+        const qsizetype index = first + step;
+        if (m_foldedFoldingRanges[index]->start->line() - m_hiddenLines[index] < visibleLine) {
+            first = index + 1;
+            count -= step + 1;
+        } else {
+            count = step;
         }
-
-        lastLine = range->end->line();
     }
 
-    // check if still no enough visible!
-    if (seenVisibleLines < visibleLine) {
-        lastLineVisibleLines = seenVisibleLines;
+    // nothing folded before us => identity
+    if (first == 0) {
+        return visibleLine;
     }
 
-    // compute visible line
-    line = (lastLine + (visibleLine - lastLineVisibleLines));
+    // count from the end of the folded range in front of us
+    const FoldingRange *range = m_foldedFoldingRanges[first - 1];
+    const int line = range->end->line() + (visibleLine - (range->start->line() - m_hiddenLines[first - 1]));
     Q_ASSERT(line >= 0);
     return line;
 }
 
+void TextFolding::updateHiddenLines() const
+{
+    // any edit might move lines into or out of folded ranges, start from scratch then
+    if (m_hiddenLinesRevision != m_buffer.revision()) {
+        m_hiddenLines.clear();
+        m_hiddenLinesRevision = m_buffer.revision();
+    }
+
+    // first entry is always 0, then extend the still valid prefix
+    if (m_hiddenLines.empty()) {
+        m_hiddenLines.push_back(0);
+    }
+    m_hiddenLines.reserve(m_foldedFoldingRanges.size() + 1);
+    for (qsizetype i = m_hiddenLines.size() - 1; i < m_foldedFoldingRanges.size(); ++i) {
+        const FoldingRange *range = m_foldedFoldingRanges[i];
+        m_hiddenLines.push_back(m_hiddenLines.back() + (range->end->line() - range->start->line()));
+    }
+}
+
+void TextFolding::invalidateHiddenLines(qsizetype index)
+{
+    // entry i only depends on the ranges before i
+    if (qsizetype(m_hiddenLines.size()) > index + 1) {
+        m_hiddenLines.resize(index + 1);
+    }
+}
+
 QList<QPair<qint64, TextFolding::FoldingRangeFlags>> TextFolding::foldingRangesStartingOnLine(int line) const
 {
     // results vector
@@ -455,6 +469,7 @@ void TextFolding::editEnd(int startLine, int endLine, std::function<bool(int)> i
         }
 
         // else kill it
+        invalidateHiddenLines(foldIt - m_foldedFoldingRanges.begin());
         m_foldingRanges.removeOne(*foldIt);
         m_idToFoldingRange.remove((*foldIt)->id);
         delete *foldIt;
@@ -628,15 +643,22 @@ bool TextFolding::updateFoldedRangesForNewRange(TextFolding::FoldingRange *newRa
     // TODO: OPTIMIZE
     FoldingRange::Vector newFoldedFoldingRanges;
     bool newRangeInserted = false;
+    qsizetype firstChangedRange = -1;
     for (FoldingRange *range : std::as_const(m_foldedFoldingRanges)) {
         // contained? kill
         if ((newRange->start->toCursor() <= range->start->toCursor()) && (newRange->end->toCursor() >= range->end->toCursor())) {
+            if (firstChangedRange < 0) {
+                firstChangedRange = newFoldedFoldingRanges.size();
+            }
             continue;
         }
 
         // range is behind newRange?
         // insert newRange if not already done
         if (!newRangeInserted && (range->start->toCursor() >= newRange->end->toCursor())) {
+            if (firstChangedRange < 0) {
+                firstChangedRange = newFoldedFoldingRanges.size();
+            }
             newFoldedFoldingRanges.push_back(newRange);
             newRangeInserted = true;
         }
@@ -647,11 +669,15 @@ bool TextFolding::updateFoldedRangesForNewRange(TextFolding::FoldingRange *newRa
 
     // last: insert new range, if not done
     if (!newRangeInserted) {
+        if (firstChangedRange < 0) {
+            firstChangedRange = newFoldedFoldingRanges.size();
+        }
         newFoldedFoldingRanges.push_back(newRange);
     }
 
-    // fixup folded ranges
+    // fixup folded ranges, the hidden lines in front of the first changed range stay valid
     m_foldedFoldingRanges = newFoldedFoldingRanges;
+    invalidateHiddenLines(firstChangedRange);
 
     // folding changed!
     Q_EMIT foldingRangesChanged();
@@ -683,9 +709,11 @@ bool TextFolding::updateFoldedRangesForRemovedRange(TextFolding::FoldingRange *o
     // we now want to remove this range from the m_foldedFoldingRanges vector and include our nested folded ranges!
     // TODO: OPTIMIZE
     FoldingRange::Vector newFoldedFoldingRanges;
+    qsizetype firstChangedRange = -1;
     for (FoldingRange *range : std::as_const(m_foldedFoldingRanges)) {
         // right range? insert folded nested ranges
         if (range == oldRange) {
+            firstChangedRange = newFoldedFoldingRanges.size();
             appendFoldedRanges(newFoldedFoldingRanges, oldRange->nestedRanges);
             continue;
         }
@@ -694,8 +722,9 @@ bool TextFolding::updateFoldedRangesForRemovedRange(TextFolding::FoldingRange *o
         newFoldedFoldingRanges.push_back(range);
     }
 
-    // fixup folded ranges
+    // fixup folded ranges, the hidden lines in front of the first changed range stay valid
     m_foldedFoldingRanges = newFoldedFoldingRanges;
+    invalidateHiddenLines(firstChangedRange < 0 ? 0 : firstChangedRange);
 
     // folding changed!
     Q_EMIT foldingRangesChanged();
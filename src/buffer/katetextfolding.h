@@ -17,6 +17,7 @@
 #include <QObject>
 
 #include <functional>
+#include <vector>
 
 namespace Kate
 {
@@ -359,6 +360,19 @@ private:
     KTEXTEDITOR_NO_EXPORT
     void foldingRangesStartingOnLine(QList<QPair<qint64, FoldingRangeFlags>> &results, const TextFolding::FoldingRange::Vector &ranges, int line) const;
 
+    /**
+     * Bring the hidden lines prefix sums up to date with the folded ranges and the buffer.
+     */
+    KTEXTEDITOR_NO_EXPORT
+    void updateHiddenLines() const;
+
+    /**
+     * Forget the hidden lines prefix sums starting with the given folded range.
+     * @param index index of the first changed range in m_foldedFoldingRanges
+     */
+    KTEXTEDITOR_NO_EXPORT
+    void invalidateHiddenLines(qsizetype index);
+
 private:
     /**
      * parent text buffer
@@ -381,6 +395,13 @@ private:
      */
     FoldingRange::Vector m_foldedFoldingRanges;
 
+    /**
+     * prefix sums of the lines hidden by m_foldedFoldingRanges, entry i is the number of lines hidden by the ranges before range i
+     * computed lazily, entries are only valid up to the size of the vector and for the buffer revision m_hiddenLinesRevision
+     */
+    mutable std::vector<int> m_hiddenLines;
+    mutable qint64 m_hiddenLinesRevision = -1;
+
     /**
      * global id counter for the created ranges
      */
@@ -7,6 +7,8 @@
 #include "katetexthistory.h"
 #include "katetextbuffer.h"
 
+#include <algorithm>
+
 namespace Kate
 {
 TextHistory::TextHistory(TextBuffer &buffer)
@@ -37,6 +39,12 @@ void TextHistory::clear()
 
     // first entry will again belong to first revision
     m_firstHistoryEntryRevision = 0;
+
+    // summaries are rebuilt on next use
+    m_summaries.clear();
+    m_summaryCapacity = 0;
+    m_summaryOffset = 0;
+    m_summarizedEntries = 0;
 }
 
 void TextHistory::setLastSavedRevision()
@@ -103,6 +111,7 @@ void TextHistory::addEntry(const Entry &entry)
 
         // remember edit
         m_historyEntries.front() = entry;
+        m_summarizedEntries = 0;
 
         // be done...
         return;
@@ -156,6 +165,10 @@ void TextHistory::unlockRevision(qint64 revision)
 
             // patch first entry revision
             m_firstHistoryEntryRevision += unreferencedEdits;
+
+            // the summaries of the remaining entries stay valid, just skip the removed ones
+            m_summaryOffset += unreferencedEdits;
+            m_summarizedEntries -= std::min<size_t>(m_summarizedEntries, unreferencedEdits);
         }
     }
 }
@@ -350,6 +363,128 @@ void TextHistory::Entry::reverseTransformCursor(int &cursorLine, int &cursorColu
     }
 }
 
+TextHistory::Summary TextHistory::Summary::forEntry(const Entry &entry)
+{
+    Summary summary;
+    switch (entry.type) {
+    // cursors behind the wrapped line move down, the line after it is the new one for reverse transforms
+    case Entry::WrapLine:
+        summary.minLine = entry.line;
+        summary.threshold = entry.line + 1;
+        summary.lineDelta = 1;
+        summary.reverseMinLine = entry.line + 1;
+        summary.reverseThreshold = entry.line + 2;
+        break;
+
+    // cursors behind the unwrapped line move up, for reverse transforms the line in front is changed
+    case Entry::UnwrapLine:
+        summary.minLine = entry.line;
+        summary.threshold = entry.line + 1;
+        summary.lineDelta = -1;
+        summary.reverseMinLine = entry.line - 1;
+        summary.reverseThreshold = entry.line;
+        break;
+
+    // only the changed line is touched
+    case Entry::InsertText:
+    case Entry::RemoveText:
+        summary.minLine = entry.line;
+        summary.threshold = entry.line + 1;
+        summary.reverseMinLine = entry.line;
+        summary.reverseThreshold = entry.line + 1;
+        break;
+
+    // nothing
+    default:
+        break;
+    }
+    return summary;
+}
+
+TextHistory::Summary TextHistory::Summary::combine(const Summary &first, const Summary &second)
+{
+    // a cursor must skip both parts, moved lines must skip the later part, too
+    Summary summary;
+    summary.minLine = std::min(first.minLine, second.minLine);
+    summary.threshold = std::max(first.threshold, second.threshold - first.lineDelta);
+    summary.lineDelta = first.lineDelta + second.lineDelta;
+    summary.reverseMinLine = std::min(first.reverseMinLine, second.reverseMinLine);
+    summary.reverseThreshold = std::max(second.reverseThreshold, first.reverseThreshold + second.lineDelta);
+    return summary;
+}
+
+void TextHistory::updateSummaries()
+{
+    // rebuild the tree if the entries don't fit, leave room to grow
+    const size_t entries = m_historyEntries.size();
+    if (m_summaryOffset + entries > m_summaryCapacity) {
+        m_summaryCapacity = 64;
+        while (m_summaryCapacity < 2 * entries) {
+            m_summaryCapacity *= 2;
+        }
+        m_summaries.assign(2 * m_summaryCapacity, Summary());
+        m_summaryOffset = 0;
+        m_summarizedEntries = 0;
+    }
+
+    // nothing changed?
+    if (m_summarizedEntries == entries) {
+        return;
+    }
+
+    // update the new leaves, then their parents level by level
+    size_t first = m_summaryCapacity + m_summaryOffset + m_summarizedEntries;
+    size_t last = m_summaryCapacity + m_summaryOffset + entries - 1;
+    for (size_t i = m_summarizedEntries; i < entries; ++i) {
+        m_summaries[m_summaryCapacity + m_summaryOffset + i] = Summary::forEntry(m_historyEntries[i]);
+    }
+    while (first > 1) {
+        first /= 2;
+        last /= 2;
+        for (size_t node = first; node <= last; ++node) {
+            m_summaries[node] = Summary::combine(m_summaries[2 * node], m_summaries[2 * node + 1]);
+        }
+    }
+    m_summarizedEntries = entries;
+}
+
+template<typename SkipSummary, typename VisitEntry>
+bool TextHistory::visitEntries(size_t node,
+                               size_t nodeBegin,
+                               size_t nodeEnd,
+                               size_t begin,
+                               size_t end,
+                               bool reverse,
+                               SkipSummary &skipSummary,
+                               VisitEntry &visitEntry) const
+{
+    // nothing to do outside of the requested entries
+    if (nodeEnd <= begin || end <= nodeBegin) {
+        return true;
+    }
+
+    // whole subtree requested, try to skip it at once
+    if (begin <= nodeBegin && nodeEnd <= end) {
+        if (skipSummary(m_summaries[node])) {
+            return true;
+        }
+
+        // single entry, transform it
+        if (nodeEnd - nodeBegin == 1) {
+            return visitEntry(m_historyEntries[nodeBegin - m_summaryOffset]);
+        }
+    }
+
+    // visit the children in transform order
+    const size_t middle = nodeBegin + (nodeEnd - nodeBegin) / 2;
+    if (reverse) {
+        return visitEntries(2 * node + 1, middle, nodeEnd, begin, end, reverse, skipSummary, visitEntry)
+            && visitEntries(2 * node, nodeBegin, middle, begin, end, reverse, skipSummary, visitEntry);
+    }
+    return visitEntries(2 * node, nodeBegin, middle, begin, end, reverse, skipSummary, visitEntry)
+        && visitEntries(2 * node + 1, middle, nodeEnd, begin, end, reverse, skipSummary, visitEntry);
+}
+
 void TextHistory::transformCursor(int &line, int &column, KTextEditor::MovingCursor::InsertBehavior insertBehavior, qint64 fromRevision, qint64 toRevision)
 {
     // -1 special meaning for from/toRevision
@@ -378,17 +513,88 @@ void TextHistory::transformCursor(int &line, int &column, KTextEditor::MovingCur
     bool moveOnInsert = insertBehavior == KTextEditor::MovingCursor::MoveOnInsert;
 
     // forward or reverse transform?
-    if (toRevision > fromRevision) {
-        for (int rev = fromRevision - m_firstHistoryEntryRevision + 1; rev <= (toRevision - m_firstHistoryEntryRevision); ++rev) {
-            const Entry &entry = m_historyEntries.at(rev);
-            entry.transformCursor(line, column, moveOnInsert);
+    // forward applies the entries behind the from revision up to the one of the to revision, reverse undoes them
+    updateSummaries();
+    const bool reverse = toRevision < fromRevision;
+    const size_t begin = m_summaryOffset + (std::min(fromRevision, toRevision) - m_firstHistoryEntryRevision + 1);
+    const size_t end = m_summaryOffset + (std::max(fromRevision, toRevision) - m_firstHistoryEntryRevision + 1);
+
+    auto skipSummary = [&line, reverse](const Summary &summary) {
+        if (!summary.skips(line, reverse)) {
+            return false;
         }
-    } else {
-        for (int rev = fromRevision - m_firstHistoryEntryRevision; rev >= (toRevision - m_firstHistoryEntryRevision + 1); --rev) {
-            const Entry &entry = m_historyEntries.at(rev);
+        line = summary.skip(line, reverse);
+        return true;
+    };
+    auto visitEntry = [&line, &column, moveOnInsert, reverse](const Entry &entry) {
+        if (reverse) {
             entry.reverseTransformCursor(line, column, moveOnInsert);
+        } else {
+            entry.transformCursor(line, column, moveOnInsert);
         }
+        return true;
+    };
+    visitEntries(1, 0, m_summaryCapacity, begin, end, reverse, skipSummary, visitEntry);
+}
+
+bool TextHistory::transformRangeCursors(KTextEditor::Range &range,
+                                        KTextEditor::MovingRange::InsertBehaviors insertBehaviors,
+                                        bool invalidateIfEmpty,
+                                        qint64 fromRevision,
+                                        qint64 toRevision) const
+{
+    // first: copy cursors, without range association
+    int startLine = range.start().line();
+    int startColumn = range.start().column();
+    int endLine = range.end().line();
+    int endColumn = range.end().column();
+
+    bool moveOnInsertStart = !(insertBehaviors & KTextEditor::MovingRange::ExpandLeft);
+    bool moveOnInsertEnd = (insertBehaviors & KTextEditor::MovingRange::ExpandRight);
+
+    // forward or reverse transform?
+    const bool reverse = toRevision < fromRevision;
+    const size_t begin = m_summaryOffset + (std::min(fromRevision, toRevision) - m_firstHistoryEntryRevision + 1);
+    const size_t end = m_summaryOffset + (std::max(fromRevision, toRevision) - m_firstHistoryEntryRevision + 1);
+
+    // only skip entries if both cursors can, then the range can't get empty in between
+    auto skipSummary = [&startLine, &endLine, reverse](const Summary &summary) {
+        if (!summary.skips(startLine, reverse) || !summary.skips(endLine, reverse)) {
+            return false;
+        }
+        startLine = summary.skip(startLine, reverse);
+        endLine = summary.skip(endLine, reverse);
+        return true;
+    };
+    auto visitEntry = [&, reverse](const Entry &entry) {
+        if (reverse) {
+            entry.reverseTransformCursor(startLine, startColumn, moveOnInsertStart);
+            entry.reverseTransformCursor(endLine, endColumn, moveOnInsertEnd);
+        } else {
+            entry.transformCursor(startLine, startColumn, moveOnInsertStart);
+            entry.transformCursor(endLine, endColumn, moveOnInsertEnd);
+        }
+
+        // got empty?
+        if (endLine < startLine || (endLine == startLine && endColumn <= startColumn)) {
+            if (invalidateIfEmpty) {
+                return false;
+            }
+
+            // else normalize them
+            endLine = startLine;
+            endColumn = startColumn;
+        }
+        return true;
+    };
+    if (!visitEntries(1, 0, m_summaryCapacity, begin, end, reverse, skipSummary, visitEntry)) {
+        range = KTextEditor::Range::invalid();
+        return false;
     }
+
+    // now, copy cursors back
+    range.setRange(KTextEditor::Cursor(startLine, startColumn), KTextEditor::Cursor(endLine, endColumn));
+    return true;
 }
 
 void TextHistory::transformRange(KTextEditor::Range &range,
@@ -427,61 +633,56 @@ void TextHistory::transformRange(KTextEditor::Range &range,
     Q_ASSERT(toRevision < (m_firstHistoryEntryRevision + qint64(m_historyEntries.size())));
 
     // transform cursors
+    updateSummaries();
+    transformRangeCursors(range, insertBehaviors, invalidateIfEmpty, fromRevision, toRevision);
+}
 
-    // first: copy cursors, without range association
-    int startLine = range.start().line();
-    int startColumn = range.start().column();
-    int endLine = range.end().line();
-    int endColumn = range.end().column();
-
-    bool moveOnInsertStart = !(insertBehaviors & KTextEditor::MovingRange::ExpandLeft);
-    bool moveOnInsertEnd = (insertBehaviors & KTextEditor::MovingRange::ExpandRight);
-
-    // forward or reverse transform?
-    if (toRevision > fromRevision) {
-        for (int rev = fromRevision - m_firstHistoryEntryRevision + 1; rev <= (toRevision - m_firstHistoryEntryRevision); ++rev) {
-            const Entry &entry = m_historyEntries.at(rev);
+void TextHistory::transformRanges(std::span<KTextEditor::Range> ranges,
+                                  KTextEditor::MovingRange::InsertBehaviors insertBehaviors,
+                                  KTextEditor::MovingRange::EmptyBehavior emptyBehavior,
+                                  qint64 fromRevision,
+                                  qint64 toRevision)
+{
+    // -1 special meaning for from/toRevision
+    if (fromRevision == -1) {
+        fromRevision = revision();
+    }
 
-            entry.transformCursor(startLine, startColumn, moveOnInsertStart);
+    if (toRevision == -1) {
+        toRevision = revision();
+    }
 
-            entry.transformCursor(endLine, endColumn, moveOnInsertEnd);
+    // invalidate on empty?
+    const bool invalidateIfEmpty = emptyBehavior == KTextEditor::MovingRange::InvalidateIfEmpty;
 
-            // got empty?
-            if (endLine < startLine || (endLine == startLine && endColumn <= startColumn)) {
-                if (invalidateIfEmpty) {
+    // shortcut, same revision, only empty ranges might need to be invalidated
+    if (fromRevision == toRevision) {
+        if (invalidateIfEmpty) {
+            for (auto &range : ranges) {
+                if (range.end() <= range.start()) {
                     range = KTextEditor::Range::invalid();
-                    return;
-                } else {
-                    // else normalize them
-                    endLine = startLine;
-                    endColumn = startColumn;
                 }
             }
         }
-    } else {
-        for (int rev = fromRevision - m_firstHistoryEntryRevision; rev >= (toRevision - m_firstHistoryEntryRevision + 1); --rev) {
-            const Entry &entry = m_historyEntries.at(rev);
-
-            entry.reverseTransformCursor(startLine, startColumn, moveOnInsertStart);
+        return;
+    }
 
-            entry.reverseTransformCursor(endLine, endColumn, moveOnInsertEnd);
+    // some invariants must hold
+    Q_ASSERT(!m_historyEntries.empty());
+    Q_ASSERT(fromRevision >= m_firstHistoryEntryRevision);
+    Q_ASSERT(fromRevision < (m_firstHistoryEntryRevision + qint64(m_historyEntries.size())));
+    Q_ASSERT(toRevision >= m_firstHistoryEntryRevision);
+    Q_ASSERT(toRevision < (m_firstHistoryEntryRevision + qint64(m_historyEntries.size())));
 
-            // got empty?
-            if (endLine < startLine || (endLine == startLine && endColumn <= startColumn)) {
-                if (invalidateIfEmpty) {
-                    range = KTextEditor::Range::invalid();
-                    return;
-                } else {
-                    // else normalize them
-                    endLine = startLine;
-                    endColumn = startColumn;
-                }
-            }
+    // prepare the summaries once for all ranges
+    updateSummaries();
+    for (auto &range : ranges) {
+        if (invalidateIfEmpty && range.end() <= range.start()) {
+            range = KTextEditor::Range::invalid();
+            continue;
         }
+        transformRangeCursors(range, insertBehaviors, invalidateIfEmpty, fromRevision, toRevision);
     }
-
-    // now, copy cursors back
-    range.setRange(KTextEditor::Cursor(startLine, startColumn), KTextEditor::Cursor(endLine, endColumn));
 }
 
 }
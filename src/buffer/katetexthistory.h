@@ -7,6 +7,8 @@
 #ifndef KATE_TEXTHISTORY_H
 #define KATE_TEXTHISTORY_H
 
+#include <limits>
+#include <span>
 #include <vector>
 
 #include <ktexteditor/movingcursor.h>
@@ -78,6 +80,21 @@ public:
                         qint64 fromRevision,
                         qint64 toRevision = -1);
 
+    /**
+     * Transform many ranges from one revision to an other.
+     * Same as transformRange for each of them, but the revisions are checked and the history is prepared only once.
+     * @param ranges ranges to transform in place
+     * @param insertBehaviors behavior of the ranges on insert of text at their position
+     * @param emptyBehavior behavior on becoming empty
+     * @param fromRevision from this revision we want to transform
+     * @param toRevision to this revision we want to transform, default of -1 is current revision
+     */
+    void transformRanges(std::span<KTextEditor::Range> ranges,
+                         KTextEditor::MovingRange::InsertBehaviors insertBehaviors,
+                         KTextEditor::MovingRange::EmptyBehavior emptyBehavior,
+                         qint64 fromRevision,
+                         qint64 toRevision = -1);
+
 private:
     /**
      * Class representing one entry in the editing history.
@@ -144,6 +161,101 @@ private:
         int oldLineLength = -1;
     };
 
+    /**
+     * Summary of consecutive history entries, allows to transform cursors over all of them in one step.
+     * Cursors in lines in front of all changes stay, cursors in lines behind all changes only move by whole lines.
+     * Only cursors in between need to visit the single entries.
+     */
+    class Summary
+    {
+    public:
+        /**
+         * Summary of a single entry
+         * @param entry entry to summarize
+         */
+        static Summary forEntry(const Entry &entry);
+
+        /**
+         * Summary of two consecutive ranges of entries
+         * @param first summary of the earlier entries
+         * @param second summary of the later entries
+         */
+        static Summary combine(const Summary &first, const Summary &second);
+
+        /**
+         * Can a cursor in the given line skip all summarized entries?
+         * @param line line of the cursor
+         * @param reverse reverse transform?
+         */
+        bool skips(int line, bool reverse) const
+        {
+            return reverse ? (line < reverseMinLine || line >= reverseThreshold) : (line < minLine || line >= threshold);
+        }
+
+        /**
+         * Transform the line of a cursor that skips all summarized entries.
+         * @param line line of the cursor
+         * @param reverse reverse transform?
+         * @return transformed line, the column stays
+         */
+        int skip(int line, bool reverse) const
+        {
+            if (reverse) {
+                return (line < reverseMinLine) ? line : (line - lineDelta);
+            }
+            return (line < minLine) ? line : (line + lineDelta);
+        }
+
+        /**
+         * cursors in lines in front of this one are not changed
+         */
+        int minLine = std::numeric_limits<int>::max();
+
+        /**
+         * cursors in this line or behind are moved by lineDelta
+         */
+        int threshold = -1;
+
+        /**
+         * lines added by the summarized entries
+         */
+        int lineDelta = 0;
+
+        /**
+         * same as minLine for reverse transforms, in lines after the entries
+         */
+        int reverseMinLine = std::numeric_limits<int>::max();
+
+        /**
+         * same as threshold for reverse transforms, in lines after the entries
+         */
+        int reverseThreshold = -1;
+    };
+
+    /**
+     * Update the summary tree for all entries added or changed since the last transform.
+     */
+    void updateSummaries();
+
+    /**
+     * Visit the entries [begin, end) below the given node of the summary tree in transform order.
+     * Subtrees are skipped as a whole if skipSummary handles them.
+     * @return false if visitEntry aborted the transformation
+     */
+    template<typename SkipSummary, typename VisitEntry>
+    bool visitEntries(size_t node, size_t nodeBegin, size_t nodeEnd, size_t begin, size_t end, bool reverse, SkipSummary &skipSummary, VisitEntry &visitEntry)
+        const;
+
+    /**
+     * Transform the cursors of a range, revisions must be checked and the summaries up-to-date.
+     * @return false if the range got invalid
+     */
+    bool transformRangeCursors(KTextEditor::Range &range,
+                               KTextEditor::MovingRange::InsertBehaviors insertBehaviors,
+                               bool invalidateIfEmpty,
+                               qint64 fromRevision,
+                               qint64 toRevision) const;
+
     /**
      * Construct an empty text history.
      * @param buffer buffer this text history belongs to
@@ -229,6 +341,27 @@ private:
      * offset for the first entry in m_history, to which revision it really belongs?
      */
     qint64 m_firstHistoryEntryRevision;
+
+    /**
+     * Implicit binary tree of summaries over the history entries, root at index 1.
+     * Leaves start at index m_summaryCapacity, entry i is leaf m_summaryCapacity + m_summaryOffset + i.
+     */
+    std::vector<Summary> m_summaries;
+
+    /**
+     * Number of leaves of the summary tree, a power of two.
+     */
+    size_t m_summaryCapacity = 0;
+
+    /**
+     * Leaf of the first history entry, entries removed from the front keep their stale leaves.
+     */
+    size_t m_summaryOffset = 0;
+
+    /**
+     * Number of history entries with up-to-date summaries.
+     */
+    size_t m_summarizedEntries = 0;
 };
 
 }
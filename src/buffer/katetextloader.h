@@ -17,6 +17,7 @@
 #include <KEncodingProber>
 
 #include "katetextbuffer.h"
+#include "katetextscanner.h"
 
 namespace Kate
 {
@@ -27,6 +28,18 @@ namespace Kate
  */
 static const qint64 KATE_FILE_LOADER_BS = 256 * 1024;
 
+/**
+ * minimal file size to use the memory mapped parallel loader, 16 mb
+ * smaller files load fast enough with the sequential TextLoader
+ */
+static const qint64 KATE_FILE_MAPPED_LOADER_MIN_SIZE = 16 * 1024 * 1024;
+
+/**
+ * size of the chunks the memory mapped parallel loader decodes per task, 8 mb
+ * chunks are extended to the next line feed to not split lines
+ */
+static const qint64 KATE_FILE_MAPPED_LOADER_CHUNK_SIZE = 8 * 1024 * 1024;
+
 /**
  * File Loader, will handle reading of files + detecting encoding
  */
@@ -337,6 +350,20 @@ public:
             }
 
             for (; m_position < m_text.length(); m_position++) {
+                // skip all chars up to the next line terminator in bulk
+                const int nextLineTerminator = TextScanner::findLineTerminator(m_text.unicode(), m_position, m_text.length());
+                if (nextLineTerminator > m_position) {
+                    m_lastWasEndOfLine = false;
+                    m_lastWasR = false;
+                    m_position = nextLineTerminator;
+                }
+
+                // no line terminator left, try to load more text
+                if (m_position == m_text.length()) {
+                    m_alreadyScanned = m_position - 1;
+                    break;
+                }
+
                 m_alreadyScanned = m_position;
                 QChar current_char = m_text.at(m_position);
                 if (current_char == lf) {
@@ -380,7 +407,8 @@ public:
 
                     lineLimitHandler(offset, length);
                     return !encodingError;
-                } else if (current_char == QChar::LineSeparator) {
+                } else {
+                    Q_ASSERT(current_char == QChar::LineSeparator);
                     m_lastWasEndOfLine = true;
 
                     // line data
@@ -392,9 +420,6 @@ public:
 
                     lineLimitHandler(offset, length);
                     return !encodingError;
-                } else {
-                    m_lastWasEndOfLine = false;
-                    m_lastWasR = false;
                 }
             }
         }
@@ -0,0 +1,240 @@
+/*
+    SPDX-FileCopyrightText: 2026 KTextEditor contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "katetextscanner.h"
+
+#include <QtAlgorithms>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KATE_SCANNER_SSE2 1
+#include <immintrin.h>
+#endif
+
+// AVX2 code is compiled via target attributes, runtime detection is only done for GCC and Clang
+#if defined(KATE_SCANNER_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define KATE_SCANNER_AVX2 1
+#define KATE_SCANNER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace Kate
+{
+namespace TextScanner
+{
+namespace
+{
+using FindFunction = qsizetype (*)(const QChar *, qsizetype, qsizetype);
+using CountFunction = qsizetype (*)(const QChar *, qsizetype);
+
+constexpr char16_t lf = u'\n';
+constexpr char16_t cr = u'\r';
+constexpr char16_t ls = 0x2028;
+
+inline const char16_t *utf16(const QChar *text)
+{
+    return reinterpret_cast<const char16_t *>(text);
+}
+
+qsizetype findScalar(const QChar *text, qsizetype from, qsizetype to)
+{
+    const char16_t *data = utf16(text);
+    for (qsizetype i = from; i < to; ++i) {
+        if (data[i] == lf || data[i] == cr || data[i] == ls) {
+            return i;
+        }
+    }
+    return to;
+}
+
+qsizetype countScalar(const char16_t *data, qsizetype from, qsizetype size)
+{
+    qsizetype count = 0;
+    for (qsizetype i = from; i < size; ++i) {
+        if (data[i] == lf || data[i] == ls) {
+            ++count;
+        } else if (data[i] == cr && !((i + 1) < size && data[i + 1] == lf)) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+qsizetype countScalar(const QChar *text, qsizetype size)
+{
+    return countScalar(utf16(text), 0, size);
+}
+
+#ifdef KATE_SCANNER_SSE2
+qsizetype findSSE2(const QChar *text, qsizetype from, qsizetype to)
+{
+    const char16_t *data = utf16(text);
+    const __m128i lfs = _mm_set1_epi16(short(lf));
+    const __m128i crs = _mm_set1_epi16(short(cr));
+    const __m128i lss = _mm_set1_epi16(short(ls));
+
+    qsizetype i = from;
+    for (; i + 8 <= to; i += 8) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const __m128i match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(chunk, lfs), _mm_cmpeq_epi16(chunk, crs)), _mm_cmpeq_epi16(chunk, lss));
+        const uint mask = _mm_movemask_epi8(match);
+        if (mask) {
+            return i + qCountTrailingZeroBits(mask) / 2;
+        }
+    }
+    return findScalar(text, i, to);
+}
+
+qsizetype countSSE2(const QChar *text, qsizetype size)
+{
+    const char16_t *data = utf16(text);
+    const __m128i lfs = _mm_set1_epi16(short(lf));
+    const __m128i crs = _mm_set1_epi16(short(cr));
+    const __m128i lss = _mm_set1_epi16(short(ls));
+
+    // a \r followed by \n is not counted, the \n is, we need one more char to look ahead
+    qsizetype count = 0;
+    qsizetype i = 0;
+    for (; i + 9 <= size; i += 8) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + 1));
+        const __m128i crlf = _mm_and_si128(_mm_cmpeq_epi16(chunk, crs), _mm_cmpeq_epi16(next, lfs));
+        const __m128i match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi16(chunk, lfs), _mm_cmpeq_epi16(chunk, lss)),
+                                           _mm_andnot_si128(crlf, _mm_cmpeq_epi16(chunk, crs)));
+        count += qPopulationCount(uint(_mm_movemask_epi8(match))) / 2;
+    }
+    return count + countScalar(data, i, size);
+}
+#endif
+
+#ifdef KATE_SCANNER_AVX2
+KATE_SCANNER_TARGET_AVX2 qsizetype findAVX2(const QChar *text, qsizetype from, qsizetype to)
+{
+    const char16_t *data = utf16(text);
+    const __m256i lfs = _mm256_set1_epi16(short(lf));
+    const __m256i crs = _mm256_set1_epi16(short(cr));
+    const __m256i lss = _mm256_set1_epi16(short(ls));
+
+    qsizetype i = from;
+    for (; i + 16 <= to; i += 16) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        const __m256i match =
+            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi16(chunk, lfs), _mm256_cmpeq_epi16(chunk, crs)), _mm256_cmpeq_epi16(chunk, lss));
+        const uint mask = _mm256_movemask_epi8(match);
+        if (mask) {
+            return i + qCountTrailingZeroBits(mask) / 2;
+        }
+    }
+    return findSSE2(text, i, to);
+}
+
+KATE_SCANNER_TARGET_AVX2 qsizetype countAVX2(const QChar *text, qsizetype size)
+{
+    const char16_t *data = utf16(text);
+    const __m256i lfs = _mm256_set1_epi16(short(lf));
+    const __m256i crs = _mm256_set1_epi16(short(cr));
+    const __m256i lss = _mm256_set1_epi16(short(ls));
+
+    // a \r followed by \n is not counted, the \n is, we need one more char to look ahead
+    qsizetype count = 0;
+    qsizetype i = 0;
+    for (; i + 17 <= size; i += 16) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        const __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + 1));
+        const __m256i crlf = _mm256_and_si256(_mm256_cmpeq_epi16(chunk, crs), _mm256_cmpeq_epi16(next, lfs));
+        const __m256i match = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi16(chunk, lfs), _mm256_cmpeq_epi16(chunk, lss)),
+                                              _mm256_andnot_si256(crlf, _mm256_cmpeq_epi16(chunk, crs)));
+        count += qPopulationCount(uint(_mm256_movemask_epi8(match))) / 2;
+    }
+    return count + countScalar(data, i, size);
+}
+#endif
+
+FindFunction findFunction(Implementation implementation)
+{
+    switch (implementation) {
+#ifdef KATE_SCANNER_AVX2
+    case Implementation::AVX2:
+        return findAVX2;
+#endif
+#ifdef KATE_SCANNER_SSE2
+    case Implementation::SSE2:
+        return findSSE2;
+#endif
+    default:
+        return findScalar;
+    }
+}
+
+CountFunction countFunction(Implementation implementation)
+{
+    switch (implementation) {
+#ifdef KATE_SCANNER_AVX2
+    case Implementation::AVX2:
+        return countAVX2;
+#endif
+#ifdef KATE_SCANNER_SSE2
+    case Implementation::SSE2:
+        return countSSE2;
+#endif
+    default:
+        return countScalar;
+    }
+}
+}
+
+bool isSupported(Implementation implementation)
+{
+    switch (implementation) {
+    case Implementation::AVX2:
+#ifdef KATE_SCANNER_AVX2
+        return __builtin_cpu_supports("avx2");
+#else
+        return false;
+#endif
+    case Implementation::SSE2:
+#ifdef KATE_SCANNER_SSE2
+        return true;
+#else
+        return false;
+#endif
+    case Implementation::Scalar:
+        return true;
+    }
+    return false;
+}
+
+Implementation bestImplementation()
+{
+    static const Implementation best = isSupported(Implementation::AVX2) ? Implementation::AVX2
+        : isSupported(Implementation::SSE2)                               ? Implementation::SSE2
+                                                                          : Implementation::Scalar;
+    return best;
+}
+
+qsizetype findLineTerminator(const QChar *text, qsizetype from, qsizetype to)
+{
+    static const FindFunction function = findFunction(bestImplementation());
+    return function(text, from, to);
+}
+
+qsizetype countLineTerminators(const QChar *text, qsizetype size)
+{
+    static const CountFunction function = countFunction(bestImplementation());
+    return function(text, size);
+}
+
+qsizetype findLineTerminator(Implementation implementation, const QChar *text, qsizetype from, qsizetype to)
+{
+    Q_ASSERT(isSupported(implementation));
+    return findFunction(implementation)(text, from, to);
+}
+
+qsizetype countLineTerminators(Implementation implementation, const QChar *text, qsizetype size)
+{
+    Q_ASSERT(isSupported(implementation));
+    return countFunction(implementation)(text, size);
+}
+}
+}
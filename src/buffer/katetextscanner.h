@@ -0,0 +1,73 @@
+/*
+    SPDX-FileCopyrightText: 2026 KTextEditor contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KATE_TEXTSCANNER_H
+#define KATE_TEXTSCANNER_H
+
+#include <QChar>
+
+#include <ktexteditor_export.h>
+
+namespace Kate
+{
+/**
+ * Scanning kernels for line terminators in UTF-16 text.
+ * Line terminators are \n, \r and the Unicode line separator, \r\n counts as one terminator.
+ * The best implementation for the running CPU is picked at runtime:
+ * AVX2 or SSE2 on x86, a scalar loop everywhere else.
+ */
+namespace TextScanner
+{
+/**
+ * Available scanning implementations.
+ */
+enum class Implementation { Scalar, SSE2, AVX2 };
+
+/**
+ * Best implementation supported by the running CPU, detected once.
+ * @return best implementation
+ */
+KTEXTEDITOR_EXPORT Implementation bestImplementation();
+
+/**
+ * Is the given implementation supported by the running CPU?
+ * @param implementation implementation to check
+ * @return implementation can be used
+ */
+KTEXTEDITOR_EXPORT bool isSupported(Implementation implementation);
+
+/**
+ * Find the next line terminator in the given text.
+ * @param text text to scan
+ * @param from first position to check
+ * @param to end of text to scan, exclusive
+ * @return position of the first line terminator in [from, to), or to if none found
+ */
+KTEXTEDITOR_EXPORT qsizetype findLineTerminator(const QChar *text, qsizetype from, qsizetype to);
+
+/**
+ * Count the line terminators in the given text.
+ * @param text text to scan
+ * @param size length of the text
+ * @return number of line terminators, \r\n counts as one
+ */
+KTEXTEDITOR_EXPORT qsizetype countLineTerminators(const QChar *text, qsizetype size);
+
+/**
+ * Variant of findLineTerminator using the given implementation, for tests and benchmarks.
+ * The implementation must be supported by the running CPU.
+ */
+KTEXTEDITOR_EXPORT qsizetype findLineTerminator(Implementation implementation, const QChar *text, qsizetype from, qsizetype to);
+
+/**
+ * Variant of countLineTerminators using the given implementation, for tests and benchmarks.
+ * The implementation must be supported by the running CPU.
+ */
+KTEXTEDITOR_EXPORT qsizetype countLineTerminators(Implementation implementation, const QChar *text, qsizetype size);
+}
+}
+
+#endif
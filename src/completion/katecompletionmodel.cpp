@@ -20,9 +20,12 @@
 
 #include <QApplication>
 #include <QMultiMap>
+#include <QThread>
 #include <QTimer>
 #include <QVarLengthArray>
 
+#include <numeric>
+
 using namespace KTextEditor;
 
 /// A helper-class for handling completion-models with hierarchical grouping/optimization
@@ -850,23 +853,43 @@ QModelIndex KateCompletionModel::mapFromSource(const QModelIndex &sourceIndex) c
     return QModelIndex();
 }
 
+/**
+ * Did the typed text only get longer for all models?
+ * Then nothing that did not match before can match now.
+ */
+static bool isNarrowingMatch(const QMap<KTextEditor::CodeCompletionModel *, QString> &oldMatch,
+                             const QMap<KTextEditor::CodeCompletionModel *, QString> &newMatch)
+{
+    if (oldMatch.size() != newMatch.size()) {
+        return false;
+    }
+
+    for (auto it = newMatch.cbegin(), oldIt = oldMatch.cbegin(); it != newMatch.cend(); ++it, ++oldIt) {
+        if (it.key() != oldIt.key() || !it.value().startsWith(oldIt.value())) {
+            return false;
+        }
+    }
+    return true;
+}
+
 void KateCompletionModel::setCurrentCompletion(QMap<KTextEditor::CodeCompletionModel *, QString> currentMatch)
 {
     beginResetModel();
 
+    const bool narrowing = isNarrowingMatch(m_currentMatch, currentMatch);
     m_currentMatch = currentMatch;
 
     if (!hasGroups()) {
-        changeCompletions(m_ungrouped);
+        changeCompletions(m_ungrouped, narrowing);
     } else {
         for (Group *g : std::as_const(m_rowTable)) {
             if (g != m_argumentHints) {
-                changeCompletions(g);
+                changeCompletions(g, narrowing);
             }
         }
         for (Group *g : std::as_const(m_emptyGroups)) {
             if (g != m_argumentHints) {
-                changeCompletions(g);
+                changeCompletions(g, narrowing);
             }
         }
     }
@@ -937,18 +960,66 @@ QString KateCompletionModel::commonPrefix(QModelIndex selectedIndex) const
     return commonPrefix;
 }
 
-void KateCompletionModel::changeCompletions(Group *g)
+void KateCompletionModel::changeCompletions(Group *g, bool narrowing)
 {
     // This code determines what of the filtered items still fit
     // don't notify the model. The model is notified afterwards through a reset().
-    g->filtered.clear();
-    std::remove_copy_if(g->prefilter.begin(), g->prefilter.end(), std::back_inserter(g->filtered), [this](Item &item) {
-        return !item.match(this);
-    });
+    // If the typed text only got longer, only the items matching so far need to be checked.
+    if (narrowing) {
+        g->filtered = filterItems(std::move(g->filtered));
+    } else {
+        g->filtered = filterItems(g->prefilter);
+    }
 
     hideOrShowGroup(g, /*notifyModel=*/false);
 }
 
+std::vector<KateCompletionModel::Item> KateCompletionModel::filterItems(std::vector<Item> items)
+{
+    // small lists are done right here, large ones are split into chunks that are matched and sorted in parallel
+    static constexpr size_t minimalChunkSize = 4096;
+    const size_t chunkCount = std::max<size_t>(1, std::min<size_t>(QThread::idealThreadCount(), items.size() / minimalChunkSize));
+    const size_t chunkSize = (items.size() + chunkCount - 1) / std::max<size_t>(1, chunkCount);
+
+    auto comp = [this](const Item &left, const Item &right) {
+        return left.lessThan(this, right);
+    };
+    std::vector<std::pair<size_t, size_t>> chunks;
+    for (size_t begin = 0; begin < items.size(); begin += chunkSize) {
+        chunks.emplace_back(begin, std::min(begin + chunkSize, items.size()));
+    }
+    auto filterChunk = [this, &items, &comp](std::pair<size_t, size_t> &chunk) {
+        const auto end = std::remove_if(items.begin() + chunk.first, items.begin() + chunk.second, [this](Item &item) {
+            return !item.match(this);
+        });
+        chunk.second = end - items.begin();
+        std::stable_sort(items.begin() + chunk.first, end, comp);
+    };
+
+    if (chunks.size() > 1) {
+        for (auto &chunk : chunks) {
+            m_filterPool.start([&filterChunk, &chunk]() {
+                filterChunk(chunk);
+            });
+        }
+        m_filterPool.waitForDone();
+    } else if (!chunks.empty()) {
+        filterChunk(chunks.front());
+    }
+
+    // close the gaps between the matching parts of the chunks and merge the sorted runs
+    std::vector<Item> filtered;
+    filtered.reserve(std::accumulate(chunks.begin(), chunks.end(), size_t(0), [](size_t count, const auto &chunk) {
+        return count + (chunk.second - chunk.first);
+    }));
+    for (const auto &chunk : chunks) {
+        const auto middle = filtered.size();
+        std::move(items.begin() + chunk.first, items.begin() + chunk.second, std::back_inserter(filtered));
+        std::inplace_merge(filtered.begin(), filtered.begin() + middle, filtered.end(), comp);
+    }
+    return filtered;
+}
+
 int KateCompletionModel::Group::orderNumber() const
 {
     if (this == model->m_ungrouped) {
@@ -1153,6 +1224,37 @@ int KateCompletionModel::countBits(int value)
     return count;
 }
 
+static inline QChar toLower(QChar c)
+{
+    return c.isLower() ? c : c.toLower();
+}
+
+/**
+ * Offset of the first letter in the word. Some sources add a space or
+ * a marker at the beginning, the abbreviation matching starts at the first letter.
+ */
+static int firstLetterOf(const QString &word)
+{
+    for (auto it = word.cbegin(); it != word.cend(); ++it) {
+        if (it->isLetter()) {
+            return int(it - word.cbegin());
+        }
+    }
+    return 0;
+}
+
+/**
+ * The position is a word beginning if the previous character was an underscore
+ * or if the current character is uppercase. Subsequent uppercase characters do not count,
+ * to handle the special case of UPPER_CASE_VARS properly.
+ */
+static bool isWordBeginning(const QString &word, int i)
+{
+    const QChar c = word.at(i);
+    const QChar prev = word.at(i - 1);
+    return prev == QLatin1Char('_') || (c.isUpper() && !prev.isUpper());
+}
+
 KateCompletionModel::Item::Item(bool doInitialMatch, KateCompletionModel *m, const HierarchicalModelHandler &handler, ModelRow sr)
     : m_sourceRow(sr)
     , matchCompletion(StartsWithMatch)
@@ -1164,6 +1266,14 @@ KateCompletionModel::Item::Item(bool doInitialMatch, KateCompletionModel *m, con
     QModelIndex nameSibling = sr.second.sibling(sr.second.row(), CodeCompletionModel::Name);
     m_nameColumn = nameSibling.data(Qt::DisplayRole).toString();
 
+    // things the matching needs for every typed character are computed once
+    m_firstLetter = firstLetterOf(m_nameColumn);
+    for (int i = 1; i < m_nameColumn.size(); ++i) {
+        if (isWordBeginning(m_nameColumn, i)) {
+            m_wordBeginnings.push_back(i);
+        }
+    }
+
     if (doInitialMatch) {
         match(m);
     }
@@ -1191,7 +1301,7 @@ bool KateCompletionModel::Item::lessThan(KateCompletionModel *model, const Item
         return false;
     }
 
-    ret = inheritanceDepth - rhs.inheritanceDepth;
+    ret = (inheritanceDepth - m_abbreviationScore) - (rhs.inheritanceDepth - rhs.m_abbreviationScore);
 
     if (ret == 0) {
         auto it = model->m_currentMatch.constFind(rhs.m_sourceRow.first);
@@ -1302,7 +1412,10 @@ void KateCompletionModel::Group::resort()
     auto comp = [this](const Item &left, const Item &right) {
         return left.lessThan(model, right);
     };
-    std::stable_sort(filtered.begin(), filtered.end(), comp);
+    // filtering keeps the items sorted, most times nothing is to do
+    if (!std::is_sorted(filtered.begin(), filtered.end(), comp)) {
+        std::stable_sort(filtered.begin(), filtered.end(), comp);
+    }
     model->hideOrShowGroup(this);
 }
 
@@ -1379,31 +1492,13 @@ bool KateCompletionModel::shouldMatchHideCompletionList() const
     return doHide;
 }
 
-static inline QChar toLower(QChar c)
-{
-    return c.isLower() ? c : c.toLower();
-}
-
-bool KateCompletionModel::matchesAbbreviation(const QString &word, const QString &typed, int &score)
+static bool matchesAbbreviationFrom(QStringView wordView, const QString &typed, int &score)
 {
     // A mismatch is very likely for random even for the first letter,
     // thus this optimization makes sense.
 
     // We require that first letter must match before we do fuzzy matching.
     // Not sure how well this well it works in practice, but seems ok so far.
-    // Also, 0 might not be the first letter. Some sources add a space or a marker
-    // at the beginning. So look for first letter
-    const int firstLetter = [&word] {
-        for (auto it = word.cbegin(); it != word.cend(); ++it) {
-            if (it->isLetter())
-                return int(it - word.cbegin());
-        }
-        return 0;
-    }();
-
-    QStringView wordView = word;
-    wordView = wordView.mid(firstLetter);
-
     if (toLower(wordView.at(0)) != toLower(typed.at(0))) {
         return false;
     }
@@ -1413,29 +1508,26 @@ bool KateCompletionModel::matchesAbbreviation(const QString &word, const QString
     return res.matched;
 }
 
-static inline bool containsAtWordBeginning(const QString &word, const QString &typed)
+bool KateCompletionModel::matchesAbbreviation(const QString &word, const QString &typed, int &score)
+{
+    return matchesAbbreviationFrom(QStringView(word).mid(firstLetterOf(word)), typed, score);
+}
+
+static inline bool containsAtWordBeginning(const QString &word, const QList<int> &wordBeginnings, const QString &typed)
 {
     if (typed.size() > word.size()) {
         return false;
     }
 
-    for (int i = 1; i < word.size(); i++) {
-        // The current position is a word beginning if the previous character was an underscore
-        // or if the current character is uppercase. Subsequent uppercase characters do not count,
-        // to handle the special case of UPPER_CASE_VARS properly.
-        const QChar c = word.at(i);
-        const QChar prev = word.at(i - 1);
-        if (!(prev == QLatin1Char('_') || (c.isUpper() && !prev.isUpper()))) {
-            continue;
-        }
-        if (QStringView(word).mid(i).startsWith(typed, Qt::CaseInsensitive)) {
-            return true;
-        }
-
+    for (const int i : wordBeginnings) {
         // If we do not have enough string left, return early
         if (word.size() - i < typed.size()) {
             return false;
         }
+
+        if (QStringView(word).mid(i).startsWith(typed, Qt::CaseInsensitive)) {
+            return true;
+        }
     }
     return false;
 }
@@ -1445,6 +1537,7 @@ KateCompletionModel::Item::MatchType KateCompletionModel::Item::match(KateComple
     const QString match = model->currentCompletion(m_sourceRow.first);
 
     m_haveExactMatch = false;
+    m_abbreviationScore = 0;
 
     // Hehe, everything matches nothing! (ie. everything matches a blank string)
     if (match.isEmpty()) {
@@ -1459,8 +1552,8 @@ KateCompletionModel::Item::MatchType KateCompletionModel::Item::match(KateComple
     if (matchCompletion == NoMatch && !m_nameColumn.isEmpty() && !match.isEmpty()) {
         // if still no match, try abbreviation matching
         int score = 0;
-        if (matchesAbbreviation(m_nameColumn, match, score)) {
-            inheritanceDepth -= score;
+        if (matchesAbbreviationFrom(QStringView(m_nameColumn).mid(m_firstLetter), match, score)) {
+            m_abbreviationScore = score;
             matchCompletion = AbbreviationMatch;
         }
     }
@@ -1470,7 +1563,7 @@ KateCompletionModel::Item::MatchType KateCompletionModel::Item::match(KateComple
         // Only match when the occurrence is at a "word" beginning, marked by
         // an underscore or a capital. So Foo matches BarFoo and Bar_Foo, but not barfoo.
         // Starting at 1 saves looking at the beginning of the word, that was already checked above.
-        if (containsAtWordBeginning(m_nameColumn, match)) {
+        if (containsAtWordBeginning(m_nameColumn, m_wordBeginnings, match)) {
             matchCompletion = ContainsMatch;
         }
     }
@@ -11,6 +11,7 @@
 #include <QAbstractProxyModel>
 #include <QList>
 #include <QPair>
+#include <QThreadPool>
 
 #include <ktexteditor/codecompletionmodel.h>
 
@@ -59,7 +60,7 @@ public:
     KateCompletionWidget *widget() const;
 
     KTEXTEDITOR_EXPORT QString currentCompletion(KTextEditor::CodeCompletionModel *model) const;
-    void setCurrentCompletion(QMap<KTextEditor::CodeCompletionModel *, QString> currentMatch);
+    KTEXTEDITOR_EXPORT void setCurrentCompletion(QMap<KTextEditor::CodeCompletionModel *, QString> currentMatch);
 
     int translateColumn(int sourceColumn) const;
 
@@ -168,8 +169,17 @@ private:
 
         QString m_nameColumn;
 
+        // positions in the name where words begin, for the contains matching
+        QList<int> m_wordBeginnings;
+
+        // position of the first letter in the name, for the abbreviation matching
+        int m_firstLetter = 0;
+
         int inheritanceDepth;
 
+        // score of the current abbreviation match, better matches are sorted first
+        int m_abbreviationScore = 0;
+
         // True when currently matching completion string
         MatchType matchCompletion;
         bool m_haveExactMatch;
@@ -253,7 +263,9 @@ private:
     enum changeTypes { Broaden, Narrow, Change };
 
     // Returns whether the model needs to be reset
-    void changeCompletions(Group *g);
+    void changeCompletions(Group *g, bool narrowing);
+    /// Matches the items against the current completion, returns the matching ones sorted
+    std::vector<Item> filterItems(std::vector<Item> items);
 
     bool hasCompletionModel() const;
 
@@ -282,6 +294,9 @@ private:
 
     QTimer *m_updateBestMatchesTimer;
 
+    // large completion lists are filtered in parallel
+    QThreadPool m_filterPool;
+
     Group *m_ungrouped;
     Group *m_argumentHints; // The argument-hints will be passed on to another model, to be shown in another widget
     Group *m_bestMatches; // A temporary group used for holding the best matches of all visible items
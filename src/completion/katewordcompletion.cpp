@@ -35,10 +35,167 @@
 #include <QSpinBox>
 #include <QString>
 
+#include <algorithm>
+
 // END
 
-/// amount of lines to scan backwards and forwards
-static const int maxLinesToScan = 10000;
+// BEGIN KateWordCompletionIndex
+KateWordCompletionIndex::KateWordCompletionIndex(KTextEditor::Document *document)
+    : QObject(document)
+    , m_document(document)
+{
+    auto doc = static_cast<KTextEditor::DocumentPrivate *>(document);
+    connect(doc, &KTextEditor::DocumentPrivate::textInsertedRange, this, [this](KTextEditor::Document *, KTextEditor::Range range) {
+        textInserted(range);
+    });
+    connect(doc, &KTextEditor::Document::textRemoved, this, [this](KTextEditor::Document *, KTextEditor::Range range, const QString &) {
+        textRemoved(range);
+    });
+
+    // the content is replaced without edit signals on reload and close
+    connect(doc, &KTextEditor::Document::aboutToInvalidateMovingInterfaceContent, this, [this]() {
+        m_reset = true;
+    });
+}
+
+const QMap<QString, int> &KateWordCompletionIndex::words()
+{
+    // full rebuild after reloads or if we lost track of the line structure
+    const int lines = m_document->lines();
+    if (m_reset || int(m_lines.size()) != lines) {
+        m_reset = false;
+        m_words.clear();
+        m_lines.assign(lines, Line());
+        m_dirtyStart = 0;
+        m_dirtyEnd = lines - 1;
+    }
+
+    for (int line = m_dirtyStart; line <= m_dirtyEnd; ++line) {
+        if (m_lines[line].dirty) {
+            updateLine(line);
+        }
+    }
+    m_dirtyStart = 0;
+    m_dirtyEnd = -1;
+
+    return m_words;
+}
+
+void KateWordCompletionIndex::textInserted(KTextEditor::Range range)
+{
+    if (m_reset) {
+        return;
+    }
+
+    // a range spanning several lines did add lines, unless they were already announced one by one
+    const int line = range.start().line();
+    const int newLines = range.end().line() - line;
+    const int lines = m_document->lines();
+    if (newLines > 0 && int(m_lines.size()) != lines) {
+        if (line >= int(m_lines.size()) || int(m_lines.size()) + newLines != lines) {
+            m_reset = true;
+            return;
+        }
+
+        m_lines.insert(m_lines.begin() + line + 1, newLines, Line());
+        if (m_dirtyStart > line) {
+            m_dirtyStart += newLines;
+        }
+        if (m_dirtyEnd > line) {
+            m_dirtyEnd += newLines;
+        }
+    }
+
+    markDirty(line, range.end().line());
+}
+
+void KateWordCompletionIndex::textRemoved(KTextEditor::Range range)
+{
+    if (m_reset) {
+        return;
+    }
+
+    const int line = range.start().line();
+    const int removedLines = range.end().line() - line;
+    const int lines = m_document->lines();
+    if (removedLines > 0 && int(m_lines.size()) != lines) {
+        if (line >= lines || int(m_lines.size()) - removedLines != lines) {
+            m_reset = true;
+            return;
+        }
+
+        const auto first = m_lines.begin() + line + 1;
+        const auto last = first + removedLines;
+        for (auto it = first; it != last; ++it) {
+            removeWords(it->text);
+        }
+        m_lines.erase(first, last);
+
+        m_dirtyStart = m_dirtyStart > line ? std::max(line, m_dirtyStart - removedLines) : m_dirtyStart;
+        m_dirtyEnd = m_dirtyEnd > line ? std::max(line, m_dirtyEnd - removedLines) : m_dirtyEnd;
+        markDirty(line, line);
+        return;
+    }
+
+    markDirty(line, range.end().line());
+}
+
+void KateWordCompletionIndex::markDirty(int startLine, int endLine)
+{
+    startLine = std::max(0, startLine);
+    endLine = std::min(endLine, int(m_lines.size()) - 1);
+    if (endLine < startLine) {
+        return;
+    }
+
+    for (int line = startLine; line <= endLine; ++line) {
+        m_lines[line].dirty = true;
+    }
+
+    if (m_dirtyEnd < m_dirtyStart) {
+        m_dirtyStart = startLine;
+        m_dirtyEnd = endLine;
+    } else {
+        m_dirtyStart = std::min(m_dirtyStart, startLine);
+        m_dirtyEnd = std::max(m_dirtyEnd, endLine);
+    }
+}
+
+void KateWordCompletionIndex::updateLine(int line)
+{
+    Line &entry = m_lines[line];
+    entry.dirty = false;
+
+    // unchanged lines still share their text with the document
+    QString text = m_document->line(line);
+    if (text.isSharedWith(entry.text)) {
+        return;
+    }
+
+    removeWords(entry.text);
+    entry.text = std::move(text);
+
+    // single characters are never offered, no need to count them
+    forEachWord(entry.text, [this](QStringView word, int) {
+        if (word.size() >= 2) {
+            ++m_words[word.toString()];
+        }
+    });
+}
+
+void KateWordCompletionIndex::removeWords(const QString &text)
+{
+    forEachWord(text, [this](QStringView word, int) {
+        if (word.size() < 2) {
+            return;
+        }
+        const auto it = m_words.find(word.toString());
+        if (it != m_words.end() && --it.value() <= 0) {
+            m_words.erase(it);
+        }
+    });
+}
+// END KateWordCompletionIndex
 
 // BEGIN KateWordCompletionModel
 KateWordCompletionModel::KateWordCompletionModel(QObject *parent)
@@ -50,6 +207,19 @@ KateWordCompletionModel::KateWordCompletionModel(QObject *parent)
 
 KateWordCompletionModel::~KateWordCompletionModel()
 {
+    qDeleteAll(m_indices);
+}
+
+KateWordCompletionIndex *KateWordCompletionModel::wordIndex(KTextEditor::Document *document)
+{
+    auto &index = m_indices[document];
+    if (!index) {
+        index = new KateWordCompletionIndex(document);
+        connect(document, &QObject::destroyed, this, [this, document]() {
+            m_indices.remove(document);
+        });
+    }
+    return index;
 }
 
 void KateWordCompletionModel::saveMatches(KTextEditor::View *view, const KTextEditor::Range &range)
@@ -184,72 +354,79 @@ void KateWordCompletionModel::completionInvoked(KTextEditor::View *view, const K
 }
 
 /**
- * Scan throughout the entire document for possible completions,
+ * Collect the possible completions from the word index of the document,
  * ignoring any dublets and words shorter than configured and/or
  * reasonable minimum length.
  */
-QStringList KateWordCompletionModel::allMatches(KTextEditor::View *view, const KTextEditor::Range &range)
+QStringList KateWordCompletionModel::allMatches(KTextEditor::View *view, const KTextEditor::Range &range, const QString &prefix)
 {
-    QSet<QStringView> result;
-    const int minWordSize = qMax(2, qobject_cast<KTextEditor::ViewPrivate *>(view)->config()->wordCompletionMinimalWordLength());
+    const auto config = qobject_cast<KTextEditor::ViewPrivate *>(view)->config();
+    const int minWordSize = qMax(2, config->wordCompletionMinimalWordLength());
     const auto cursorPosition = view->cursorPosition();
     const auto document = view->document();
-    const int startLine = std::max(0, cursorPosition.line() - maxLinesToScan);
-    const int endLine = std::min(cursorPosition.line() + maxLinesToScan, view->document()->lines());
-    for (int line = startLine; line < endLine; line++) {
-        const QString text = document->line(line);
-        if (text.isEmpty() || text.isNull()) {
-            continue;
+
+    // don't add the word we are inside with cursor or the one we complete, unless it occurs elsewhere, too
+    QHash<QString, int> excluded;
+    const auto excludeWords = [&](int line) {
+        if (line < 0 || line >= document->lines()) {
+            return;
         }
-        QStringView textView = text;
-        int wordBegin = 0;
-        int offset = 0;
-        const int end = text.size();
-        const bool cursorLine = cursorPosition.line() == line;
-        const bool isNotLastLine = line != range.end().line();
-        const QChar *d = text.data();
-        while (offset < end) {
-            const QChar c = d[offset];
-            // increment offset when at line end, so we take the last character too
-            if ((!c.isLetterOrNumber() && c != QChar(u'_')) || (offset == end - 1 && offset++)) {
-                if (offset - wordBegin >= minWordSize && (isNotLastLine || offset != range.end().column())) {
-                    // don't add the word we are inside with cursor!
-                    if (!cursorLine || (cursorPosition.column() < wordBegin || cursorPosition.column() > offset)) {
-                        result.insert(textView.mid(wordBegin, offset - wordBegin));
-                    }
-                }
-                wordBegin = offset + 1;
+        KateWordCompletionIndex::forEachWord(document->line(line), [&](QStringView word, int column) {
+            const int end = column + int(word.size());
+            if ((line == cursorPosition.line() && cursorPosition.column() >= column && cursorPosition.column() <= end)
+                || (line == range.end().line() && end == range.end().column())) {
+                ++excluded[word.toString()];
             }
-            if (c.isSpace()) {
-                wordBegin = offset + 1;
+        });
+    };
+    excludeWords(cursorPosition.line());
+    if (range.end().line() != cursorPosition.line()) {
+        excludeWords(range.end().line());
+    }
+
+    QSet<QString> result;
+    const auto addWords = [&](KTextEditor::Document *doc) {
+        const auto &words = wordIndex(doc)->words();
+        for (auto it = words.lowerBound(prefix); it != words.cend() && it.key().startsWith(prefix); ++it) {
+            if (it.key().size() >= minWordSize && (doc != document || it.value() > excluded.value(it.key()))) {
+                result.insert(it.key());
+            }
+        }
+    };
+    addWords(document);
+    if (config->wordCompletionAllDocuments()) {
+        const auto documents = KTextEditor::EditorPrivate::self()->documents();
+        for (auto doc : documents) {
+            if (doc != document) {
+                addWords(doc);
             }
-            offset += 1;
         }
     }
 
     // ensure words that are ok spell check wise always end up in the completion, see bug 468705
     const auto language = static_cast<KTextEditor::DocumentPrivate *>(document)->defaultDictionary();
     const auto word = view->document()->text(range);
-    Sonnet::Speller speller;
-    QStringList spellerSuggestions;
-    speller.setLanguage(language);
-    if (speller.isValid()) {
-        if (speller.isCorrect(word)) {
+    if (!m_speller) {
+        m_speller = std::make_unique<Sonnet::Speller>(language);
+        m_spellerLanguage = language;
+    } else if (m_spellerLanguage != language) {
+        m_speller->setLanguage(language);
+        m_spellerLanguage = language;
+    }
+    if (m_speller->isValid()) {
+        if (m_speller->isCorrect(word)) {
             result.insert(word);
         } else {
-            spellerSuggestions = speller.suggest(word);
-            for (const auto &alternative : std::as_const(spellerSuggestions)) {
-                result.insert(alternative);
+            const QStringList spellerSuggestions = m_speller->suggest(word);
+            for (const auto &alternative : spellerSuggestions) {
+                if (alternative.startsWith(prefix)) {
+                    result.insert(alternative);
+                }
             }
         }
     }
 
-    m_matches.clear();
-    m_matches.reserve(result.size());
-    for (auto v : std::as_const(result)) {
-        m_matches << v.toString();
-    }
-
+    m_matches = QStringList(result.cbegin(), result.cend());
     return m_matches;
 }
 
@@ -358,7 +535,7 @@ void KateWordCompletionView::shellComplete()
 {
     KTextEditor::Range r = range();
 
-    const QStringList matches = m_dWCompletionModel->allMatches(m_view, r);
+    const QStringList matches = m_dWCompletionModel->allMatches(m_view, r, m_view->document()->text(r));
 
     if (matches.size() == 0) {
         return;
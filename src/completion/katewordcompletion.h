@@ -13,12 +13,90 @@
 #include <ktexteditor/view.h>
 
 #include <QEvent>
+#include <QHash>
 #include <QList>
+#include <QMap>
 #include <QObject>
 
 #include "katepartdebug.h"
 #include <ktexteditor_export.h>
 
+#include <memory>
+#include <vector>
+
+namespace Sonnet
+{
+class Speller;
+}
+
+/**
+ * Occurrence count of all words of one document.
+ *
+ * The index follows the edits of the document and only rescans the lines
+ * they touched, lazily on the next lookup. The words are kept sorted, all
+ * words sharing a prefix form one contiguous range of the map.
+ *
+ * To remove the words of a changed line from the counts, the index keeps the
+ * text of each line it counted. It is implicitly shared with the document,
+ * only lines changed since the last lookup hold an own copy.
+ */
+class KateWordCompletionIndex : public QObject
+{
+public:
+    /**
+     * Create the index for @p document, it becomes a child of the document.
+     */
+    explicit KateWordCompletionIndex(KTextEditor::Document *document);
+
+    /**
+     * All words of the document with their number of occurrences,
+     * brought up to date with the document first.
+     */
+    KTEXTEDITOR_EXPORT const QMap<QString, int> &words();
+
+    /**
+     * Split @p text into words, maximal runs of letters, numbers and underscores.
+     * @param func called with the word and its start column for each word
+     */
+    template<typename Func>
+    static void forEachWord(QStringView text, Func &&func)
+    {
+        const qsizetype end = text.size();
+        qsizetype wordBegin = 0;
+        for (qsizetype offset = 0; offset <= end; ++offset) {
+            if (offset == end || !(text[offset].isLetterOrNumber() || text[offset] == QLatin1Char('_'))) {
+                if (offset > wordBegin) {
+                    func(text.mid(wordBegin, offset - wordBegin), int(wordBegin));
+                }
+                wordBegin = offset + 1;
+            }
+        }
+    }
+
+private:
+    void textInserted(KTextEditor::Range range);
+    void textRemoved(KTextEditor::Range range);
+    void markDirty(int startLine, int endLine);
+    void updateLine(int line);
+    void removeWords(const QString &text);
+
+    struct Line {
+        QString text;
+        bool dirty = true;
+    };
+
+    KTextEditor::Document *const m_document;
+    std::vector<Line> m_lines;
+    QMap<QString, int> m_words;
+
+    /// lines m_dirtyStart up to m_dirtyEnd may contain dirty lines
+    int m_dirtyStart = 0;
+    int m_dirtyEnd = -1;
+
+    /// the document content was replaced, rebuild everything on the next lookup
+    bool m_reset = true;
+};
+
 class KateWordCompletionModel : public KTextEditor::CodeCompletionModel, public KTextEditor::CodeCompletionModelControllerInterface
 {
     Q_OBJECT
@@ -53,13 +131,30 @@ public:
 
     bool shouldHideItemsWithEqualNames() const override;
 
-    KTEXTEDITOR_EXPORT QStringList allMatches(KTextEditor::View *view, const KTextEditor::Range &range);
+    /**
+     * All words to offer for completing @p range in @p view.
+     * @param prefix only return words starting with it
+     */
+    KTEXTEDITOR_EXPORT QStringList allMatches(KTextEditor::View *view, const KTextEditor::Range &range, const QString &prefix = QString());
 
     void executeCompletionItem(KTextEditor::View *view, const KTextEditor::Range &word, const QModelIndex &index) const override;
 
 private:
+    /**
+     * The word index of @p document, created on first use.
+     */
+    KateWordCompletionIndex *wordIndex(KTextEditor::Document *document);
+
     QStringList m_matches;
     bool m_automatic;
+
+    /// word indices of the documents we did complete in, deleted by us, but they
+    /// are children of their documents and go away together with them, too
+    QHash<KTextEditor::Document *, KateWordCompletionIndex *> m_indices;
+
+    /// spell checker for the suggestions, only rebuilt if the language changes
+    std::unique_ptr<Sonnet::Speller> m_speller;
+    QString m_spellerLanguage;
 };
 
 class KateWordCompletionView : public QObject
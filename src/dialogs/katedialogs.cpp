@@ -236,6 +236,7 @@ KateCompletionConfigTab::KateCompletionConfigTab(QWidget *parent)
     observeChanges(ui->gbWordCompletion);
     observeChanges(ui->minimalWordLength);
     observeChanges(ui->removeTail);
+    observeChanges(ui->allDocuments);
 
     layout->addWidget(newWidget);
 }
@@ -268,6 +269,7 @@ void KateCompletionConfigTab::apply()
     KateViewConfig::global()->setValue(KateViewConfig::WordCompletion, ui->gbWordCompletion->isChecked());
     KateViewConfig::global()->setValue(KateViewConfig::WordCompletionMinimalWordLength, ui->minimalWordLength->value());
     KateViewConfig::global()->setValue(KateViewConfig::WordCompletionRemoveTail, ui->removeTail->isChecked());
+    KateViewConfig::global()->setValue(KateViewConfig::WordCompletionAllDocuments, ui->allDocuments->isChecked());
     KateViewConfig::global()->setValue(KateViewConfig::ShowDocWithCompletion, ui->gbShowDoc->isChecked());
 
     KateViewConfig::global()->configEnd();
@@ -286,6 +288,7 @@ void KateCompletionConfigTab::reload()
 
     ui->minimalWordLength->setValue(KateViewConfig::global()->wordCompletionMinimalWordLength());
     ui->removeTail->setChecked(KateViewConfig::global()->wordCompletionRemoveTail());
+    ui->allDocuments->setChecked(KateViewConfig::global()->wordCompletionAllDocuments());
 }
 
 QString KateCompletionConfigTab::name() const
@@ -344,6 +347,9 @@ void KateSpellCheckConfigTab::apply()
     KateDocumentConfig::global()->setOnTheFlySpellCheck(settings.value(QStringLiteral("checkerEnabledByDefault"), false).toBool());
     KateDocumentConfig::global()->configEnd();
 
+    // personal words, ignored words or the default language might have changed
+    KTextEditor::EditorPrivate::self()->spellCheckManager()->wordCache().clear();
+
     const auto docs = KTextEditor::EditorPrivate::self()->documents();
     for (KTextEditor::Document *doc : docs) {
         static_cast<KTextEditor::DocumentPrivate *>(doc)->refreshOnTheFlyCheck();
@@ -25,6 +25,17 @@
 #include <QStringEncoder>
 #include <QTextStream>
 
+/**
+ * Lines behind the highlighted area up to this distance are highlighted synchronously,
+ * the round trip to the background job is not worth it for them.
+ */
+static constexpr int AsyncHighlightingMinDistance = 256;
+
+/**
+ * Number of lines a background highlighting job handles before it publishes its results.
+ */
+static constexpr int AsyncHighlightingBatchSize = 4096;
+
 /**
  * Create an empty buffer. (with one block with one empty line)
  */
@@ -38,12 +49,18 @@ KateBuffer::KateBuffer(KTextEditor::DocumentPrivate *doc)
     , m_tabWidth(8)
     , m_lineHighlighted(0)
 {
+    m_highlightingPool.setMaxThreadCount(1);
 }
 
 /**
  * Cleanup on destruction
  */
-KateBuffer::~KateBuffer() = default;
+KateBuffer::~KateBuffer()
+{
+    // jobs access this buffer, let them abort before we vanish
+    cancelHighlightingJob();
+    m_highlightingPool.waitForDone();
+}
 
 void KateBuffer::editStart()
 {
@@ -69,6 +86,20 @@ void KateBuffer::editEnd()
     Q_ASSERT(editingMaximalLineChanged() != -1);
     Q_ASSERT(editingMinimalLineChanged() <= editingMaximalLineChanged());
 
+    // background results are based on the old text
+    cancelHighlightingJob();
+
+    // earlier highlighting results of changed lines are useless for convergence
+    const int firstChangedLine = editingMinimalLineChanged();
+    if (firstChangedLine >= m_lineHighlighted) {
+        m_staleHighlightedEnd = qMin(m_staleHighlightedEnd, firstChangedLine);
+    } else if (editingMaximalLineChanged() >= m_lineHighlighted) {
+        m_staleHighlightedEnd = 0;
+    }
+    for (auto it = m_highlightedLinesOfOtherModes.begin(); it != m_highlightedLinesOfOtherModes.end(); ++it) {
+        it.value() = qMin(it.value(), firstChangedLine);
+    }
+
     updateHighlighting();
 }
 
@@ -101,6 +132,10 @@ void KateBuffer::clear()
 
     // back to line 0 with hl
     m_lineHighlighted = 0;
+    m_staleHighlightedEnd = 0;
+    m_highlightedLinesOfOtherModes.clear();
+    m_asyncHighlightingTarget = -1;
+    cancelHighlightingJob();
 }
 
 bool KateBuffer::openFile(const QString &m_file, bool enforceTextCodec)
@@ -249,11 +284,145 @@ void KateBuffer::ensureHighlighted(int line, int lookAhead)
         return;
     }
 
+    // no hl around, no stuff to do
+    if (!m_highlight || m_highlight->noHighlighting()) {
+        return;
+    }
+
     // update hl until this line + max lookAhead
     int end = qMin(line + lookAhead, lines() - 1);
 
     // ensure we have enough highlighted
-    doHighlight(m_lineHighlighted, end, false);
+    // converging with earlier results might stop before end, continue behind them
+    while (line >= m_lineHighlighted) {
+        doHighlight(m_lineHighlighted, end, false);
+    }
+}
+
+bool KateBuffer::ensureHighlightedAsync(int line, int lookAhead)
+{
+    // valid line at all? already hl up-to-date for this line? nothing to highlight?
+    if (line < 0 || line >= lines() || line < m_lineHighlighted || !m_highlight || m_highlight->noHighlighting()) {
+        return true;
+    }
+
+    // the running background job will get there
+    if (m_highlightingJobRunning && line <= m_asyncHighlightingTarget) {
+        return false;
+    }
+
+    // near the highlighted area we just do it
+    if (line - m_lineHighlighted < AsyncHighlightingMinDistance) {
+        ensureHighlighted(line, lookAhead);
+        return true;
+    }
+
+    // let the background job walk forward until it reaches this line + max lookAhead
+    m_asyncHighlightingTarget = std::max(m_asyncHighlightingTarget, qMin(line + lookAhead, lines() - 1));
+    startHighlightingJob();
+    return false;
+}
+
+void KateBuffer::startHighlightingJob()
+{
+    // one job at a time, the next batch is started once the results arrived
+    if (m_highlightingJobRunning) {
+        return;
+    }
+
+    // done?
+    if (m_asyncHighlightingTarget < m_lineHighlighted || !m_highlight || m_highlight->noHighlighting()) {
+        m_asyncHighlightingTarget = -1;
+        return;
+    }
+
+    // the highlighting is stateful, the job needs its own instance
+    if (!m_backgroundHighlight) {
+        m_backgroundHighlight = m_highlight->clone();
+    }
+
+    // snapshot the text of the next batch, the strings are implicitly shared
+    // the state to start with is the one of the last highlighted line
+    const int firstLine = m_lineHighlighted;
+    const int endLine = qMin(qMin(m_asyncHighlightingTarget + 1, firstLine + AsyncHighlightingBatchSize), lines());
+    std::vector<Kate::TextLine> textLines;
+    textLines.reserve(endLine - firstLine + 1);
+    textLines.push_back(plainLine(firstLine - 1));
+    for (int line = firstLine; line < endLine; ++line) {
+        textLines.push_back(plainLine(line));
+    }
+
+    m_highlightingJobRunning = true;
+    m_highlightingPool.start([this,
+                              highlight = m_backgroundHighlight,
+                              generation = m_highlightingGeneration.load(),
+                              revision = revision(),
+                              firstLine,
+                              staleEnd = m_staleHighlightedEnd,
+                              textLines = std::move(textLines)]() mutable {
+        // first entry is only the previous line, if any
+        bool converged = false;
+        for (size_t i = 1; i < textLines.size(); ++i) {
+            // edits or a new highlighting make our work useless
+            if (generation != m_highlightingGeneration.load(std::memory_order_relaxed)) {
+                textLines.clear();
+                break;
+            }
+
+            bool ctxChanged = false;
+            const int line = firstLine + int(i) - 1;
+            highlight->doHighlight((line >= 1) ? &textLines[i - 1] : nullptr, &textLines[i], ctxChanged);
+
+            // reproduced the end state of an earlier run, see doHighlight
+            if (!ctxChanged && line < staleEnd) {
+                textLines.resize(i + 1);
+                converged = true;
+                break;
+            }
+        }
+
+        // always report back, the buffer needs to know the job is done
+        if (!textLines.empty()) {
+            textLines.erase(textLines.begin());
+        }
+        QMetaObject::invokeMethod(
+            this,
+            [this, generation, revision, firstLine, converged, textLines = std::move(textLines)]() {
+                finishHighlightingJob(generation, revision, firstLine, converged, textLines);
+            },
+            Qt::QueuedConnection);
+    });
+}
+
+void KateBuffer::finishHighlightingJob(quint64 generation, qint64 revision, int firstLine, bool converged, const std::vector<Kate::TextLine> &textLines)
+{
+    m_highlightingJobRunning = false;
+
+    // results still valid? the synchronous highlighting might have overtaken us meanwhile
+    const int endLine = firstLine + int(textLines.size());
+    if (generation == m_highlightingGeneration && revision == this->revision() && firstLine <= m_lineHighlighted && m_lineHighlighted < endLine
+        && endLine <= lines()) {
+        const int oldHighlighted = m_lineHighlighted;
+        for (int line = m_lineHighlighted; line < endLine; ++line) {
+            setLineMetaData(line, textLines[line - firstLine]);
+        }
+        m_lineHighlighted = endLine;
+
+        // the results of an earlier run behind are valid again
+        if (converged && m_staleHighlightedEnd > m_lineHighlighted) {
+            m_lineHighlighted = m_staleHighlightedEnd;
+        }
+        if (m_staleHighlightedEnd <= m_lineHighlighted) {
+            m_staleHighlightedEnd = 0;
+        }
+
+        // let the views pick up the new attributes
+        Q_EMIT tagLines({oldHighlighted, endLine - 1});
+        m_doc->repaintViews(true);
+    }
+
+    // continue with the next batch, if needed
+    startHighlightingJob();
 }
 
 void KateBuffer::wrapLine(const KTextEditor::Cursor position)
@@ -264,6 +433,10 @@ void KateBuffer::wrapLine(const KTextEditor::Cursor position)
     if (m_lineHighlighted > position.line() + 1) {
         m_lineHighlighted++;
     }
+
+    if (m_staleHighlightedEnd > position.line() + 1) {
+        m_staleHighlightedEnd++;
+    }
 }
 
 void KateBuffer::unwrapLine(int line)
@@ -274,6 +447,10 @@ void KateBuffer::unwrapLine(int line)
     if (m_lineHighlighted > line) {
         --m_lineHighlighted;
     }
+
+    if (m_staleHighlightedEnd > line) {
+        --m_staleHighlightedEnd;
+    }
 }
 
 void KateBuffer::setTabWidth(int w)
@@ -299,12 +476,23 @@ void KateBuffer::setHighlight(int hlMode)
             invalidate = true;
         }
 
+        // remember how far the old highlighting got, its results are still in the lines
+        // a new object for the same mode is a reloaded definition, the results are useless for it
+        if (m_highlight && m_lineHighlighted > 0 && m_highlight->name() != h->name()) {
+            m_highlightedLinesOfOtherModes[m_highlight->name()] = m_lineHighlighted;
+        }
+
         m_highlight = h;
+        m_backgroundHighlight.reset();
+        cancelHighlightingJob();
 
         if (invalidate) {
             invalidateHighlighting();
         }
 
+        // switching back? re-highlighting stops as soon as it reproduces the lines not overwritten meanwhile
+        m_staleHighlightedEnd = m_highlightedLinesOfOtherModes.take(h->name());
+
         // inform the document that the hl was really changed
         // needed to update attributes and more ;)
         m_doc->bufferHlChanged();
@@ -318,7 +506,10 @@ void KateBuffer::setHighlight(int hlMode)
 
 void KateBuffer::invalidateHighlighting()
 {
+    // keep the old results for convergence, in most cases re-highlighting reproduces them after the first line
+    m_staleHighlightedEnd = m_lineHighlighted;
     m_lineHighlighted = 0;
+    cancelHighlightingJob();
 }
 
 void KateBuffer::doHighlight(int startLine, int endLine, bool invalidate)
@@ -343,6 +534,8 @@ void KateBuffer::doHighlight(int startLine, int endLine, bool invalidate)
     int start_spellchecking = -1;
     int last_line_spellchecking = -1;
     bool ctxChanged = false;
+    bool converged = false;
+    const int oldHighlighted = m_lineHighlighted;
     // loop over the lines of the block, from startline to endline or end of block
     // if stillcontinue forces us to do so
     for (; current_line < qMin(endLine + 1, lines()); ++current_line) {
@@ -374,13 +567,29 @@ void KateBuffer::doHighlight(int startLine, int endLine, bool invalidate)
         } else if (!stillcontinue && start_spellchecking >= 0) {
             last_line_spellchecking = current_line;
         }
+
+        // lines behind the highlighted area might still hold the results of an earlier run
+        // if we reproduce the end state of such a line, all results behind it up to m_staleHighlightedEnd are valid again
+        if (!ctxChanged && current_line >= oldHighlighted && current_line < m_staleHighlightedEnd) {
+            converged = true;
+            ++current_line;
+            break;
+        }
     }
 
     // perhaps we need to adjust the maximal highlighted line
-    int oldHighlighted = m_lineHighlighted;
-    if (ctxChanged || current_line > m_lineHighlighted) {
+    if (converged) {
+        m_lineHighlighted = m_staleHighlightedEnd;
+    } else if (ctxChanged || current_line > m_lineHighlighted) {
+        // cut back: the results behind are based on the old state, keep them for convergence
+        if (current_line < oldHighlighted) {
+            m_staleHighlightedEnd = oldHighlighted;
+        }
         m_lineHighlighted = current_line;
     }
+    if (m_staleHighlightedEnd <= m_lineHighlighted) {
+        m_staleHighlightedEnd = 0;
+    }
 
     // tag the changed lines !
     if (invalidate) {
@@ -13,7 +13,12 @@
 
 #include <ktexteditor_export.h>
 
+#include <QHash>
 #include <QObject>
+#include <QThreadPool>
+
+#include <atomic>
+#include <memory>
 
 class KateLineInfo;
 namespace KTextEditor
@@ -182,6 +187,17 @@ public:
      */
     void ensureHighlighted(int line, int lookAhead = 64);
 
+    /**
+     * Like ensureHighlighted, but lines far behind the highlighted area are highlighted
+     * by a background job instead of blocking the caller.
+     * Until the results arrive, the line keeps its old attributes, e.g. is drawn in the plain text style.
+     * Arriving results are announced via tagLines.
+     * @param line line that shall be highlighted
+     * @param lookAhead also highlight these following lines
+     * @return line is highlighted now
+     */
+    bool ensureHighlightedAsync(int line, int lookAhead = 64);
+
     /**
      * Unwrap given line.
      * @param line line to unwrap
@@ -221,6 +237,14 @@ public:
      */
     void invalidateHighlighting();
 
+    /**
+     * Forget how far the highlightings used before got, e.g. because their definitions got reloaded.
+     */
+    void discardEarlierHighlightingResults()
+    {
+        m_highlightedLinesOfOtherModes.clear();
+    }
+
     /**
      * Compute folding vector for the given line, will internally do a re-highlighting.
      * @param line line to get folding vector for
@@ -254,6 +278,33 @@ private:
     KTEXTEDITOR_NO_EXPORT
     void doHighlight(int from, int to, bool invalidate);
 
+    /**
+     * Start a background job highlighting the next batch of lines behind m_lineHighlighted,
+     * if none is running and the wanted line is not yet reached.
+     */
+    KTEXTEDITOR_NO_EXPORT
+    void startHighlightingJob();
+
+    /**
+     * Take over the results of a background highlighting job.
+     * Outdated results are dropped, the next batch is started if needed.
+     * @param generation highlighting generation the job was started in
+     * @param revision buffer revision the job was started in
+     * @param firstLine line of the first highlighted line
+     * @param converged the last line reproduced the results of an earlier run
+     * @param textLines highlighted lines
+     */
+    KTEXTEDITOR_NO_EXPORT
+    void finishHighlightingJob(quint64 generation, qint64 revision, int firstLine, bool converged, const std::vector<Kate::TextLine> &textLines);
+
+    /**
+     * Drop the results of running background highlighting jobs, e.g. after edits.
+     */
+    void cancelHighlightingJob()
+    {
+        ++m_highlightingGeneration;
+    }
+
 Q_SIGNALS:
     /**
      * Emitted when the highlighting of a certain range has
@@ -295,6 +346,45 @@ private:
      * last line with valid highlighting
      */
     int m_lineHighlighted;
+
+    /**
+     * The lines from m_lineHighlighted up to this one still hold the results of an earlier run of the current
+     * highlighting, computed from a start state that might be outdated. Once re-highlighting reproduces the
+     * end state of one of them, all results behind are valid again. 0 if there are no such lines.
+     */
+    int m_staleHighlightedEnd = 0;
+
+    /**
+     * For highlightings used before, by mode name, the number of lines at the start of the buffer
+     * they highlighted, limited to the lines not changed since.
+     * These results are still in the lines not overwritten by later highlightings.
+     */
+    QHash<QString, int> m_highlightedLinesOfOtherModes;
+
+    /**
+     * second instance of the current highlighting for the background jobs
+     */
+    std::shared_ptr<KateHighlighting> m_backgroundHighlight;
+
+    /**
+     * pool for the background highlighting, one job at a time
+     */
+    QThreadPool m_highlightingPool;
+
+    /**
+     * incremented on edits and invalidation, running jobs abort and their results get dropped
+     */
+    std::atomic<quint64> m_highlightingGeneration = 0;
+
+    /**
+     * last line wanted by ensureHighlightedAsync, -1 if none
+     */
+    int m_asyncHighlightingTarget = -1;
+
+    /**
+     * is a background highlighting job running?
+     */
+    bool m_highlightingJobRunning = false;
 };
 
 #endif
@@ -29,6 +29,7 @@
 #include "kateregexpsearch.h"
 #include "katerenderer.h"
 #include "katescriptmanager.h"
+#include "kateshapedlayoutcache.h"
 #include "kateswapfile.h"
 #include "katesyntaxmanager.h"
 #include "katetemplatehandler.h"
@@ -173,6 +174,7 @@ KTextEditor::DocumentPrivate::DocumentPrivate(const KPluginMetaData &data, bool
 
     m_buffer(new KateBuffer(this))
     , m_indenter(new KateAutoIndent(this))
+    , m_shapedLayoutCache(std::make_unique<KateShapedLayoutCache>())
     ,
 
     m_docName(QStringLiteral("need init"))
@@ -259,6 +261,15 @@ KTextEditor::DocumentPrivate::DocumentPrivate(const KPluginMetaData &data, bool
     connect(this, &KTextEditor::DocumentPrivate::sigQueryClose, this, &KTextEditor::DocumentPrivate::slotQueryClose_save);
 
     connect(this, &KTextEditor::DocumentPrivate::aboutToInvalidateMovingInterfaceContent, this, &KTextEditor::DocumentPrivate::clearEditingPosStack);
+
+    // drop lines kept by multi-line searches, they are outdated after changes and
+    // the buffer revision starts again at 0 for new content
+    const auto dropRegExpSearchWindow = [this]() {
+        m_regExpSearchWindow.reset();
+    };
+    connect(this, &KTextEditor::DocumentPrivate::textChanged, this, dropRegExpSearchWindow);
+    connect(this, &KTextEditor::DocumentPrivate::aboutToInvalidateMovingInterfaceContent, this, dropRegExpSearchWindow);
+
     onTheFlySpellCheckingEnabled(config()->onTheFlySpellCheck());
 
     // make sure correct defaults are set (indenter, ...)
@@ -913,11 +924,7 @@ bool KTextEditor::DocumentPrivate::removeLine(int line)
 
 qsizetype KTextEditor::DocumentPrivate::totalCharacters() const
 {
-    qsizetype l = 0;
-    for (int i = 0; i < m_buffer->lines(); ++i) {
-        l += m_buffer->lineLength(i);
-    }
-    return l;
+    return m_buffer->totalCharacters();
 }
 
 int KTextEditor::DocumentPrivate::lines() const
@@ -1749,6 +1756,14 @@ KTextEditor::DocumentPrivate::searchText(KTextEditor::Range range, const QString
     result.append(match);
     return result;
 }
+
+KateRegExpSearchWindow &KTextEditor::DocumentPrivate::regExpSearchWindow() const
+{
+    if (!m_regExpSearchWindow) {
+        m_regExpSearchWindow = std::make_unique<KateRegExpSearchWindow>();
+    }
+    return *m_regExpSearchWindow;
+}
 // END
 
 QWidget *KTextEditor::DocumentPrivate::dialogParent()
@@ -2552,8 +2567,7 @@ bool KTextEditor::DocumentPrivate::saveFile()
         return false;
     }
 
-    // update the checksum
-    createDigest();
+    // no need to update the checksum, the buffer computed it while writing the file
 
     // add m_file again to dirwatch
     activateDirWatch();
@@ -4956,7 +4970,11 @@ void KTextEditor::DocumentPrivate::documentSaveCopyAs()
         return;
     }
 
-    if (!m_buffer->saveFile(file->fileName())) {
+    // saving updates the checksum, but the copy is not our document on disk
+    const QByteArray digest = checksum();
+    const bool saved = m_buffer->saveFile(file->fileName());
+    m_buffer->setDigest(digest);
+    if (!saved) {
         KMessageBox::error(dialogParent(),
                            i18n("The document could not be saved, as it was not possible to write to %1.\n\nCheck that you have write access to this file or "
                                 "that enough disk space is available.",
@@ -5874,6 +5892,15 @@ void KTextEditor::DocumentPrivate::transformRange(KTextEditor::Range &range,
     m_buffer->history().transformRange(range, insertBehaviors, emptyBehavior, fromRevision, toRevision);
 }
 
+void KTextEditor::DocumentPrivate::transformRanges(std::span<KTextEditor::Range> ranges,
+                                                   KTextEditor::MovingRange::InsertBehaviors insertBehaviors,
+                                                   KTextEditor::MovingRange::EmptyBehavior emptyBehavior,
+                                                   qint64 fromRevision,
+                                                   qint64 toRevision)
+{
+    m_buffer->history().transformRanges(ranges, insertBehaviors, emptyBehavior, fromRevision, toRevision);
+}
+
 // END
 
 // BEGIN KTextEditor::AnnotationInterface
@@ -6297,12 +6324,13 @@ bool KTextEditor::DocumentPrivate::containsCharacterEncoding(KTextEditor::Range
 
     for (int line = range.start().line(); line <= rangeEndLine; ++line) {
         const Kate::TextLine textLine = kateTextLine(line);
+        KatePrefixStoreLineMatches prefixMatches(textLine);
         const int startColumn = (line == rangeStartLine) ? rangeStartColumn : 0;
         const int endColumn = (line == rangeEndLine) ? rangeEndColumn : textLine.length();
         for (int col = startColumn; col < endColumn; ++col) {
             int attr = textLine.attribute(col);
             const KatePrefixStore &prefixStore = highlighting->getCharacterEncodingsPrefixStore(attr);
-            if (!prefixStore.findPrefix(textLine, col).isEmpty()) {
+            if (prefixMatches.prefixLength(prefixStore, col) > 0) {
                 return true;
             }
         }
@@ -6344,14 +6372,16 @@ QString KTextEditor::DocumentPrivate::decodeCharacters(KTextEditor::Range range,
 
     for (int line = range.start().line(); line <= rangeEndLine; ++line) {
         textLine = kateTextLine(line);
+        KatePrefixStoreLineMatches prefixMatches(textLine);
         int startColumn = (line == rangeStartLine) ? rangeStartColumn : 0;
         int endColumn = (line == rangeEndLine) ? rangeEndColumn : textLine.length();
         for (int col = startColumn; col < endColumn;) {
             int attr = textLine.attribute(col);
             const KatePrefixStore &prefixStore = highlighting->getCharacterEncodingsPrefixStore(attr);
             const QHash<QString, QChar> &characterEncodingsHash = highlighting->getCharacterEncodings(attr);
-            QString matchingPrefix = prefixStore.findPrefix(textLine, col);
-            if (!matchingPrefix.isEmpty()) {
+            const int prefixLength = prefixMatches.prefixLength(prefixStore, col);
+            if (prefixLength > 0) {
+                const QString matchingPrefix = textLine.string(col, prefixLength);
                 toReturn += text(KTextEditor::Range(previous, KTextEditor::Cursor(line, col)));
                 const QChar &c = characterEncodingsHash.value(matchingPrefix);
                 const bool isNullChar = c.isNull();
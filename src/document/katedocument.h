@@ -21,6 +21,8 @@
 #include "katetextline.h"
 #include <ktexteditor_export.h>
 
+#include <span>
+
 class KJob;
 class KateTemplateHandler;
 namespace KTextEditor
@@ -50,6 +52,8 @@ class KateDocumentConfig;
 class KateHighlighting;
 class KateUndoManager;
 class KateOnTheFlyChecker;
+class KateShapedLayoutCache;
+class KateRegExpSearchWindow;
 class KateDocumentTest;
 
 class KateAutoIndent;
@@ -384,6 +388,14 @@ Q_SIGNALS:
 public:
     QList<KTextEditor::Range> searchText(KTextEditor::Range range, const QString &pattern, const KTextEditor::SearchOptions options) const;
 
+    /**
+     * Lines assembled by multi-line regular expression searches, reused by successive searches.
+     */
+    KateRegExpSearchWindow &regExpSearchWindow() const;
+
+private:
+    mutable std::unique_ptr<KateRegExpSearchWindow> m_regExpSearchWindow;
+
 private:
     /**
      * Return a widget suitable to be used as a dialog parent.
@@ -682,6 +694,22 @@ public:
                         qint64 fromRevision,
                         qint64 toRevision = -1) override;
 
+    /**
+     * Transform many ranges from one revision to an other, e.g. all diagnostics of a language server.
+     * Same as transformRange for each range, but without the per call overhead.
+     * The ranges should be sorted by position, as delivered by most clients, but this is no requirement.
+     * @param ranges ranges to transform in place
+     * @param insertBehaviors behavior of the ranges on insert of text at their position
+     * @param emptyBehavior behavior on becoming empty
+     * @param fromRevision from this revision we want to transform
+     * @param toRevision to this revision we want to transform, default of -1 is current revision
+     */
+    void transformRanges(std::span<KTextEditor::Range> ranges,
+                         KTextEditor::MovingRange::InsertBehaviors insertBehaviors,
+                         KTextEditor::MovingRange::EmptyBehavior emptyBehavior,
+                         qint64 fromRevision,
+                         qint64 toRevision = -1);
+
     //
     // Annotation Interface
     //
@@ -1088,6 +1116,23 @@ public:
         return *m_buffer;
     }
 
+    /**
+     * Get read-only access to buffer of this document.
+     * @return document buffer
+     */
+    const KateBuffer &buffer() const
+    {
+        return *m_buffer;
+    }
+
+    /**
+     * Layouts of lines, shared between all views of this document.
+     */
+    KateShapedLayoutCache &shapedLayoutCache()
+    {
+        return *m_shapedLayoutCache;
+    }
+
     /**
      * set indentation mode by user
      * this will remember that a user did set it and will avoid reset on save
@@ -1115,6 +1160,9 @@ private:
     // indenter
     KateAutoIndent *const m_indenter;
 
+    // layouts shared by the views
+    const std::unique_ptr<KateShapedLayoutCache> m_shapedLayoutCache;
+
     bool m_hlSetByUser = false;
     bool m_bomSetByUser = false;
     bool m_indenterSetByUser = false;
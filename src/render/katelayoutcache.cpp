@@ -102,10 +102,15 @@ KateLayoutCache::KateLayoutCache(KateRenderer *renderer, QObject *parent)
     connect(m_renderer->doc(), &KTextEditor::Document::lineUnwrapped, this, &KateLayoutCache::unwrapLine);
     connect(m_renderer->doc(), &KTextEditor::Document::textInserted, this, &KateLayoutCache::insertText);
     connect(m_renderer->doc(), &KTextEditor::Document::textRemoved, this, &KateLayoutCache::removeText);
+
+    // the edits are applied in one go once the editing transaction is done
+    connect(m_renderer->doc(), &KTextEditor::Document::editingFinished, this, &KateLayoutCache::applyPendingEdits);
 }
 
 void KateLayoutCache::updateViewCache(const KTextEditor::Cursor startPos, int newViewLineCount, int viewLinesScrolled)
 {
+    applyPendingEdits();
+
     // qCDebug(LOG_KTE) << startPos << " nvlc " << newViewLineCount << " vls " << viewLinesScrolled;
 
     int oldViewLineCount = m_textLayouts.size();
@@ -214,6 +219,8 @@ void KateLayoutCache::updateViewCache(const KTextEditor::Cursor startPos, int ne
 
 KateLineLayout *KateLayoutCache::line(int realLine, int virtualLine)
 {
+    applyPendingEdits();
+
     if (auto l = m_lineLayouts.find(realLine)) {
         // ensure line is OK
         Q_ASSERT(l->line() == realLine);
@@ -280,6 +287,7 @@ KateTextLayout KateLayoutCache::textLayout(uint realLine, int _viewLine)
 
 KateTextLayout &KateLayoutCache::viewLine(int _viewLine)
 {
+    applyPendingEdits();
     Q_ASSERT(_viewLine >= 0 && (size_t)_viewLine < m_textLayouts.size());
     return m_textLayouts[_viewLine];
 }
@@ -339,6 +347,7 @@ int KateLayoutCache::displayViewLine(const KTextEditor::Cursor virtualCursor, bo
         return -1;
     }
 
+    applyPendingEdits();
     KTextEditor::Cursor work = viewCacheStart();
 
     // only try this with valid lines!
@@ -436,26 +445,60 @@ void KateLayoutCache::viewCacheDebugOutput() const
 
 void KateLayoutCache::wrapLine(KTextEditor::Document *, const KTextEditor::Cursor position)
 {
-    m_lineLayouts.slotEditDone(position.line(), position.line() + 1, 1, m_textLayouts);
+    addPendingEdit(position.line(), position.line() + 1, 1);
 }
 
 void KateLayoutCache::unwrapLine(KTextEditor::Document *, int line)
 {
-    m_lineLayouts.slotEditDone(line - 1, line, -1, m_textLayouts);
+    addPendingEdit(line - 1, line, -1);
 }
 
 void KateLayoutCache::insertText(KTextEditor::Document *, const KTextEditor::Cursor position, const QString &)
 {
-    m_lineLayouts.slotEditDone(position.line(), position.line(), 0, m_textLayouts);
+    addPendingEdit(position.line(), position.line(), 0);
 }
 
 void KateLayoutCache::removeText(KTextEditor::Document *, KTextEditor::Range range, const QString &)
 {
-    m_lineLayouts.slotEditDone(range.start().line(), range.start().line(), 0, m_textLayouts);
+    addPendingEdit(range.start().line(), range.start().line(), 0);
+}
+
+void KateLayoutCache::addPendingEdit(int fromLine, int toLine, int shiftAmount)
+{
+    if (m_pendingFromLine < 0) {
+        m_pendingFromLine = fromLine;
+        m_pendingToLine = toLine;
+        m_pendingShift = shiftAmount;
+        return;
+    }
+
+    // map the edit back to the lines before the transaction, lines inside of the window map to its borders
+    const int windowEnd = m_pendingToLine + m_pendingShift;
+    const int from = fromLine < m_pendingFromLine ? fromLine : (fromLine <= windowEnd ? m_pendingFromLine : fromLine - m_pendingShift);
+    const int to = toLine < m_pendingFromLine ? toLine : (toLine <= windowEnd ? m_pendingToLine : toLine - m_pendingShift);
+
+    m_pendingFromLine = std::min(m_pendingFromLine, from);
+    m_pendingToLine = std::max(m_pendingToLine, to);
+    m_pendingShift += shiftAmount;
+}
+
+void KateLayoutCache::applyPendingEdits()
+{
+    if (m_pendingFromLine < 0) {
+        return;
+    }
+
+    m_lineLayouts.slotEditDone(m_pendingFromLine, m_pendingToLine, m_pendingShift, m_textLayouts);
+    m_pendingFromLine = -1;
+    m_pendingToLine = -1;
+    m_pendingShift = 0;
 }
 
 void KateLayoutCache::clear()
 {
+    m_pendingFromLine = -1;
+    m_pendingToLine = -1;
+    m_pendingShift = 0;
     m_textLayouts.clear();
     m_lineLayouts.clear();
     m_startPos = KTextEditor::Cursor(-1, -1);
@@ -463,6 +506,9 @@ void KateLayoutCache::clear()
 
 void KateLayoutCache::setViewWidth(int width)
 {
+    m_pendingFromLine = -1;
+    m_pendingToLine = -1;
+    m_pendingShift = 0;
     m_viewWidth = width;
     m_lineLayouts.clear();
     m_textLayouts.clear();
@@ -486,6 +532,8 @@ void KateLayoutCache::relayoutLines(int startRealLine, int endRealLine)
         qCWarning(LOG_KTE) << "start" << startRealLine << "before end" << endRealLine;
     }
 
+    applyPendingEdits();
+
     m_lineLayouts.relayoutLines(startRealLine, endRealLine);
 }
 
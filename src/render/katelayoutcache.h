@@ -134,6 +134,15 @@ private:
     void insertText(KTextEditor::Document *, const KTextEditor::Cursor position, const QString &text);
     void removeText(KTextEditor::Document *, KTextEditor::Range range, const QString &);
 
+    /**
+     * Record an edit of the running editing transaction.
+     * All edits are collapsed into one window of changed lines, applied by applyPendingEdits()
+     * once the transaction is finished or the cache is accessed.
+     * The lines are in the coordinates before this edit, like for KateLineLayoutMap::slotEditDone().
+     */
+    void addPendingEdit(int fromLine, int toLine, int shiftAmount);
+    void applyPendingEdits();
+
 private:
     KateRenderer *m_renderer;
 
@@ -150,6 +159,12 @@ private:
 
     std::vector<KateTextLayout> m_textLayouts;
 
+    // pending edits: lines [m_pendingFromLine, m_pendingToLine] before the transaction are changed,
+    // lines behind them are shifted by m_pendingShift, m_pendingFromLine is -1 if there are none
+    int m_pendingFromLine = -1;
+    int m_pendingToLine = -1;
+    int m_pendingShift = 0;
+
     int m_viewWidth = 0;
     bool m_wrap = false;
     bool m_acceptDirtyLayouts = false;
@@ -13,6 +13,7 @@
 
 #include "katepartdebug.h"
 
+#include "katebuffer.h"
 #include "katedocument.h"
 #include "katerenderer.h"
 
@@ -45,7 +46,11 @@ const Kate::TextLine &KateLineLayout::textLine(bool reloadForce) const
     if (reloadForce || !m_textLine) {
         m_textLine.reset();
         if (m_line >= 0 && m_line < m_renderer.doc()->lines()) {
-            m_textLine = usePlainTextLine ? m_renderer.doc()->plainKateTextLine(m_line) : m_renderer.doc()->kateTextLine(m_line);
+            // far away lines are highlighted in the background, until the results arrive they are drawn in the plain text style
+            if (!usePlainTextLine) {
+                m_renderer.doc()->buffer().ensureHighlightedAsync(m_line);
+            }
+            m_textLine = m_renderer.doc()->plainKateTextLine(m_line);
         }
     }
 
@@ -90,16 +95,14 @@ bool KateLineLayout::isValid() const
     return line() != -1 && layout() && (textLine(), m_textLine);
 }
 
-QTextLayout *KateLineLayout::layout() const
+const QTextLayout *KateLineLayout::layout() const
 {
     return m_layout.get();
 }
 
-void KateLineLayout::setLayout(QTextLayout *layout)
+void KateLineLayout::setLayout(std::shared_ptr<const QTextLayout> layout)
 {
-    if (m_layout.get() != layout) {
-        m_layout.reset(layout);
-    }
+    m_layout = std::move(layout);
 
     layoutDirty = !m_layout;
     m_dirtyList.clear();
@@ -112,7 +115,7 @@ void KateLineLayout::setLayout(QTextLayout *layout)
 
 void KateLineLayout::invalidateLayout()
 {
-    setLayout(nullptr);
+    setLayout(std::shared_ptr<const QTextLayout>());
 }
 
 bool KateLineLayout::isDirty(int viewLine) const
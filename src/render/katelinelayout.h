@@ -11,6 +11,7 @@
 #include <QExplicitlySharedDataPointer>
 #include <QSharedData>
 
+#include <memory>
 #include <optional>
 
 #include "katetextline.h"
@@ -70,8 +71,12 @@ public:
 
     bool startsInvisibleBlock() const;
 
-    QTextLayout *layout() const;
-    void setLayout(QTextLayout *layout);
+    /**
+     * Layouts from the KateShapedLayoutCache are shared with other line layouts,
+     * they must not be changed.
+     */
+    const QTextLayout *layout() const;
+    void setLayout(std::shared_ptr<const QTextLayout> layout);
     void invalidateLayout();
 
     bool layoutDirty = true;
@@ -95,7 +100,7 @@ private:
     int m_line;
     int m_virtualLine;
 
-    std::unique_ptr<QTextLayout> m_layout;
+    std::shared_ptr<const QTextLayout> m_layout;
     QList<bool> m_dirtyList;
 };
 
@@ -18,6 +18,7 @@
 #include "kateextendedattribute.h"
 #include "katehighlight.h"
 #include "katerenderrange.h"
+#include "kateshapedlayoutcache.h"
 #include "katetextlayout.h"
 #include "kateview.h"
 
@@ -35,6 +36,8 @@
 #include <QStack>
 #include <QtMath> // qCeil
 
+#include <optional>
+
 static const QChar tabChar(QLatin1Char('\t'));
 static const QChar spaceChar(QLatin1Char(' '));
 static const QChar nbSpaceChar(0xa0); // non-breaking space
@@ -1250,16 +1253,6 @@ void KateRenderer::layoutLine(KateLineLayout *lineLayout, int maxwidth, bool cac
 
     Kate::TextLine textLine = lineLayout->textLine();
 
-    QTextLayout *l = lineLayout->layout();
-    if (!l) {
-        l = new QTextLayout(textLine.text(), m_font);
-    } else {
-        l->setText(textLine.text());
-        l->setFont(m_font);
-    }
-
-    l->setCacheEnabled(cacheLayout);
-
     // Initial setup of the QTextLayout.
 
     // Tab width
@@ -1298,8 +1291,6 @@ void KateRenderer::layoutLine(KateLineLayout *lineLayout, int maxwidth, bool cac
         opt.setTextDirection(Qt::LeftToRight);
     }
 
-    l->setTextOption(opt);
-
     // Syntax highlighting, inbuilt and arbitrary
     QList<QTextLayout::FormatRange> decorations = decorationsForLine(textLine, lineLayout->line());
 
@@ -1342,7 +1333,7 @@ void KateRenderer::layoutLine(KateLineLayout *lineLayout, int maxwidth, bool cac
             // If it is outside of the text, we don't have to make space for it.
             if (column == 0) {
                 firstLineOffset = width;
-            } else if (column < l->text().length()) {
+            } else if (column < textLine.text().length()) {
                 QTextCharFormat text_char_format;
                 const qreal caretWidth = caretStyle() == KTextEditor::caretStyles::Line ? 2.0 : 0.0;
                 text_char_format.setFontLetterSpacing(width + caretWidth);
@@ -1351,6 +1342,37 @@ void KateRenderer::layoutLine(KateLineLayout *lineLayout, int maxwidth, bool cac
             }
         }
     }
+
+    // views of the same document share the layouts, the shaped glyphs are kept for them
+    const int alignIndent = (maxwidth != -1 && m_view) ? m_view->config()->dynWordWrapAlignIndent() : 0;
+    const bool shareLayout = m_view && !isPrinterFriendly();
+    std::optional<KateShapedLayoutCache::Key> cacheKey;
+    if (shareLayout) {
+        cacheKey = KateShapedLayoutCache::Key{textLine.text(),
+                                              m_font,
+                                              decorations,
+                                              opt.tabStopDistance(),
+                                              opt.wrapMode(),
+                                              opt.alignment(),
+                                              opt.textDirection(),
+                                              opt.flags(),
+                                              maxwidth,
+                                              firstLineOffset,
+                                              alignIndent,
+                                              lineHeight(),
+                                              m_fontAscent};
+        int shiftX = 0;
+        if (auto layout = m_doc->shapedLayoutCache().find(*cacheKey, shiftX)) {
+            lineLayout->shiftX = shiftX;
+            lineLayout->setLayout(std::move(layout));
+            return;
+        }
+    }
+
+    // always a fresh layout, the old one might be shared with other views
+    auto l = std::make_shared<QTextLayout>(textLine.text(), m_font);
+    l->setCacheEnabled(cacheLayout || shareLayout);
+    l->setTextOption(opt);
     l->setFormats(decorations);
 
     // Begin layouting
@@ -1358,8 +1380,9 @@ void KateRenderer::layoutLine(KateLineLayout *lineLayout, int maxwidth, bool cac
 
     int height = 0;
     int shiftX = 0;
+    lineLayout->shiftX = 0;
 
-    bool needShiftX = (maxwidth != -1) && m_view && (m_view->config()->dynWordWrapAlignIndent() > 0);
+    bool needShiftX = alignIndent > 0;
 
     while (true) {
         QTextLine line = l->createLine();
@@ -1404,6 +1427,10 @@ void KateRenderer::layoutLine(KateLineLayout *lineLayout, int maxwidth, bool cac
     l->endLayout();
 
     lineLayout->setLayout(l);
+
+    if (cacheKey) {
+        m_doc->shapedLayoutCache().insert(std::move(*cacheKey), std::move(l), lineLayout->shiftX);
+    }
 }
 
 // 1) QString::isRightToLeft() sux
@@ -0,0 +1,63 @@
+/*
+    SPDX-FileCopyrightText: 2026 KTextEditor contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "kateshapedlayoutcache.h"
+
+#include <QHashFunctions>
+
+bool KateShapedLayoutCache::Key::operator==(const Key &other) const
+{
+    return text == other.text && font == other.font && formats == other.formats && tabStopDistance == other.tabStopDistance && wrapMode == other.wrapMode
+        && alignment == other.alignment && textDirection == other.textDirection && flags == other.flags && maxWidth == other.maxWidth
+        && firstLineOffset == other.firstLineOffset && alignIndent == other.alignIndent && lineHeight == other.lineHeight && fontAscent == other.fontAscent;
+}
+
+size_t KateShapedLayoutCache::hashKey(const Key &key)
+{
+    // the formats are only hashed by their ranges, lines with equal text mostly have equal formats anyway
+    size_t hash = qHashMulti(0, key.text, key.font, key.maxWidth, key.firstLineOffset, int(key.textDirection), key.formats.size());
+    for (const auto &format : key.formats) {
+        hash = qHashMulti(hash, format.start, format.length);
+    }
+    return hash;
+}
+
+std::shared_ptr<const QTextLayout> KateShapedLayoutCache::find(const Key &key, int &shiftX)
+{
+    const auto it = m_index.constFind(hashKey(key));
+    if (it == m_index.cend() || !(it.value()->key == key)) {
+        return {};
+    }
+
+    // mark as recently used
+    m_entries.splice(m_entries.begin(), m_entries, it.value());
+    shiftX = it.value()->shiftX;
+    return it.value()->layout;
+}
+
+void KateShapedLayoutCache::insert(Key &&key, std::shared_ptr<const QTextLayout> layout, int shiftX)
+{
+    // same hash => replace the old entry, on collisions the newer layout wins
+    const size_t hash = hashKey(key);
+    if (const auto it = m_index.constFind(hash); it != m_index.cend()) {
+        m_entries.erase(it.value());
+    }
+
+    m_entries.push_front(Entry{hash, std::move(key), std::move(layout), shiftX});
+    m_index.insert(hash, m_entries.begin());
+
+    // drop the least recently used layouts, views still using them keep them alive
+    while (int(m_entries.size()) > MaximalSize) {
+        m_index.remove(m_entries.back().hash);
+        m_entries.pop_back();
+    }
+}
+
+void KateShapedLayoutCache::clear()
+{
+    m_index.clear();
+    m_entries.clear();
+}
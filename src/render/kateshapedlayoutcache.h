@@ -0,0 +1,104 @@
+/*
+    SPDX-FileCopyrightText: 2026 KTextEditor contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef KATE_SHAPEDLAYOUTCACHE_H
+#define KATE_SHAPEDLAYOUTCACHE_H
+
+#include <QFont>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QTextLayout>
+#include <QTextOption>
+
+#include <list>
+#include <memory>
+
+/**
+ * Cache of shaped and laid out lines, shared between all views of a document.
+ *
+ * Shaping is the expensive part of the layouting, it is redone for each
+ * relayout of a line, e.g. after font or view size changes or if a view
+ * scrolls back to lines it has already shown. As the result only depends on
+ * the key below, views of the same document can share the layouts.
+ *
+ * The cached layouts are shared by the KateLineLayout instances using them,
+ * they must not be modified.
+ */
+class KateShapedLayoutCache
+{
+public:
+    /**
+     * Everything that has an influence on the layout of a line.
+     */
+    struct Key {
+        QString text;
+        QFont font;
+        QList<QTextLayout::FormatRange> formats;
+        qreal tabStopDistance = 0;
+        QTextOption::WrapMode wrapMode = QTextOption::NoWrap;
+        Qt::Alignment alignment;
+        Qt::LayoutDirection textDirection = Qt::LeftToRight;
+        QTextOption::Flags flags;
+        int maxWidth = -1;
+        int firstLineOffset = 0;
+        int alignIndent = 0;
+        int lineHeight = 0;
+        float fontAscent = 0;
+
+        bool operator==(const Key &other) const;
+    };
+
+    /**
+     * Maximal number of cached layouts, least recently used ones are dropped first.
+     */
+    static constexpr int MaximalSize = 2048;
+
+    /**
+     * Lookup a layout.
+     * @param key layout parameters
+     * @param shiftX will be set to the indentation of the wrapped lines of the found layout
+     * @return shared layout or nullptr if not cached
+     */
+    std::shared_ptr<const QTextLayout> find(const Key &key, int &shiftX);
+
+    /**
+     * Remember a layout, it must not be changed afterwards.
+     * @param key layout parameters
+     * @param layout laid out line
+     * @param shiftX indentation of the wrapped lines
+     */
+    void insert(Key &&key, std::shared_ptr<const QTextLayout> layout, int shiftX);
+
+    /**
+     * Drop all cached layouts.
+     */
+    void clear();
+
+    /**
+     * @return number of cached layouts
+     */
+    int size() const
+    {
+        return int(m_entries.size());
+    }
+
+private:
+    struct Entry {
+        size_t hash;
+        Key key;
+        std::shared_ptr<const QTextLayout> layout;
+        int shiftX;
+    };
+
+    static size_t hashKey(const Key &key);
+
+    // most recently used first
+    std::list<Entry> m_entries;
+    QHash<size_t, std::list<Entry>::iterator> m_index;
+};
+
+#endif
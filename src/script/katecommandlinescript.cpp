@@ -45,7 +45,7 @@ bool KateCommandLineScript::callFunction(const QString &cmd, const QStringList &
         arguments << QJSValue(arg);
     }
 
-    QJSValue result = command.call(arguments);
+    QJSValue result = invoke(command, arguments);
     // error during the calling?
     if (result.isError()) {
         errorMessage = backtrace(result, i18n("Error calling %1", cmd));
@@ -111,7 +111,7 @@ bool KateCommandLineScript::help(KTextEditor::View *view, const QString &cmd, QS
     QJSValueList arguments;
     arguments << QJSValue(cmd);
 
-    QJSValue result = helpFunction.call(arguments);
+    QJSValue result = invoke(helpFunction, arguments);
 
     // error during the calling?
     if (result.isError()) {
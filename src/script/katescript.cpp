@@ -18,10 +18,12 @@
 #include <KLocalizedString>
 #include <iostream>
 
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileInfo>
 #include <QJSEngine>
 #include <QQmlEngine>
+#include <QScopeGuard>
 
 KateScript::KateScript(const QString &urlOrScript, enum InputType inputType)
     : m_url(inputType == InputURL ? urlOrScript : QString())
@@ -97,6 +99,13 @@ bool KateScript::load()
     m_loaded = true;
     m_loadSuccessful = false; // here set to false, and at end of function to true
 
+    QElapsedTimer timer;
+    timer.start();
+    const auto recordLoadTime = qScopeGuard([this, &timer]() {
+        m_loadTime = timer.nsecsElapsed();
+        qCDebug(LOG_KTE) << "loading script" << m_url << "took" << m_loadTime / 1000 << "us";
+    });
+
     // read the script file into memory
     QString source;
     if (m_inputType == InputURL) {
@@ -208,6 +217,20 @@ QJSValue KateScript::evaluate(const QString &program, const FieldMap &env)
     return result;
 }
 
+QJSValue KateScript::invoke(const QJSValue &function, const QJSValueList &arguments)
+{
+    if (m_firstCallTime >= 0) {
+        return function.call(arguments);
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    QJSValue result = function.call(arguments);
+    m_firstCallTime = timer.nsecsElapsed();
+    qCDebug(LOG_KTE) << "first call into script" << m_url << "took" << m_firstCallTime / 1000 << "us";
+    return result;
+}
+
 bool KateScript::hasException(const QJSValue &object, const QString &file)
 {
     if (object.isError()) {
@@ -169,6 +169,24 @@ public:
     /** Clears any uncaught exceptions in the script engine. */
     void clearExceptions();
 
+    /**
+     * Time in nanoseconds it took to load the script, including the
+     * engine setup and the required libraries, -1 if not loaded yet.
+     */
+    qint64 loadTime() const
+    {
+        return m_loadTime;
+    }
+
+    /**
+     * Time in nanoseconds the first call of a function of the script
+     * took, -1 if none was called yet.
+     */
+    qint64 firstCallTime() const
+    {
+        return m_firstCallTime;
+    }
+
     /** set the general header after construction of the script */
     void setGeneralHeader(const KateScriptHeader &generalHeader);
     /** Return the general header */
@@ -178,6 +196,9 @@ protected:
     /** Checks for exception and gives feedback on the console. */
     bool hasException(const QJSValue &object, const QString &file);
 
+    /** Call a function of the script, the first call is timed. */
+    QJSValue invoke(const QJSValue &function, const QJSValueList &arguments);
+
 private:
     /** Whether or not there has been a call to load */
     bool m_loaded = false;
@@ -191,6 +212,10 @@ private:
     /** An error message set when an error occurs */
     QString m_errorMessage;
 
+    /** Timings of load() and of the first function call, -1 until known */
+    qint64 m_loadTime = -1;
+    qint64 m_firstCallTime = -1;
+
 protected:
     /** The Qt interpreter for this script */
     QJSEngine *m_engine = nullptr;
@@ -15,6 +15,7 @@
 #include <iostream>
 
 #include <QFile>
+#include <QHash>
 #include <QJSEngine>
 #include <QStandardPaths>
 
@@ -44,38 +45,69 @@ bool readFile(const QString &sourceUrl, QString &sourceCode)
 
 } // namespace Script
 
-QString ScriptHelper::read(const QString &name)
+/**
+ * A located and read script file, empty name if it doesn't exist.
+ */
+struct ScriptFile {
+    QString fullName;
+    QString code;
+};
+
+/**
+ * All script engines ask for the same files, e.g. range.js is required
+ * by every script, locate and read each file only once.
+ * The strings are implicitly shared, the engines use the same copy.
+ */
+static QHash<QString, ScriptFile> &scriptFileCache()
 {
+    static QHash<QString, ScriptFile> cache;
+    return cache;
+}
+
+static ScriptFile scriptFile(QLatin1String directory, const QString &name)
+{
+    QHash<QString, ScriptFile> &cache = scriptFileCache();
+    const QString key = directory + name;
+    auto it = cache.constFind(key);
+    if (it != cache.cend()) {
+        return *it;
+    }
+
     // get full name of file
     // skip on errors
-    QString content;
-    QString fullName = QStandardPaths::locate(QStandardPaths::GenericDataLocation, QLatin1String("katepart5/script/files/") + name);
-    if (fullName.isEmpty()) {
+    ScriptFile file;
+    file.fullName = QStandardPaths::locate(QStandardPaths::GenericDataLocation, QLatin1String("katepart5/script/") + key);
+    if (file.fullName.isEmpty()) {
         // retry with resource
-        fullName = QLatin1String(":/ktexteditor/script/files/") + name;
-        if (!QFile::exists(fullName)) {
-            return content;
-        }
+        file.fullName = QLatin1String(":/ktexteditor/script/") + key;
     }
 
     // try to read complete file
     // skip non-existing files
-    Script::readFile(fullName, content);
-    return content;
+    if (!QFile::exists(file.fullName) || !Script::readFile(file.fullName, file.code)) {
+        file = ScriptFile();
+    }
+    return *cache.insert(key, file);
+}
+
+void ScriptHelper::clearFileCache()
+{
+    scriptFileCache().clear();
+}
+
+QString ScriptHelper::read(const QString &name)
+{
+    return scriptFile(QLatin1String("files/"), name).code;
 }
 
 void ScriptHelper::require(const QString &name)
 {
-    // get full name of file
-    // skip on errors
-    QString fullName = QStandardPaths::locate(QStandardPaths::GenericDataLocation, QLatin1String("katepart5/script/libraries/") + name);
-    if (fullName.isEmpty()) {
-        // retry with resource
-        fullName = QLatin1String(":/ktexteditor/script/libraries/") + name;
-        if (!QFile::exists(fullName)) {
-            return;
-        }
+    // copy, evaluating the file might require further ones
+    const ScriptFile file = scriptFile(QLatin1String("libraries/"), name);
+    if (file.fullName.isEmpty()) {
+        return;
     }
+    const QString &fullName = file.fullName;
 
     // check include guard
     QJSValue require_guard = m_engine->globalObject().property(QStringLiteral("require_guard"));
@@ -83,15 +115,8 @@ void ScriptHelper::require(const QString &name)
         return;
     }
 
-    // try to read complete file
-    // skip non-existing files
-    QString code;
-    if (!Script::readFile(fullName, code)) {
-        return;
-    }
-
     // eval in current script engine
-    const QJSValue val = m_engine->evaluate(code, fullName);
+    const QJSValue val = m_engine->evaluate(file.code, fullName);
     if (val.isError()) {
         qCWarning(LOG_KTE) << "error evaluating" << fullName << val.toString() << ", at line" << val.property(QStringLiteral("lineNumber")).toInt();
     }
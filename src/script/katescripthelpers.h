@@ -40,6 +40,12 @@ public:
     Q_INVOKABLE QString _i18nc(const QString &textContext, const QString &text);
     Q_INVOKABLE QString _i18np(const QString &trSingular, const QString &trPlural, int number);
     Q_INVOKABLE QString _i18ncp(const QString &trContext, const QString &trSingular, const QString &trPlural, int number = 0);
+
+    /**
+     * Forget the located and read files of read() and require(),
+     * needed if the script files on disk might have changed.
+     */
+    static void clearFileCache();
 };
 
 } // namespace Kate
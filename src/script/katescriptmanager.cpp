@@ -31,6 +31,7 @@
 #include "katecommandlinescript.h"
 #include "kateglobal.h"
 #include "kateindentscript.h"
+#include "katescripthelpers.h"
 #include "katepartdebug.h"
 
 KateScriptManager *KateScriptManager::m_instance = nullptr;
@@ -276,6 +277,7 @@ void KateScriptManager::collect()
 
 void KateScriptManager::reload()
 {
+    Kate::ScriptHelper::clearFileCache();
     collect();
     Q_EMIT reloaded();
 }
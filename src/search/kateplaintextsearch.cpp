@@ -8,13 +8,152 @@
 // BEGIN includes
 #include "kateplaintextsearch.h"
 
+#include "katebuffer.h"
+#include "katedocument.h"
 #include "katepartdebug.h"
 #include "kateregexpsearch.h"
 #include <ktexteditor/document.h>
 
 #include <QRegularExpression>
+
+#include <algorithm>
 // END  includes
 
+// BEGIN KatePlainTextMatcher
+
+// below that length case sensitive needles are searched with QStringView::indexOf()
+static constexpr qsizetype MinSkipTableLength = 4;
+
+KatePlainTextMatcher::KatePlainTextMatcher(const QString &needle, Qt::CaseSensitivity caseSensitivity, bool wholeWords)
+    : m_needle(needle)
+    , m_key(caseSensitivity == Qt::CaseInsensitive ? needle.toCaseFolded() : needle)
+    , m_caseSensitivity(caseSensitivity)
+    , m_wholeWords(wholeWords)
+{
+    // case folding of surrogate pairs can't be done per QChar, let Qt handle these
+    const bool hasSurrogates = std::any_of(needle.begin(), needle.end(), [](QChar c) {
+        return c.isSurrogate();
+    });
+
+    const qsizetype n = m_key.size();
+    m_useQtSearch = n < 2 || (caseSensitivity == Qt::CaseSensitive && n < MinSkipTableLength) || (caseSensitivity == Qt::CaseInsensitive && hasSurrogates)
+        || m_key.size() != m_needle.size();
+    if (m_useQtSearch) {
+        return;
+    }
+
+    // forward: shift by the distance of the last occurrence of the character in front of the needle's last character
+    m_forwardShift.fill(n);
+    for (qsizetype i = 0; i < n - 1; ++i) {
+        m_forwardShift[m_key[i].unicode() & 0xff] = n - 1 - i;
+    }
+
+    // backward: shift by the distance of the first occurrence of the character behind the needle's first character
+    m_backwardShift.fill(n);
+    for (qsizetype i = n - 1; i > 0; --i) {
+        m_backwardShift[m_key[i].unicode() & 0xff] = i;
+    }
+}
+
+qsizetype KatePlainTextMatcher::indexIn(QStringView haystack, qsizetype from, qsizetype to) const
+{
+    const qsizetype n = m_key.size();
+    from = std::max<qsizetype>(from, 0);
+    to = std::min(to, haystack.size());
+    if (n == 0 || from + n > to) {
+        return -1;
+    }
+
+    if (m_useQtSearch) {
+        const QStringView text = haystack.first(to);
+        for (qsizetype pos = text.indexOf(m_needle, from, m_caseSensitivity); pos >= 0; pos = text.indexOf(m_needle, pos + 1, m_caseSensitivity)) {
+            if (!m_wholeWords || (isWordBoundary(haystack, pos) && isWordBoundary(haystack, pos + n))) {
+                return pos;
+            }
+        }
+        return -1;
+    }
+
+    for (qsizetype pos = from; pos + n <= to; pos += m_forwardShift[fold(haystack[pos + n - 1]) & 0xff]) {
+        if (matchesAt(haystack, pos)) {
+            return pos;
+        }
+    }
+    return -1;
+}
+
+qsizetype KatePlainTextMatcher::lastIndexIn(QStringView haystack, qsizetype from, qsizetype to) const
+{
+    const qsizetype n = m_key.size();
+    from = std::max<qsizetype>(from, 0);
+    to = std::min(to, haystack.size());
+    if (n == 0 || from + n > to) {
+        return -1;
+    }
+
+    if (m_useQtSearch) {
+        const QStringView text = haystack.first(to);
+        for (qsizetype pos = text.lastIndexOf(m_needle, to - n, m_caseSensitivity); pos >= from;
+             pos = (pos > 0) ? text.lastIndexOf(m_needle, pos - 1, m_caseSensitivity) : -1) {
+            if (!m_wholeWords || (isWordBoundary(haystack, pos) && isWordBoundary(haystack, pos + n))) {
+                return pos;
+            }
+        }
+        return -1;
+    }
+
+    for (qsizetype pos = to - n; pos >= from; pos -= m_backwardShift[fold(haystack[pos]) & 0xff]) {
+        if (matchesAt(haystack, pos)) {
+            return pos;
+        }
+    }
+    return -1;
+}
+
+bool KatePlainTextMatcher::matchesAt(QStringView haystack, qsizetype position) const
+{
+    const qsizetype n = m_key.size();
+    for (qsizetype i = n - 1; i >= 0; --i) {
+        if (fold(haystack[position + i]) != m_key[i].unicode()) {
+            return false;
+        }
+    }
+    return !m_wholeWords || (isWordBoundary(haystack, position) && isWordBoundary(haystack, position + n));
+}
+
+/**
+ * Same word characters as \w of QRegularExpression with Unicode properties.
+ */
+static bool isWordCharacter(char32_t c)
+{
+    return c == U'_' || QChar::isLetterOrNumber(c);
+}
+
+bool KatePlainTextMatcher::isWordBoundary(QStringView haystack, qsizetype position)
+{
+    bool wordBefore = false;
+    if (position > 0) {
+        char32_t c = haystack[position - 1].unicode();
+        if (QChar::isLowSurrogate(c) && position > 1 && haystack[position - 2].isHighSurrogate()) {
+            c = QChar::surrogateToUcs4(haystack[position - 2], haystack[position - 1]);
+        }
+        wordBefore = isWordCharacter(c);
+    }
+
+    bool wordAfter = false;
+    if (position < haystack.size()) {
+        char32_t c = haystack[position].unicode();
+        if (QChar::isHighSurrogate(c) && position + 1 < haystack.size() && haystack[position + 1].isLowSurrogate()) {
+            c = QChar::surrogateToUcs4(haystack[position], haystack[position + 1]);
+        }
+        wordAfter = isWordCharacter(c);
+    }
+
+    return wordBefore != wordAfter;
+}
+
+// END
+
 // BEGIN d'tor, c'tor
 //
 // KateSearch Constructor
@@ -24,14 +163,27 @@ KatePlainTextSearch::KatePlainTextSearch(const KTextEditor::Document *document,
     , m_caseSensitivity(caseSensitivity)
     , m_wholeWords(wholeWords)
 {
+    // our own documents allow to read the lines without copies
+    if (const auto doc = qobject_cast<const KTextEditor::DocumentPrivate *>(document)) {
+        m_buffer = &doc->buffer();
+    }
 }
 
 // END
 
+QStringView KatePlainTextSearch::lineText(int line, QString &storage) const
+{
+    if (m_buffer) {
+        return m_buffer->lineText(line);
+    }
+    storage = m_document->line(line);
+    return storage;
+}
+
 KTextEditor::Range KatePlainTextSearch::search(const QString &text, KTextEditor::Range inputRange, bool backwards)
 {
-    // abuse regex for whole word plaintext search
-    if (m_wholeWords) {
+    // abuse regex for whole word plaintext search spanning lines
+    if (m_wholeWords && text.contains(QLatin1Char('\n'))) {
         // escape dot and friends
         const QString workPattern = QStringLiteral("\\b%1\\b").arg(QRegularExpression::escape(text));
 
@@ -61,7 +213,8 @@ KTextEditor::Range KatePlainTextSearch::search(const QString &text, KTextEditor:
             for (int k = 0; k < needleLines.count(); k++) {
                 // which lines to compare
                 const auto &needleLine = needleLines[k];
-                const QString &hayLine = m_document->line(j + k);
+                QString storage;
+                const QStringView hayLine = lineText(j + k, storage);
 
                 // position specific comparison (first, middle, last)
                 if (k == 0) {
@@ -97,6 +250,12 @@ KTextEditor::Range KatePlainTextSearch::search(const QString &text, KTextEditor:
         return KTextEditor::Range::invalid();
     } else {
         // single-line plaintext search (both forward of backward mode)
+        // the needle is compiled once and reused as long as the same text is searched, e.g. for find all
+        static KatePlainTextMatcher matcher;
+        if (!matcher.isBuiltFor(text, m_caseSensitivity, m_wholeWords)) {
+            matcher = KatePlainTextMatcher(text, m_caseSensitivity, m_wholeWords);
+        }
+
         const int startCol = inputRange.start().column();
         const int endCol = inputRange.end().column(); // first not included
         const int startLine = inputRange.start().line();
@@ -109,14 +268,14 @@ KTextEditor::Range KatePlainTextSearch::search(const QString &text, KTextEditor:
                 return KTextEditor::Range::invalid();
             }
 
-            const QString textLine = m_document->line(line);
+            QString storage;
+            const QStringView textLine = lineText(line, storage);
 
             const int offset = (line == startLine) ? startCol : 0;
             const int line_end = (line == endLine) ? endCol : textLine.length();
-            const int foundAt =
-                backwards ? textLine.lastIndexOf(text, line_end - text.length(), m_caseSensitivity) : textLine.indexOf(text, offset, m_caseSensitivity);
+            const int foundAt = backwards ? matcher.lastIndexIn(textLine, offset, line_end) : matcher.indexIn(textLine, offset, line_end);
 
-            if ((offset <= foundAt) && (foundAt + text.length() <= line_end)) {
+            if (foundAt >= 0) {
                 return KTextEditor::Range(line, foundAt, line, foundAt + text.length());
             }
         }
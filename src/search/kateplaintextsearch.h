@@ -9,16 +9,105 @@
 #define _KATE_PLAINTEXTSEARCH_H_
 
 #include <QObject>
+#include <QStringView>
 
 #include <ktexteditor/range.h>
 
 #include <ktexteditor_export.h>
 
+#include <array>
+
 namespace KTextEditor
 {
 class Document;
 }
 
+namespace Kate
+{
+class TextBuffer;
+}
+
+/**
+ * Precompiled needle for plain text search inside of single lines.
+ * Build it once per searched text and use it for many lines.
+ *
+ * Uses Boyer-Moore-Horspool skip tables, indexed by the low byte of the
+ * (case folded) characters. Short case sensitive needles use the vectorized
+ * QStringView::indexOf() instead. Case insensitive and whole word matching
+ * are done natively, whole words follow the rules of \b in regular expressions.
+ *
+ * Holds no reference to a document, it can be used in any thread.
+ */
+class KTEXTEDITOR_EXPORT KatePlainTextMatcher
+{
+public:
+    /**
+     * Constructs a matcher that matches nothing.
+     */
+    KatePlainTextMatcher() = default;
+
+    /**
+     * Constructs a matcher for the given needle.
+     * \param needle text to search for, must not contain line breaks
+     * \param caseSensitivity case sensitivity of the search
+     * \param wholeWords only match whole words
+     */
+    KatePlainTextMatcher(const QString &needle, Qt::CaseSensitivity caseSensitivity, bool wholeWords);
+
+    /**
+     * Was this matcher built for the given parameters?
+     */
+    bool isBuiltFor(const QString &needle, Qt::CaseSensitivity caseSensitivity, bool wholeWords) const
+    {
+        return m_needle == needle && m_caseSensitivity == caseSensitivity && m_wholeWords == wholeWords;
+    }
+
+    /**
+     * Length of the needle, the length of all matches.
+     */
+    qsizetype length() const
+    {
+        return m_needle.size();
+    }
+
+    /**
+     * Find the first match in \p haystack that starts at or after \p from and ends at or before \p to.
+     * \return start of the match or -1 if there is none
+     */
+    qsizetype indexIn(QStringView haystack, qsizetype from, qsizetype to) const;
+
+    /**
+     * Find the last match in \p haystack that starts at or after \p from and ends at or before \p to.
+     * \return start of the match or -1 if there is none
+     */
+    qsizetype lastIndexIn(QStringView haystack, qsizetype from, qsizetype to) const;
+
+private:
+    KTEXTEDITOR_NO_EXPORT
+    char16_t fold(QChar c) const
+    {
+        return m_caseSensitivity == Qt::CaseSensitive ? c.unicode() : c.toCaseFolded().unicode();
+    }
+
+    KTEXTEDITOR_NO_EXPORT
+    bool matchesAt(QStringView haystack, qsizetype position) const;
+
+    KTEXTEDITOR_NO_EXPORT
+    static bool isWordBoundary(QStringView haystack, qsizetype position);
+
+private:
+    QString m_needle;
+    // needle to compare with, case folded for case insensitive search
+    QString m_key;
+    Qt::CaseSensitivity m_caseSensitivity = Qt::CaseSensitive;
+    bool m_wholeWords = false;
+    // use QStringView::indexOf() instead of the skip tables
+    bool m_useQtSearch = true;
+    // shifts for forward and backward search, indexed by the low byte of a character
+    std::array<int, 256> m_forwardShift = {};
+    std::array<int, 256> m_backwardShift = {};
+};
+
 /**
  * Object to help to search for plain text.
  * This should be NO QObject, it is created too often!
@@ -45,8 +134,18 @@ public:
      */
     KTextEditor::Range search(const QString &text, KTextEditor::Range inputRange, bool backwards = false);
 
+private:
+    /**
+     * Text of the given line, by reference if possible.
+     * \param storage keeps a copy of the line alive if it can't be referenced
+     */
+    KTEXTEDITOR_NO_EXPORT
+    QStringView lineText(int line, QString &storage) const;
+
 private:
     const KTextEditor::Document *m_document;
+    // buffer of the document for reading lines by reference, if it is a KTextEditor::DocumentPrivate
+    const Kate::TextBuffer *m_buffer = nullptr;
     Qt::CaseSensitivity m_caseSensitivity;
     bool m_wholeWords;
 };
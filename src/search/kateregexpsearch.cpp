@@ -8,7 +8,9 @@
 // BEGIN includes
 #include "kateregexpsearch.h"
 
-#include <ktexteditor/document.h>
+#include "katedocument.h"
+
+#include <algorithm>
 // END  includes
 
 // Turn debug messages on/off here
@@ -151,17 +153,42 @@ KateRegExpSearch::KateRegExpSearch(const KTextEditor::Document *document)
 {
 }
 
-// helper structs for captures re-construction
-struct TwoViewCursor {
-    int index;
-    int line;
-    int col;
-};
+namespace
+{
+// number of lines of the first window a multi-line search feeds to the regular expression
+constexpr int MultiLineWindowLines = 256;
 
-struct IndexPair {
-    int openIndex;
-    int closeIndex;
-};
+// number of lines in front of the searched lines that are part of the subject, e.g. for lookbehinds
+constexpr int MultiLineWindowContextLines = MultiLineWindowLines;
+
+// the window is assembled again instead of extended, if that many lines in front of the search are unused
+constexpr int MultiLineWindowMaxUnusedLines = 4 * MultiLineWindowLines;
+}
+
+void KateRegExpSearchWindow::ensure(const KTextEditor::Document *document, int first, int last)
+{
+    const bool reusable =
+        m_revision == document->revision() && m_firstLine <= first && first <= lastLine() + 1 && first - m_firstLine <= MultiLineWindowMaxUnusedLines;
+    if (!reusable) {
+        m_revision = document->revision();
+        m_firstLine = first;
+        m_lineOffsets.assign(1, 0);
+        m_text.clear();
+    }
+
+    for (int line = lastLine() + 1; line <= last; ++line) {
+        m_text += document->line(line);
+        m_text += QLatin1Char('\n');
+        m_lineOffsets.push_back(m_text.size());
+    }
+}
+
+KTextEditor::Cursor KateRegExpSearchWindow::cursor(qsizetype offset) const
+{
+    const auto it = std::upper_bound(m_lineOffsets.begin(), m_lineOffsets.end(), offset);
+    const int index = int(it - m_lineOffsets.begin()) - 1;
+    return KTextEditor::Cursor(m_firstLine + index, int(offset - m_lineOffsets[index]));
+}
 
 QList<KTextEditor::Range>
 KateRegExpSearch::search(const QString &pattern, KTextEditor::Range inputRange, bool backwards, QRegularExpression::PatternOptions options)
@@ -218,192 +245,92 @@ KateRegExpSearch::search(const QString &pattern, KTextEditor::Range inputRange,
         return noResult;
     }
 
-    const int rangeStartLine = inputRange.start().line();
-    const int rangeStartCol = inputRange.start().column();
-
-    const int rangeEndLine = inputRange.end().line();
-    const int rangeEndCol = inputRange.end().column();
-
     if (stillMultiLine) {
-        const int rangeLineCount = rangeEndLine - rangeStartLine + 1;
+        const int rangeStartLine = inputRange.start().line();
+        const int rangeEndLine = inputRange.end().line();
+
         FAST_DEBUG("regular expression search (lines " << rangeStartLine << ".." << rangeEndLine << ")");
 
-        const int docLineCount = m_document->lines();
         // nothing to do...
-        if (rangeStartLine >= docLineCount) {
+        if (rangeStartLine < 0 || m_document->lines() <= rangeEndLine) {
             return noResult;
         }
 
-        QList<int> lineLens(rangeLineCount);
-        int maxMatchOffset = 0;
-
-        // all lines in the input range
-        QString wholeRange;
-        for (int i = 0; i < rangeLineCount; ++i) {
-            const int docLineIndex = rangeStartLine + i;
-            if (docLineIndex < 0 || docLineCount <= docLineIndex) { // invalid index
-                return noResult;
-            }
-
-            const QString textLine = m_document->line(docLineIndex);
-            lineLens[i] = textLine.length();
-            wholeRange.append(textLine);
-
-            // This check is needed as some parts in vimode rely on this behaviour.
-            // We add an '\n' as a delimiter between lines in the range; but never after the
-            // last line as that would add an '\n' that isn't there in the original text,
-            // and can skew search results or hit an assert when accessing lineLens later
-            // in the code.
-            if (i != (rangeLineCount - 1)) {
-                wholeRange.append(QLatin1Char('\n'));
-            }
-
-            // lineLens.at(i) + 1, because '\n' was added
-            maxMatchOffset += (i == rangeEndLine) ? rangeEndCol : lineLens.at(i) + 1;
-
-            FAST_DEBUG("  line" << i << "has length" << lineLens.at(i));
-        }
-
-        FAST_DEBUG("Max. match offset" << maxMatchOffset);
-
-        QRegularExpressionMatch match;
-        bool found = false;
-        QRegularExpressionMatchIterator iter = repairedRegex.globalMatch(wholeRange, rangeStartCol);
-
-        if (backwards) {
-            while (iter.hasNext()) {
-                QRegularExpressionMatch curMatch = iter.next();
-                if (curMatch.capturedEnd() <= maxMatchOffset) {
-                    match.swap(curMatch);
-                    found = true;
+        // the lines are fed to the regular expression in windows, kept by the document across searches
+        const auto doc = qobject_cast<const KTextEditor::DocumentPrivate *>(m_document);
+        KateRegExpSearchWindow localWindow;
+        KateRegExpSearchWindow &window = doc ? doc->regExpSearchWindow() : localWindow;
+
+        const KTextEditor::Cursor rangeEnd = inputRange.end();
+        KTextEditor::Cursor searchFrom = inputRange.start();
+        int windowLines = MultiLineWindowLines;
+        QList<KTextEditor::Range> result = noResult;
+
+        while (true) {
+            // the subject starts at the range or some context lines in front of the searched lines, whatever is later,
+            // a search without matches doesn't assemble the whole range, the window slides along
+            // the search never starts at the subject start behind the range start, \A only matches there
+            // windows in front of the range end include the '\n' of their last line
+            const int windowEnd = std::min(rangeEndLine, searchFrom.line() + windowLines - 1);
+            const bool lastWindow = windowEnd == rangeEndLine;
+            const int subjectStartLine = std::max(rangeStartLine, searchFrom.line() - MultiLineWindowContextLines);
+            window.ensure(m_document, subjectStartLine, windowEnd);
+            const qsizetype subjectStart = window.lineStart(subjectStartLine);
+            const qsizetype subjectEnd = lastWindow ? window.lineEnd(windowEnd) : window.lineStart(windowEnd + 1);
+            const QStringView subject = QStringView(window.text()).sliced(subjectStart, subjectEnd - subjectStart);
+
+            // a match that could continue behind the window is only partial, retry with a larger window
+            const QRegularExpressionMatch match =
+                repairedRegex.matchView(subject,
+                                        window.offset(searchFrom) - subjectStart,
+                                        lastWindow ? QRegularExpression::NormalMatch : QRegularExpression::PartialPreferFirstMatch);
+            // no complete match starts in front of the partial one, the next window may start there
+            // only if it starts right at the search position, the window is too small for it
+            if (match.hasPartialMatch()) {
+                const KTextEditor::Cursor partialStart = window.cursor(subjectStart + match.capturedStart());
+                if (searchFrom < partialStart) {
+                    searchFrom = partialStart;
+                } else {
+                    windowLines *= 2;
+                    FAST_DEBUG("partial match, window grows to" << windowLines << "lines");
                 }
+                continue;
             }
-        } else { /* forwards */
-            QRegularExpressionMatch curMatch;
-            if (iter.hasNext()) {
-                curMatch = iter.next();
-            }
-            if (curMatch.capturedEnd() <= maxMatchOffset) {
-                match.swap(curMatch);
-                found = true;
-            }
-        }
 
-        if (!found) {
-            // no match
-            FAST_DEBUG("not found");
-            return noResult;
-        }
-
-        // Capture groups: save opening and closing indices and build a map,
-        // the correct values will be written into it later
-        QMap<int, TwoViewCursor *> indicesToCursors;
-        const int numCaptures = repairedRegex.captureCount();
-        QList<IndexPair> indexPairs(numCaptures + 1);
-        for (int c = 0; c <= numCaptures; ++c) {
-            const int openIndex = match.capturedStart(c);
-            IndexPair &pair = indexPairs[c];
-            if (openIndex == -1) {
-                // An invalid index indicates an empty capture group
-                pair.openIndex = -1;
-                pair.closeIndex = -1;
-                FAST_DEBUG("capture []");
-            } else {
-                const int closeIndex = match.capturedEnd(c);
-                pair.openIndex = openIndex;
-                pair.closeIndex = closeIndex;
-                FAST_DEBUG("capture [" << pair.openIndex << ".." << pair.closeIndex << "]");
-
-                // each key no more than once
-                if (!indicesToCursors.contains(openIndex)) {
-                    TwoViewCursor *twoViewCursor = new TwoViewCursor;
-                    twoViewCursor->index = openIndex;
-                    indicesToCursors.insert(openIndex, twoViewCursor);
-                    FAST_DEBUG("  capture group start index added: " << openIndex);
-                }
-                if (!indicesToCursors.contains(closeIndex)) {
-                    TwoViewCursor *twoViewCursor = new TwoViewCursor;
-                    twoViewCursor->index = closeIndex;
-                    indicesToCursors.insert(closeIndex, twoViewCursor);
-                    FAST_DEBUG("  capture group end index added: " << closeIndex);
+            if (!match.hasMatch()) {
+                if (lastWindow) {
+                    break;
                 }
+                searchFrom = KTextEditor::Cursor(windowEnd + 1, 0);
+                continue;
             }
-        }
 
-        // find out where they belong
-        int curRelLine = 0;
-        int curRelCol = 0;
-        int curRelIndex = 0;
-
-        for (TwoViewCursor *twoViewCursor : std::as_const(indicesToCursors)) {
-            // forward to index, save line/col
-            const int index = twoViewCursor->index;
-            FAST_DEBUG("resolving position" << index);
-
-            while (curRelIndex <= index) {
-                FAST_DEBUG("walk pos (" << curRelLine << "," << curRelCol << ") = " << curRelIndex << "relative, steps more to go" << index - curRelIndex);
-
-                const int curRelLineLen = lineLens.at(curRelLine);
-                const int curLineRemainder = curRelLineLen - curRelCol;
-                const int lineFeedIndex = curRelIndex + curLineRemainder;
-                if (index <= lineFeedIndex) {
-                    if (index == lineFeedIndex) {
-                        // on this line _at_ line feed
-                        FAST_DEBUG("  on line feed");
-                        const int absLine = curRelLine + rangeStartLine;
-                        twoViewCursor->line = absLine;
-                        twoViewCursor->col = curRelLineLen;
-
-                        // advance to next line
-                        const int advance = (index - curRelIndex) + 1;
-                        ++curRelLine;
-                        curRelCol = 0;
-                        curRelIndex += advance;
-                    } else { // index < lineFeedIndex
-                        // on this line _before_ line feed
-                        FAST_DEBUG("  before line feed");
-                        const int diff = (index - curRelIndex);
-                        const int absLine = curRelLine + rangeStartLine;
-                        const int absCol = curRelCol + diff;
-                        twoViewCursor->line = absLine;
-                        twoViewCursor->col = absCol;
-
-                        // advance on same line
-                        const int advance = diff + 1;
-                        curRelCol += advance;
-                        curRelIndex += advance;
+            // matches that are out of the inputRange are rejected
+            // the offsets are mapped back right away, the window may be rebuilt for the next match
+            if (window.cursor(subjectStart + match.capturedEnd()) <= rangeEnd) {
+                const int numCaptures = repairedRegex.captureCount();
+                result = QList<KTextEditor::Range>(numCaptures + 1, KTextEditor::Range::invalid());
+                for (int c = 0; c <= numCaptures; ++c) {
+                    // an invalid index indicates an empty capture group
+                    if (match.capturedStart(c) != -1) {
+                        result[c] = KTextEditor::Range(window.cursor(subjectStart + match.capturedStart(c)), window.cursor(subjectStart + match.capturedEnd(c)));
+                        FAST_DEBUG("result range " << c << ": " << result[c]);
                     }
-                    FAST_DEBUG("position(" << twoViewCursor->line << "," << twoViewCursor->col << ")");
-                } else { // if (index > lineFeedIndex)
-                    // not on this line
-                    // advance to next line
-                    FAST_DEBUG("  not on this line");
-                    ++curRelLine;
-                    curRelCol = 0;
-                    const int advance = curLineRemainder + 1;
-                    curRelIndex += advance;
                 }
             }
-        }
 
-        // build result array
-        QList<KTextEditor::Range> result(numCaptures + 1, KTextEditor::Range::invalid());
-        for (int y = 0; y <= numCaptures; y++) {
-            IndexPair &pair = indexPairs[y];
-            if (!(pair.openIndex == -1 || pair.closeIndex == -1)) {
-                const TwoViewCursor *const openCursors = indicesToCursors.value(pair.openIndex);
-                const TwoViewCursor *const closeCursors = indicesToCursors.value(pair.closeIndex);
-                const int startLine = openCursors->line;
-                const int startCol = openCursors->col;
-                const int endLine = closeCursors->line;
-                const int endCol = closeCursors->col;
-                FAST_DEBUG("range " << y << ": (" << startLine << ", " << startCol << ")..(" << endLine << ", " << endCol << ")");
-                result[y] = KTextEditor::Range(startLine, startCol, endLine, endCol);
+            // forwards the first match is the result, backwards the last one
+            if (!backwards) {
+                break;
             }
-        }
 
-        // free structs allocated for indicesToCursors
-        qDeleteAll(indicesToCursors);
+            // continue behind the match, zero-length matches must not match at the same position again
+            const qsizetype next = match.capturedEnd() + (match.capturedLength() == 0 ? 1 : 0);
+            if (next > subject.size()) {
+                break;
+            }
+            searchFrom = window.cursor(subjectStart + next);
+        }
 
         return result;
     } else {
@@ -742,6 +669,26 @@ KateRegExpSearch::search(const QString &pattern, KTextEditor::Range inputRange,
     return out.str();
 }
 
+/*static*/ std::optional<QRegularExpression> KateRegExpSearch::singleLineRegularExpression(const QString &pattern, QRegularExpression::PatternOptions options)
+{
+    // Always enable Unicode support, like search() does
+    options |= QRegularExpression::UseUnicodePropertiesOption;
+
+    // repairPattern() must only see valid patterns, see search()
+    if (pattern.isEmpty() || !QRegularExpression(pattern, options).isValid()) {
+        return std::nullopt;
+    }
+
+    bool stillMultiLine;
+    QRegularExpression regex(repairPattern(pattern, stillMultiLine), options);
+    if (stillMultiLine || !regex.isValid()) {
+        return std::nullopt;
+    }
+
+    regex.optimize();
+    return regex;
+}
+
 QString KateRegExpSearch::repairPattern(const QString &pattern, bool &stillMultiLine)
 {
     // '\s' can make a pattern multi-line, it's replaced here with '[ \t]';
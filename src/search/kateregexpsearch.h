@@ -15,6 +15,9 @@
 
 #include <ktexteditor_export.h>
 
+#include <optional>
+#include <vector>
+
 namespace KTextEditor
 {
 class Document;
@@ -81,6 +84,18 @@ public:
      */
     static QString buildReplacement(const QString &text, const QStringList &capturedTexts, int replacementCounter);
 
+    /**
+     * Returns the regular expression search() matches single lines with, if \p pattern
+     * can't match across line boundaries. The returned expression only depends on its
+     * input, so it can be used to match snapshots of lines outside of the GUI thread.
+     *
+     * \param pattern the regular expression search pattern
+     * \param options QRegularExpression pattern options, we will internally add QRegularExpression::UseUnicodePropertiesOption
+     * \return the compiled expression, or no value if the pattern is invalid or may span multiple lines
+     */
+    static std::optional<QRegularExpression> singleLineRegularExpression(const QString &pattern,
+                                                                         QRegularExpression::PatternOptions options = QRegularExpression::NoPatternOption);
+
 private:
     /**
      * Implementation of escapePlainText() and public buildReplacement().
@@ -116,4 +131,61 @@ private:
     class ReplacementStream;
 };
 
+/**
+ * Consecutive lines of a document, each followed by '\n', the subject for multi-line patterns.
+ * Owned by the document, successive searches in the same revision, e.g. by a find all,
+ * reuse and extend the assembled lines instead of copying the whole range each time.
+ * The window slides along the searched range, it only keeps a limited number of lines
+ * in front of the searched ones. The document drops it on each change.
+ * Offsets are mapped back to cursors with the prefix sums of the line lengths.
+ */
+class KateRegExpSearchWindow
+{
+public:
+    /**
+     * Ensure the lines [first, last] of the document are in the window.
+     */
+    void ensure(const KTextEditor::Document *document, int first, int last);
+
+    int firstLine() const
+    {
+        return m_firstLine;
+    }
+
+    const QString &text() const
+    {
+        return m_text;
+    }
+
+    qsizetype lineStart(int line) const
+    {
+        return m_lineOffsets[line - m_firstLine];
+    }
+
+    qsizetype lineEnd(int line) const
+    {
+        return m_lineOffsets[line - m_firstLine + 1] - 1;
+    }
+
+    qsizetype offset(KTextEditor::Cursor cursor) const
+    {
+        return lineStart(cursor.line()) + cursor.column();
+    }
+
+    KTextEditor::Cursor cursor(qsizetype offset) const;
+
+private:
+    int lastLine() const
+    {
+        return m_firstLine + int(m_lineOffsets.size()) - 2;
+    }
+
+private:
+    qint64 m_revision = -1;
+    int m_firstLine = 0;
+    // start offset of each line in m_text, plus the end of the text
+    std::vector<qsizetype> m_lineOffsets = {0};
+    QString m_text;
+};
+
 #endif
@@ -13,6 +13,8 @@
 #include "katedocument.h"
 #include "kateglobal.h"
 #include "katematch.h"
+#include "kateplaintextsearch.h"
+#include "kateregexpsearch.h"
 #include "kateundomanager.h"
 #include "kateview.h"
 
@@ -39,6 +41,8 @@
 #include <QStringListModel>
 #include <QVBoxLayout>
 
+#include <algorithm>
+#include <optional>
 #include <vector>
 
 // Turn debug messages on/off here
@@ -126,6 +130,100 @@ public:
     }
 };
 
+// we highlight all ranges of a find or replace all, up to some hard limit
+// e.g. if you replace 100000 things, rendering will break down otherwise ;=)
+constexpr uint MaxHighlightings = 65536;
+
+// find all in ranges with at least that many lines is done in parallel background jobs
+constexpr int ParallelFindAllMinLines = 50000;
+
+// number of lines one background job of a parallel find all searches
+constexpr int FindAllChunkSize = 8192;
+
+/**
+ * Matches a search pattern inside of single lines, no document access needed.
+ * Used by the background jobs of a parallel find all, the results are the
+ * same as the ones of KTextEditor::DocumentPrivate::searchText().
+ */
+class LineMatcher
+{
+public:
+    /**
+     * Create a matcher for the given pattern and options.
+     * @return matcher, or no value if the pattern may span lines or can't match at all
+     */
+    static std::optional<LineMatcher> create(const QString &pattern, SearchOptions options)
+    {
+        const bool caseInsensitive = options.testFlag(CaseInsensitive);
+        const QRegularExpression::PatternOptions patternOptions =
+            caseInsensitive ? QRegularExpression::CaseInsensitiveOption : QRegularExpression::NoPatternOption;
+
+        LineMatcher matcher;
+        if (options.testFlag(Regex)) {
+            const auto regex = KateRegExpSearch::singleLineRegularExpression(pattern, patternOptions);
+            if (!regex) {
+                return std::nullopt;
+            }
+            matcher.m_regex = *regex;
+            return matcher;
+        }
+
+        const QString text = options.testFlag(EscapeSequences) ? KateRegExpSearch::escapePlaintext(pattern) : pattern;
+        if (text.isEmpty() || text.contains(QLatin1Char('\n'))) {
+            return std::nullopt;
+        }
+
+        matcher.m_plainText = KatePlainTextMatcher(text, caseInsensitive ? Qt::CaseInsensitive : Qt::CaseSensitive, options.testFlag(WholeWords));
+        return matcher;
+    }
+
+    /**
+     * Append all matches in the columns [startColumn, endColumn] of the given line to @p matches.
+     * Continues after each match like KateSearchBar::findOrReplaceAll() does.
+     * @param lastLine line is the last one of the searched range, stop at matches reaching its end
+     */
+    void matchLine(const QString &text, int line, int startColumn, int endColumn, bool lastLine, std::vector<Range> &matches) const
+    {
+        int column = startColumn;
+        while (column <= endColumn) {
+            int start;
+            int end;
+            if (m_plainText.length() == 0) {
+                const QRegularExpressionMatch match = m_regex.match(text, column);
+                if (!match.hasMatch()) {
+                    return;
+                }
+                start = match.capturedStart();
+                end = match.capturedEnd();
+            } else {
+                start = m_plainText.indexIn(text, column, endColumn);
+                if (start < 0) {
+                    return;
+                }
+                end = start + m_plainText.length();
+            }
+
+            if (end > endColumn) {
+                return;
+            }
+            matches.emplace_back(line, start, line, end);
+
+            if (lastLine && end == endColumn) {
+                return;
+            }
+
+            // zero-length matches, e.g. ^, $, \b, must not match at the same position again
+            column = (start == end) ? end + 1 : end;
+        }
+    }
+
+private:
+    LineMatcher() = default;
+
+    QRegularExpression m_regex;
+    KatePlainTextMatcher m_plainText;
+};
+
 } // anon namespace
 
 KateSearchBar::KateSearchBar(bool initAsPower, KTextEditor::ViewPrivate *view, KateViewConfig *config)
@@ -148,6 +246,7 @@ KateSearchBar::KateSearchBar(bool initAsPower, KTextEditor::ViewPrivate *view, K
     , m_powerMode(0)
 {
     connect(view, &KTextEditor::View::cursorPositionChanged, this, &KateSearchBar::updateIncInitCursor);
+    connect(view, &KTextEditor::ViewPrivate::displayRangeChanged, this, &KateSearchBar::updateViewportHighlights);
     connect(view, &KTextEditor::View::selectionChanged, this, &KateSearchBar::updateSelectionOnly);
     connect(this, &KateSearchBar::findOrReplaceAllFinished, this, &KateSearchBar::endFindOrReplaceAll);
 
@@ -213,6 +312,10 @@ KateSearchBar::KateSearchBar(bool initAsPower, KTextEditor::ViewPrivate *view, K
 
 KateSearchBar::~KateSearchBar()
 {
+    // the background jobs of a parallel find all post back to us
+    cancelParallelFindAll();
+    m_findAllPool.waitForDone();
+
     if (!m_cancelFindOrReplace) {
         // Finish/Cancel the still running job to avoid a crash
         endFindOrReplaceAll();
@@ -795,17 +898,190 @@ void KateSearchBar::beginFindOrReplaceAll(Range inputRange, const QString &repla
     m_matchCounter = 0;
     m_cancelFindOrReplace = false; // Ensure we have a GO!
 
+    cancelParallelFindAll();
+    m_findAllChunks.clear();
+    m_viewportMatches.clear();
+
+    if (!m_replaceMode && startParallelFindAll()) {
+        return;
+    }
+
     findOrReplaceAll();
 }
 
+bool KateSearchBar::startParallelFindAll()
+{
+    // block selections are searched line by line, see findOrReplaceAll()
+    if (m_view->selection() && m_view->blockSelection() && selectionOnly()) {
+        return false;
+    }
+
+    // small ranges are searched faster than the jobs are started
+    const int firstLine = m_inputRange.start().line();
+    const int lastLine = m_inputRange.end().line();
+    if (lastLine - firstLine + 1 < ParallelFindAllMinLines) {
+        return false;
+    }
+
+    const std::optional<LineMatcher> matcher = LineMatcher::create(searchPattern(), searchOptions(SearchForward));
+    if (!matcher) {
+        return false;
+    }
+
+    // the jobs search a snapshot of the lines, the strings are implicitly shared, copying them is cheap
+    // edits invalidate the found ranges, they are detected via the revision, see findAllChunkFinished()
+    KTextEditor::DocumentPrivate *const doc = m_view->doc();
+    const int chunks = (lastLine - firstLine) / FindAllChunkSize + 1;
+    const quint64 generation = ++m_findAllGeneration;
+    m_findAllChunks.resize(chunks);
+    m_findAllNextChunk = 0;
+    m_findAllPendingChunks = chunks;
+    m_findAllRevision = doc->revision();
+
+    for (int chunk = 0; chunk < chunks; ++chunk) {
+        const int chunkStart = firstLine + chunk * FindAllChunkSize;
+        const int chunkEnd = std::min(lastLine, chunkStart + FindAllChunkSize - 1);
+        QStringList lines;
+        lines.reserve(chunkEnd - chunkStart + 1);
+        for (int line = chunkStart; line <= chunkEnd; ++line) {
+            lines.push_back(doc->line(line));
+        }
+
+        m_findAllPool.start([this, generation, chunk, chunkStart, lines = std::move(lines), matcher = *matcher, inputRange = m_inputRange]() {
+            std::vector<Range> matches;
+            for (int i = 0; i < lines.size(); ++i) {
+                // abort early if cancelled, e.g. a new search started
+                if (m_findAllGeneration != generation) {
+                    return;
+                }
+
+                const int line = chunkStart + i;
+                const bool lastLine = line == inputRange.end().line();
+                const int startColumn = (line == inputRange.start().line()) ? inputRange.start().column() : 0;
+                const int endColumn = lastLine ? std::min<int>(inputRange.end().column(), lines[i].size()) : lines[i].size();
+                matcher.matchLine(lines[i], line, startColumn, endColumn, lastLine, matches);
+            }
+
+            QMetaObject::invokeMethod(
+                this,
+                [this, generation, chunk, matches = std::move(matches)]() {
+                    findAllChunkFinished(generation, chunk, matches);
+                },
+                Qt::QueuedConnection);
+        });
+    }
+
+    return true;
+}
+
+void KateSearchBar::findAllChunkFinished(quint64 generation, int chunk, const std::vector<Range> &matches)
+{
+    // cancelled or a new search started in between
+    if (generation != m_findAllGeneration || m_findAllPendingChunks == 0) {
+        return;
+    }
+
+    // the document changed, the ranges of the snapshot don't fit anymore, stop with what we have
+    if (m_view->doc()->revision() != m_findAllRevision) {
+        cancelParallelFindAll();
+        m_findAllChunks.clear();
+        Q_EMIT findOrReplaceAllFinished();
+        return;
+    }
+
+    // the chunks finish in any order, stream the matches to the view in document order,
+    // the limit of highlighted matches must keep the first ones, like the sequential search does
+    m_findAllChunks[chunk] = matches;
+    for (; m_findAllNextChunk < int(m_findAllChunks.size()) && m_findAllChunks[m_findAllNextChunk]; ++m_findAllNextChunk) {
+        const std::vector<Range> &chunkMatches = *m_findAllChunks[m_findAllNextChunk];
+        const bool couldHighlightAll = m_matchCounter < MaxHighlightings;
+        m_matchCounter += chunkMatches.size();
+        if (m_matchCounter < MaxHighlightings) {
+            addSearchMarks(chunkMatches);
+            for (const Range &r : chunkMatches) {
+                highlightMatch(r);
+            }
+        } else if (couldHighlightAll) {
+            // too many matches, from now on only the displayed ones get highlighted
+            clearHighlights();
+        }
+    }
+
+    // report progress
+    showResultMessage();
+
+    if (--m_findAllPendingChunks > 0) {
+        return;
+    }
+
+    // all done, the ones in the displayed lines get highlighted once we are finished, see endFindOrReplaceAll()
+    if (m_matchCounter >= MaxHighlightings) {
+        m_viewportMatches.reserve(m_matchCounter);
+        for (const auto &chunkMatches : m_findAllChunks) {
+            m_viewportMatches.insert(m_viewportMatches.end(), chunkMatches->begin(), chunkMatches->end());
+        }
+    }
+    m_findAllChunks.clear();
+    Q_EMIT findOrReplaceAllFinished();
+}
+
+void KateSearchBar::updateViewportHighlights()
+{
+    // a running find or replace all still fills the matches, it highlights the displayed ones once done
+    if (!m_cancelFindOrReplace || m_findAllPendingChunks > 0) {
+        return;
+    }
+
+    applyViewportHighlights();
+}
+
+void KateSearchBar::applyViewportHighlights()
+{
+    if (m_viewportMatches.empty()) {
+        return;
+    }
+
+    // the matches are plain ranges, they are useless after edits
+    if (m_view->doc()->revision() != m_findAllRevision) {
+        m_viewportMatches.clear();
+        return;
+    }
+
+    qDeleteAll(m_hlRanges);
+    m_hlRanges.clear();
+
+    // the matches are sorted and don't overlap, so are their ends
+    const int firstLine = m_view->firstDisplayedLine();
+    const int lastLine = m_view->lastDisplayedLine();
+    auto it = std::lower_bound(m_viewportMatches.begin(), m_viewportMatches.end(), firstLine, [](const Range &range, int line) {
+        return range.end().line() < line;
+    });
+    for (; it != m_viewportMatches.end() && it->start().line() <= lastLine; ++it) {
+        if (m_replaceMode) {
+            highlightReplacement(*it);
+        } else {
+            highlightMatch(*it);
+        }
+    }
+}
+
+void KateSearchBar::addSearchMarks(const std::vector<Range> &ranges)
+{
+    if (ranges.empty()) {
+        return;
+    }
+
+    m_view->document()->setMarkDescription(KTextEditor::Document::SearchMatch, i18n("SearchHighLight"));
+    m_view->document()->setMarkIcon(KTextEditor::Document::SearchMatch, QIcon());
+    for (const Range &r : ranges) {
+        m_view->document()->addMark(r.start().line(), KTextEditor::Document::SearchMatch);
+    }
+}
+
 void KateSearchBar::findOrReplaceAll()
 {
     const SearchOptions enabledOptions = searchOptions(SearchForward);
 
-    // we highlight all ranges of a replace, up to some hard limit
-    // e.g. if you replace 100000 things, rendering will break down otherwise ;=)
-    const int maxHighlightings = 65536;
-
     // reuse match object to avoid massive moving range creation
     KateMatch match(m_view->doc(), enabledOptions);
 
@@ -854,12 +1130,15 @@ void KateSearchBar::findOrReplaceAll()
                 ++m_matchCounter;
             }
 
-            // remember ranges if limit not reached
-            if (m_matchCounter < maxHighlightings) {
+            // remember ranges, past the limit only the displayed ones get highlighted in the end
+            if (m_matchCounter < MaxHighlightings) {
                 m_highlightRanges.push_back(lastRange);
             } else {
-                m_highlightRanges.clear();
-                // TODO Info user that highlighting is disabled
+                if (!m_highlightRanges.empty()) {
+                    m_viewportMatches = std::move(m_highlightRanges);
+                    m_highlightRanges.clear();
+                }
+                m_viewportMatches.push_back(lastRange);
             }
 
             // Continue after match
@@ -909,6 +1188,9 @@ void KateSearchBar::endFindOrReplaceAll()
     // Don't forget to remove our "crash protector"
     disconnect(m_view->doc(), &KTextEditor::Document::aboutToClose, this, &KateSearchBar::endFindOrReplaceAll);
 
+    // stop a still running parallel find all
+    cancelParallelFindAll();
+
     // After last match
     if (m_matchCounter > 0) {
         if (m_replaceMode) {
@@ -916,15 +1198,16 @@ void KateSearchBar::endFindOrReplaceAll()
         }
     }
 
-    // Add ScrollBarMarks
-    if (!m_highlightRanges.empty()) {
-        m_view->document()->setMarkDescription(KTextEditor::Document::SearchMatch, i18n("SearchHighLight"));
-        m_view->document()->setMarkIcon(KTextEditor::Document::SearchMatch, QIcon());
-        for (const Range &r : m_highlightRanges) {
-            m_view->document()->addMark(r.start().line(), KTextEditor::Document::SearchMatch);
-        }
+    // too many matches to highlight them all, the later replacements didn't move the earlier ranges
+    // the matches are complete now, they are valid for the current revision
+    if (!m_viewportMatches.empty()) {
+        m_findAllRevision = m_view->doc()->revision();
+        applyViewportHighlights();
     }
 
+    // Add ScrollBarMarks
+    addSearchMarks(m_highlightRanges);
+
     // Add highlights
     if (m_replaceMode) {
         for (const Range &r : std::as_const(m_highlightRanges)) {
@@ -1631,6 +1914,8 @@ bool KateSearchBar::clearHighlights()
         delete m_infoMessage;
     }
 
+    m_viewportMatches.clear();
+
     if (m_hlRanges.isEmpty()) {
         return false;
     }
@@ -1755,6 +2040,12 @@ void KateSearchBar::onPowerReplacmentContextMenuRequest()
 void KateSearchBar::onPowerCancelFindOrReplace()
 {
     m_cancelFindOrReplace = true;
+
+    // a parallel find all has no time slices that check for the cancel request
+    if (m_findAllPendingChunks > 0) {
+        cancelParallelFindAll();
+        Q_EMIT findOrReplaceAllFinished();
+    }
 }
 
 bool KateSearchBar::isPower() const
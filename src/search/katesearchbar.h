@@ -14,6 +14,12 @@
 #include <ktexteditor/attribute.h>
 #include <ktexteditor/document.h>
 
+#include <QThreadPool>
+
+#include <atomic>
+#include <optional>
+#include <vector>
+
 namespace KTextEditor
 {
 class ViewPrivate;
@@ -167,6 +173,52 @@ private:
         beginFindOrReplaceAll(inputRange, QString(), false);
     };
 
+    /**
+     * Start scanning the input range of a find all in parallel background jobs.
+     * Each job searches a chunk of lines of a snapshot of the document and
+     * streams its matches back with @ref findAllChunkFinished().
+     * Replacing, block selections and patterns that may span lines are not
+     * supported, for these @ref findOrReplaceAll() has to do the work.
+     * @return true if the jobs were started
+     */
+    KTEXTEDITOR_NO_EXPORT
+    bool startParallelFindAll();
+
+    /**
+     * Collect the matches of one chunk searched by @ref startParallelFindAll().
+     * Emits @ref findOrReplaceAllFinished() once the last chunk arrived.
+     */
+    KTEXTEDITOR_NO_EXPORT
+    void findAllChunkFinished(quint64 generation, int chunk, const std::vector<KTextEditor::Range> &matches);
+
+    /**
+     * Cancel the running background jobs of a parallel find all, if any.
+     * Results they still deliver will be ignored.
+     */
+    KTEXTEDITOR_NO_EXPORT
+    void cancelParallelFindAll()
+    {
+        ++m_findAllGeneration;
+        m_findAllPendingChunks = 0;
+    }
+
+    /**
+     * Too many matches to highlight them all, highlight the ones in the displayed lines.
+     * Invoked whenever the display range of the view changes, does nothing while a find or
+     * replace all is running, @ref endFindOrReplaceAll() applies the highlights once it is done.
+     */
+    KTEXTEDITOR_NO_EXPORT
+    void updateViewportHighlights();
+
+    /**
+     * Highlight the matches in m_viewportMatches that are in the displayed lines.
+     */
+    KTEXTEDITOR_NO_EXPORT
+    void applyViewportHighlights();
+
+    KTEXTEDITOR_NO_EXPORT
+    void addSearchMarks(const std::vector<KTextEditor::Range> &ranges);
+
     KTEXTEDITOR_NO_EXPORT
     bool isPatternValid() const;
 
@@ -227,6 +279,20 @@ private:
     bool m_selectionChangedByUndoRedo = false;
     std::vector<KTextEditor::Range> m_highlightRanges;
 
+    // parallel find all, see startParallelFindAll()
+    QThreadPool m_findAllPool;
+    std::atomic<quint64> m_findAllGeneration = 0;
+    int m_findAllPendingChunks = 0;
+    qint64 m_findAllRevision = -1;
+    // matches per chunk, unset until the chunk is searched
+    std::vector<std::optional<std::vector<KTextEditor::Range>>> m_findAllChunks;
+    // first chunk not yet streamed to the view, they are streamed in document order
+    int m_findAllNextChunk = 0;
+
+    // all matches or replacements of a find or replace all with too many to highlight,
+    // only the ones in the displayed lines get highlighted, valid for m_findAllRevision
+    std::vector<KTextEditor::Range> m_viewportMatches;
+
     // attribute to highlight matches with
     KTextEditor::Attribute::Ptr highlightMatchAttribute;
     KTextEditor::Attribute::Ptr highlightReplacementAttribute;
@@ -7,8 +7,12 @@
 #include "ontheflycheck.h"
 
 #include <QRegularExpression>
+#include <QTextBoundaryFinder>
 #include <QTimer>
 
+#include <algorithm>
+#include <utility>
+
 #include "katebuffer.h"
 #include "kateconfig.h"
 #include "kateglobal.h"
@@ -44,6 +48,7 @@ KateOnTheFlyChecker::KateOnTheFlyChecker(KTextEditor::DocumentPrivate *document)
 
     connect(document, &KTextEditor::DocumentPrivate::textInsertedRange, this, &KateOnTheFlyChecker::textInserted);
     connect(document, &KTextEditor::DocumentPrivate::textRemoved, this, &KateOnTheFlyChecker::textRemoved);
+    connect(document, &KTextEditor::Document::editingFinished, this, &KateOnTheFlyChecker::editingFinished);
     connect(document, &KTextEditor::DocumentPrivate::viewCreated, this, &KateOnTheFlyChecker::addView);
     connect(document, &KTextEditor::DocumentPrivate::highlightingModeChanged, this, &KateOnTheFlyChecker::updateConfig);
     connect(&document->buffer(), &KateBuffer::respellCheckBlock, this, &KateOnTheFlyChecker::handleRespellCheckBlock);
@@ -123,12 +128,23 @@ void KateOnTheFlyChecker::textInserted(KTextEditor::Document *document, KTextEdi
         return;
     }
 
+    // during an editing transaction only collect the changed text, see editingFinished()
+    if (m_document->isEditRunning()) {
+        addEditedRange(range, false);
+        return;
+    }
+
+    addModification(TEXT_INSERTED, range);
+}
+
+void KateOnTheFlyChecker::addModification(ModificationType type, KTextEditor::Range range)
+{
     bool listEmptyAtStart = m_modificationList.isEmpty();
 
     // don't consider a range that is not within the document range
     const KTextEditor::Range documentIntersection = m_document->documentRange().intersect(range);
-    if (!documentIntersection.isValid()) {
-        return;
+    if (!documentIntersection.isValid()) { // the intersection might however be empty if the last
+        return; // word has been removed, for example
     }
     // for performance reasons we only want to schedule spellchecks for ranges that are visible
     const auto views = m_document->views();
@@ -139,8 +155,8 @@ void KateOnTheFlyChecker::textInserted(KTextEditor::Document *document, KTextEdi
             // we don't handle this directly as the highlighting information might not be up-to-date yet
             KTextEditor::MovingRange *movingRange = m_document->newMovingRange(visibleIntersection);
             movingRange->setFeedback(this);
-            m_modificationList.push_back(ModificationItem(TEXT_INSERTED, movingRange));
-            ON_THE_FLY_DEBUG << "added" << *movingRange;
+            m_modificationList.push_back(ModificationItem(type, movingRange));
+            ON_THE_FLY_DEBUG << "added" << *movingRange << view->visibleRange();
         }
     }
 
@@ -149,6 +165,39 @@ void KateOnTheFlyChecker::textInserted(KTextEditor::Document *document, KTextEdi
     }
 }
 
+void KateOnTheFlyChecker::addEditedRange(KTextEditor::Range range, bool linesRemoved)
+{
+    m_editedLinesRemoved = m_editedLinesRemoved || linesRemoved;
+
+    // one moving range follows all changes of the transaction, it grows with text inserted at its borders
+    if (!m_editedRange) {
+        m_editedRange.reset(m_document->newMovingRange(range, KTextEditor::MovingRange::ExpandLeft | KTextEditor::MovingRange::ExpandRight));
+        return;
+    }
+
+    if (!m_editedRange->toRange().contains(range)) {
+        KTextEditor::Range editedRange = m_editedRange->toRange();
+        editedRange.expandToRange(range);
+        m_editedRange->setRange(editedRange);
+    }
+}
+
+void KateOnTheFlyChecker::editingFinished()
+{
+    if (!m_editedRange) {
+        return;
+    }
+
+    const KTextEditor::Range range = m_editedRange->toRange();
+    m_editedRange.reset();
+
+    // everything in the range is rechecked like inserted text, removed lines need the checks for the lines below, too
+    addModification(TEXT_INSERTED, range);
+    if (std::exchange(m_editedLinesRemoved, false)) {
+        addModification(TEXT_REMOVED, KTextEditor::Range(range.end(), KTextEditor::Cursor(range.end().line() + 1, 0)));
+    }
+}
+
 void KateOnTheFlyChecker::handleInsertedText(KTextEditor::Range range)
 {
     KTextEditor::Range consideredRange = range;
@@ -211,30 +260,13 @@ void KateOnTheFlyChecker::textRemoved(KTextEditor::Document *document, KTextEdit
         return;
     }
 
-    bool listEmptyAtStart = m_modificationList.isEmpty();
-
-    // don't consider a range that is behind the end of the document
-    const KTextEditor::Range documentIntersection = m_document->documentRange().intersect(range);
-    if (!documentIntersection.isValid()) { // the intersection might however be empty if the last
-        return; // word has been removed, for example
+    // the removed text is gone, only its position is left to check
+    if (m_document->isEditRunning()) {
+        addEditedRange(KTextEditor::Range(range.start(), range.start()), range.numberOfLines() > 0);
+        return;
     }
 
-    // for performance reasons we only want to schedule spellchecks for ranges that are visible
-    const auto views = m_document->views();
-    for (KTextEditor::View *i : views) {
-        KTextEditor::ViewPrivate *view = static_cast<KTextEditor::ViewPrivate *>(i);
-        KTextEditor::Range visibleIntersection = documentIntersection.intersect(view->visibleRange());
-        if (visibleIntersection.isValid()) { // see above
-            // we don't handle this directly as the highlighting information might not be up-to-date yet
-            KTextEditor::MovingRange *movingRange = m_document->newMovingRange(visibleIntersection);
-            movingRange->setFeedback(this);
-            m_modificationList.push_back(ModificationItem(TEXT_REMOVED, movingRange));
-            ON_THE_FLY_DEBUG << "added" << *movingRange << view->visibleRange();
-        }
-    }
-    if (listEmptyAtStart && !m_modificationList.isEmpty()) {
-        QTimer::singleShot(0, this, &KateOnTheFlyChecker::handleModifiedRanges);
-    }
+    addModification(TEXT_REMOVED, range);
 }
 
 inline bool rangesAdjacent(KTextEditor::Range r1, KTextEditor::Range r2)
@@ -336,6 +368,8 @@ void KateOnTheFlyChecker::freeDocument()
     }
     m_misspelledList.clear();
     clearModificationList();
+    m_editedRange.reset();
+    m_editedLinesRemoved = false;
 }
 
 void KateOnTheFlyChecker::performSpellCheck()
@@ -362,7 +396,8 @@ void KateOnTheFlyChecker::performSpellCheck()
     KTextEditor::DocumentPrivate::OffsetList encToDecOffsetList;
     QString text = m_document->decodeCharacters(*spellCheckRange, m_currentDecToEncOffsetList, encToDecOffsetList);
     ON_THE_FLY_DEBUG << "next spell checking" << text;
-    if (text.isEmpty()) { // passing an empty string to Sonnet can lead to a bad allocation exception
+    applyWordCache(text, language);
+    if (text.trimmed().isEmpty()) { // passing an empty string to Sonnet can lead to a bad allocation exception
         spellCheckDone(); // (bug 225867)
         return;
     }
@@ -382,11 +417,54 @@ void KateOnTheFlyChecker::performSpellCheck()
     m_backgroundChecker->setText(text); // don't call 'start()' after this!
 }
 
+void KateOnTheFlyChecker::applyWordCache(QString &text, const QString &dictionary)
+{
+    m_currentUncachedWords.clear();
+    m_currentMisspellings.clear();
+
+    // Sonnet skips words inside of addresses, the verdict for them depends on the context
+    m_currentCheckCacheable = !text.contains(QLatin1Char('@')) && !text.contains(QLatin1String("://"));
+    if (!m_currentCheckCacheable) {
+        return;
+    }
+
+    KateSpellCheckWordCache &cache = KTextEditor::EditorPrivate::self()->spellCheckManager()->wordCache();
+    QTextBoundaryFinder finder(QTextBoundaryFinder::Word, text);
+    int start = 0;
+    while (finder.toNextBoundary() >= 0) {
+        const int end = finder.position();
+        const QStringView word = QStringView(text).mid(start, end - start);
+        const int wordStart = start;
+        start = end;
+        if (std::none_of(word.begin(), word.end(), [](QChar c) {
+                return c.isLetter();
+            })) {
+            continue;
+        }
+
+        const QString wordString = word.toString();
+        switch (cache.find(dictionary, wordString)) {
+        case KateSpellCheckWordCache::Verdict::Unknown:
+            m_currentUncachedWords.push_back(qMakePair(wordStart, wordString));
+            continue;
+        case KateSpellCheckWordCache::Verdict::Misspelled:
+            addMisspelledRange(wordString, wordStart);
+            break;
+        case KateSpellCheckWordCache::Verdict::Correct:
+            break;
+        }
+
+        // the offsets of the remaining words must not change
+        std::fill(text.begin() + wordStart, text.begin() + end, QLatin1Char(' '));
+    }
+}
+
 void KateOnTheFlyChecker::addToDictionary(const QString &word)
 {
     if (m_backgroundChecker) {
         m_backgroundChecker->addWordToPersonal(word);
     }
+    clearMisspellingForWord(word);
 }
 
 void KateOnTheFlyChecker::addToSession(const QString &word)
@@ -394,6 +472,7 @@ void KateOnTheFlyChecker::addToSession(const QString &word)
     if (m_backgroundChecker) {
         m_backgroundChecker->addWordToSession(word);
     }
+    clearMisspellingForWord(word);
 }
 
 void KateOnTheFlyChecker::removeRangeFromEverything(KTextEditor::MovingRange *movingRange)
@@ -432,6 +511,9 @@ bool KateOnTheFlyChecker::removeRangeFromCurrentSpellCheck(KTextEditor::MovingRa
 void KateOnTheFlyChecker::stopCurrentSpellCheck()
 {
     m_currentDecToEncOffsetList.clear();
+    m_currentUncachedWords.clear();
+    m_currentMisspellings.clear();
+    m_currentCheckCacheable = false;
     m_currentlyCheckedItem = invalidSpellCheckQueueItem();
     if (m_backgroundChecker) {
         m_backgroundChecker->stop();
@@ -562,6 +644,20 @@ void KateOnTheFlyChecker::misspelling(const QString &word, int start)
         ON_THE_FLY_DEBUG << "exited as no spell check is taking place";
         return;
     }
+
+    addMisspelledRange(word, start);
+    if (m_currentCheckCacheable) {
+        KTextEditor::EditorPrivate::self()->spellCheckManager()->wordCache().insert(m_currentlyCheckedItem.second, word, false);
+        m_currentMisspellings.push_back(qMakePair(start, int(word.size())));
+    }
+
+    if (m_backgroundChecker) {
+        m_backgroundChecker->continueChecking();
+    }
+}
+
+void KateOnTheFlyChecker::addMisspelledRange(const QString &word, int start)
+{
     int translatedStart = m_document->computePositionWrtOffsets(m_currentDecToEncOffsetList, start);
     //   ON_THE_FLY_DEBUG << "misspelled " << word
     //                                     << " at line "
@@ -585,10 +681,6 @@ void KateOnTheFlyChecker::misspelling(const QString &word, int start)
 
     movingRange->setAttribute(KTextEditor::Attribute::Ptr(attribute));
     m_misspelledList.push_back(MisspelledItem(movingRange, m_currentlyCheckedItem.second));
-
-    if (m_backgroundChecker) {
-        m_backgroundChecker->continueChecking();
-    }
 }
 
 void KateOnTheFlyChecker::spellCheckDone()
@@ -597,6 +689,22 @@ void KateOnTheFlyChecker::spellCheckDone()
     if (m_currentlyCheckedItem == invalidSpellCheckQueueItem()) {
         return;
     }
+
+    // all words the speller did not complain about are fine
+    if (m_currentCheckCacheable) {
+        KateSpellCheckWordCache &cache = KTextEditor::EditorPrivate::self()->spellCheckManager()->wordCache();
+        for (const auto &word : std::as_const(m_currentUncachedWords)) {
+            const int wordEnd = word.first + word.second.size();
+            const bool misspelled =
+                std::any_of(m_currentMisspellings.cbegin(), m_currentMisspellings.cend(), [&word, wordEnd](const QPair<int, int> &misspelling) {
+                    return misspelling.first < wordEnd && word.first < misspelling.first + misspelling.second;
+                });
+            if (!misspelled) {
+                cache.insert(m_currentlyCheckedItem.second, word.second, true);
+            }
+        }
+    }
+
     KTextEditor::MovingRange *movingRange = m_currentlyCheckedItem.first;
     stopCurrentSpellCheck();
     deleteMovingRangeQuickly(movingRange);
@@ -790,12 +898,17 @@ void KateOnTheFlyChecker::addToSpellCheckQueue(KTextEditor::MovingRange *range,
 
     range->setFeedback(this);
 
-    // if the queue contains a subrange of 'range', we remove that one
+    // coalesce with the queued ranges overlapping 'range' for the same dictionary, the
+    // overlapping text would be checked twice otherwise
     for (QList<SpellCheckItem>::iterator i = m_spellCheckQueue.begin(); i != m_spellCheckQueue.end();) {
         KTextEditor::MovingRange *spellCheckRange = (*i).first;
         if (range->contains(*spellCheckRange)) {
             deleteMovingRangeQuickly(spellCheckRange);
             i = m_spellCheckQueue.erase(i);
+        } else if ((*i).second == dictionary && range->overlaps(*spellCheckRange)) {
+            range->setRange(range->toRange().encompass(*spellCheckRange));
+            deleteMovingRangeQuickly(spellCheckRange);
+            i = m_spellCheckQueue.erase(i);
         } else {
             ++i;
         }
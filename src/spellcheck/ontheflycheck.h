@@ -14,6 +14,7 @@
 #include <QSet>
 #include <QString>
 #include <map>
+#include <memory>
 
 #include <sonnet/speller.h>
 
@@ -64,8 +65,18 @@ protected:
     MisspelledList m_misspelledList;
     ModificationList m_modificationList;
     KTextEditor::DocumentPrivate::OffsetList m_currentDecToEncOffsetList;
+
+    // start and text of the words of the current check without cached verdict and start and
+    // length of the misspellings found, the words not overlapping one are spelled correctly
+    QList<QPair<int, QString>> m_currentUncachedWords;
+    QList<QPair<int, int>> m_currentMisspellings;
+    bool m_currentCheckCacheable = false;
     std::map<KTextEditor::View *, KTextEditor::Range> m_displayRangeMap;
 
+    // text changed in the running editing transaction, handled as one modification once it is finished
+    std::unique_ptr<KTextEditor::MovingRange> m_editedRange;
+    bool m_editedLinesRemoved = false;
+
     void freeDocument();
 
     void queueLineSpellCheck(KTextEditor::DocumentPrivate *document, int line);
@@ -97,6 +108,13 @@ protected:
     void deleteMovingRangeQuickly(KTextEditor::MovingRange *range);
     void stopCurrentSpellCheck();
 
+    /**
+     * Resolve the words of the text to check with the word cache, the known
+     * ones are replaced by spaces so they don't reach the speller again.
+     **/
+    void applyWordCache(QString &text, const QString &dictionary);
+    void addMisspelledRange(const QString &word, int start);
+
 protected:
     void performSpellCheck();
     void addToDictionary(const QString &word);
@@ -111,6 +129,10 @@ protected:
     void restartViewRefreshTimer(KTextEditor::ViewPrivate *view);
     void viewRefreshTimeout();
 
+    void addModification(ModificationType type, KTextEditor::Range range);
+    void addEditedRange(KTextEditor::Range range, bool linesRemoved);
+    void editingFinished();
+
     void handleModifiedRanges();
     void handleInsertedText(KTextEditor::Range range);
     void handleRemovedText(KTextEditor::Range range);
@@ -8,6 +8,8 @@
 
 #include "katepartdebug.h"
 
+#include <deque>
+
 void KatePrefixStore::addPrefix(const QString &prefix)
 {
     if (prefix.isEmpty()) {
@@ -16,25 +18,9 @@ void KatePrefixStore::addPrefix(const QString &prefix)
     if (m_prefixSet.contains(prefix)) {
         return;
     }
-    unsigned long long state = 0;
-    for (int i = 0; i < prefix.length(); ++i) {
-        QChar c = prefix.at(i);
-
-        CharToOccurrenceStateHash &hash = m_transitionFunction[state];
-        CharToOccurrenceStateHash::iterator it = hash.find(c.unicode());
-        if (it == hash.end()) {
-            state = nextFreeState();
-            hash[c.unicode()] = QPair<unsigned int, unsigned long long>(1, state);
-            continue;
-        }
-
-        ++(*it).first;
-        state = (*it).second;
-    }
-    // add the last state as accepting state
-    m_acceptingStates.insert(state);
 
     m_prefixSet.insert(prefix);
+    m_compiled = false;
 
     if (prefix.length() > m_longestPrefixLength) {
         m_longestPrefixLength = prefix.length();
@@ -49,83 +35,161 @@ void KatePrefixStore::removePrefix(const QString &prefix)
     if (!m_prefixSet.contains(prefix)) {
         return;
     }
+
     m_prefixSet.remove(prefix);
+    m_compiled = false;
 
-    unsigned long long state = 0;
-    for (int i = 0; i < prefix.length(); ++i) {
-        QChar c = prefix.at(i);
+    if (prefix.length() == m_longestPrefixLength) {
+        m_longestPrefixLength = computeLongestPrefixLength();
+    }
+}
 
-        CharToOccurrenceStateHash &hash = m_transitionFunction[state];
-        CharToOccurrenceStateHash::iterator it = hash.find(c.unicode());
-        if (it == hash.end()) {
-            continue;
+void KatePrefixStore::dump()
+{
+    compile();
+    for (int state = 0; state < int(m_depth.size()); ++state) {
+        for (int c = 1; c < m_classCount; ++c) {
+            const int next = m_transitions[state * m_classCount + c];
+            if (m_depth[next] == m_depth[state] + 1) {
+                qCDebug(LOG_KTE) << state << "x" << c << "->" << next;
+            }
         }
-
-        state = (*it).second;
-        if (m_acceptingStates.contains(state) && i == prefix.length() - 1) {
-            m_acceptingStates.remove(state);
+    }
+    QList<int> acceptingStates;
+    for (int state = 0; state < int(m_accepting.size()); ++state) {
+        if (m_accepting[state]) {
+            acceptingStates.push_back(state);
         }
+    }
+    qCDebug(LOG_KTE) << "Accepting states" << acceptingStates;
+}
 
-        if ((*it).first <= 1) {
-            hash.erase(it);
-            m_stateFreeList.push_back(state);
-        } else {
-            --(*it).first;
+void KatePrefixStore::compile() const
+{
+    if (m_compiled) {
+        return;
+    }
+    m_compiled = true;
+
+    // number the characters used in the prefixes
+    m_asciiClasses.fill(0);
+    m_otherClasses.clear();
+    m_classCount = 1;
+    for (const QString &prefix : m_prefixSet) {
+        for (const QChar c : prefix) {
+            if (characterClass(c) == 0) {
+                if (c.unicode() < m_asciiClasses.size()) {
+                    m_asciiClasses[c.unicode()] = m_classCount++;
+                } else {
+                    m_otherClasses.insert(c.unicode(), m_classCount++);
+                }
+            }
         }
     }
 
-    if (prefix.length() == m_longestPrefixLength) {
-        m_longestPrefixLength = computeLongestPrefixLength();
+    // build the trie, -1 marks missing transitions
+    m_transitions.assign(m_classCount, -1);
+    m_depth.assign(1, 0);
+    m_accepting.assign(1, false);
+    for (const QString &prefix : m_prefixSet) {
+        int state = 0;
+        for (const QChar c : prefix) {
+            const int index = state * m_classCount + characterClass(c);
+            if (m_transitions[index] < 0) {
+                m_transitions[index] = int(m_depth.size());
+                m_transitions.resize(m_transitions.size() + m_classCount, -1);
+                m_depth.push_back(m_depth[state] + 1);
+                m_accepting.push_back(false);
+            }
+            state = m_transitions[index];
+        }
+        m_accepting[state] = true;
     }
-}
 
-void KatePrefixStore::dump()
-{
-    for (unsigned long long i = 0; i < m_lastAssignedState; ++i) {
-        CharToOccurrenceStateHash &hash = m_transitionFunction[i];
-        for (CharToOccurrenceStateHash::iterator it = hash.begin(); it != hash.end(); ++it) {
-            qCDebug(LOG_KTE) << i << "x" << QChar(it.key()) << "->" << it.value().first << "x" << it.value().second;
+    // add the failure transitions in breadth-first order, the failure state is always shallower
+    std::vector<int> failure(m_depth.size(), 0);
+    m_outputLink.assign(m_depth.size(), -1);
+    std::deque<int> queue;
+    for (int c = 0; c < m_classCount; ++c) {
+        int &next = m_transitions[c];
+        if (next < 0) {
+            next = 0;
+        } else {
+            queue.push_back(next);
+        }
+    }
+    while (!queue.empty()) {
+        const int state = queue.front();
+        queue.pop_front();
+        const int fail = failure[state];
+        for (int c = 0; c < m_classCount; ++c) {
+            int &next = m_transitions[state * m_classCount + c];
+            if (next < 0) {
+                next = m_transitions[fail * m_classCount + c];
+            } else {
+                const int nextFail = m_transitions[fail * m_classCount + c];
+                failure[next] = nextFail;
+                m_outputLink[next] = m_accepting[nextFail] ? nextFail : m_outputLink[nextFail];
+                queue.push_back(next);
+            }
         }
     }
-    qCDebug(LOG_KTE) << "Accepting states" << m_acceptingStates;
 }
 
-QString KatePrefixStore::findPrefix(const QString &s, int start) const
+int KatePrefixStore::prefixLength(QStringView s, int start) const
 {
-    unsigned long long state = 0;
+    if (m_prefixSet.isEmpty()) {
+        return 0;
+    }
+    compile();
+
+    // follow the trie only, a transition not going one level deeper is a failure transition
+    int state = 0;
     for (int i = start; i < s.length(); ++i) {
-        QChar c = s.at(i);
-        const CharToOccurrenceStateHash &hash = m_transitionFunction[state];
-        CharToOccurrenceStateHash::const_iterator it = hash.find(c.unicode());
-        if (it == hash.end()) {
-            return QString();
+        state = m_transitions[state * m_classCount + characterClass(s[i])];
+        if (m_depth[state] != i + 1 - start) {
+            return 0;
         }
-
-        state = (*it).second;
-        if (m_acceptingStates.contains(state)) {
-            return s.mid(start, i + 1 - start);
+        if (m_accepting[state]) {
+            return i + 1 - start;
         }
     }
-    return QString();
+    return 0;
+}
+
+QString KatePrefixStore::findPrefix(const QString &s, int start) const
+{
+    return s.mid(start, prefixLength(s, start));
 }
 
 QString KatePrefixStore::findPrefix(const Kate::TextLine &line, int start) const
 {
-    unsigned long long state = 0;
-    for (int i = start; i < line.length(); ++i) {
-        QChar c = line.at(i);
-        const CharToOccurrenceStateHash &hash = m_transitionFunction[state];
-        CharToOccurrenceStateHash::const_iterator it = hash.find(c.unicode());
-        if (it == hash.end()) {
-            return QString();
-        }
+    const int length = prefixLength(line.text(), start);
+    return length > 0 ? line.string(start, length) : QString();
+}
 
-        state = (*it).second;
-        if (m_acceptingStates.contains(state)) {
-            return line.string(start, i + 1 - start);
+std::vector<int> KatePrefixStore::prefixLengths(const Kate::TextLine &line) const
+{
+    if (m_prefixSet.isEmpty()) {
+        return {};
+    }
+    compile();
+
+    const QString &text = line.text();
+    std::vector<int> lengths(text.size(), 0);
+    int state = 0;
+    for (int i = 0; i < text.size(); ++i) {
+        state = m_transitions[state * m_classCount + characterClass(text[i])];
+
+        // all prefixes ending here, the first one found for a start is the shortest
+        for (int match = m_accepting[state] ? state : m_outputLink[state]; match >= 0; match = m_outputLink[match]) {
+            int &length = lengths[i + 1 - m_depth[match]];
+            if (length == 0) {
+                length = m_depth[match];
+            }
         }
     }
-    return QString();
+    return lengths;
 }
 
 int KatePrefixStore::longestPrefixLength() const
@@ -137,10 +201,7 @@ void KatePrefixStore::clear()
 {
     m_longestPrefixLength = 0;
     m_prefixSet.clear();
-    m_transitionFunction.clear();
-    m_acceptingStates.clear();
-    m_stateFreeList.clear();
-    m_lastAssignedState = 0;
+    m_compiled = false;
 }
 
 int KatePrefixStore::computeLongestPrefixLength()
@@ -152,11 +213,3 @@ int KatePrefixStore::computeLongestPrefixLength()
     }
     return toReturn;
 }
-
-unsigned long long KatePrefixStore::nextFreeState()
-{
-    if (!m_stateFreeList.isEmpty()) {
-        return m_stateFreeList.takeFirst();
-    }
-    return ++m_lastAssignedState;
-}
@@ -14,6 +14,11 @@
 #include <QString>
 
 #include "katetextline.h"
+#include <ktexteditor_export.h>
+
+#include <array>
+#include <utility>
+#include <vector>
 
 /**
  * This class can be used to efficiently search for occurrences of strings in
@@ -22,8 +27,13 @@
  * order to check whether a given string contains one of the strings that are being
  * searched for the constructed automaton has to applied on each position in the
  * given string.
+ *
+ * The automaton is an Aho-Corasick automaton stored as one dense transition
+ * table over the characters used in the prefixes, it is compiled on first use
+ * after the prefixes changed. prefixLengths() finds the matches for all
+ * positions of a line in one pass.
  **/
-class KatePrefixStore
+class KTEXTEDITOR_EXPORT KatePrefixStore
 {
 public:
     typedef QPair<bool, bool> BooleanPair;
@@ -45,6 +55,13 @@ public:
      **/
     QString findPrefix(const Kate::TextLine &line, int start = 0) const;
 
+    /**
+     * Returns for every column of the given line the length of the shortest
+     * prefix contained in this prefix store starting there, 0 if there is none.
+     * The result is empty if this prefix store is empty.
+     **/
+    std::vector<int> prefixLengths(const Kate::TextLine &line) const;
+
     int longestPrefixLength() const;
 
     void clear();
@@ -55,17 +72,67 @@ protected:
     int m_longestPrefixLength = 0;
     QSet<QString> m_prefixSet;
 
-    // State x Char -> Nr. of char occurrences in prefixes x State
-    typedef QHash<unsigned short, QPair<unsigned int, unsigned long long>> CharToOccurrenceStateHash;
-    typedef QHash<unsigned long long, CharToOccurrenceStateHash> TransitionFunction;
-    TransitionFunction m_transitionFunction;
-    QSet<unsigned long long> m_acceptingStates;
-    QList<unsigned long long> m_stateFreeList;
-    unsigned long long m_lastAssignedState = 0;
-
     int computeLongestPrefixLength();
-    unsigned long long nextFreeState();
-    //     bool containsPrefixOfLengthEndingWith(int length, const QChar& c);
+
+private:
+    int prefixLength(QStringView s, int start) const;
+    void compile() const;
+
+    int characterClass(QChar c) const
+    {
+        const char16_t u = c.unicode();
+        return u < m_asciiClasses.size() ? m_asciiClasses[u] : m_otherClasses.value(u, 0);
+    }
+
+    // the compiled automaton, class 0 is used for all characters not part of any prefix
+    mutable bool m_compiled = false;
+    mutable std::array<int, 128> m_asciiClasses = {};
+    mutable QHash<char16_t, int> m_otherClasses;
+    mutable int m_classCount = 1;
+
+    // State x Class -> State, failure transitions folded in, state 0 is the start state
+    mutable std::vector<int> m_transitions;
+
+    // length of the prefix leading to the state, accepting or not
+    mutable std::vector<int> m_depth;
+    mutable std::vector<bool> m_accepting;
+
+    // next accepting state reachable via failure links, -1 if none
+    mutable std::vector<int> m_outputLink;
+};
+
+/**
+ * Prefix matches of the prefix stores used on one line, every prefix store
+ * scans the line only once.
+ **/
+class KatePrefixStoreLineMatches
+{
+public:
+    explicit KatePrefixStoreLineMatches(const Kate::TextLine &line)
+        : m_line(line)
+    {
+    }
+
+    /**
+     * Returns the length of the shortest prefix of the given prefix store
+     * starting at the given column of the line, 0 if there is none.
+     **/
+    int prefixLength(const KatePrefixStore &store, int column)
+    {
+        for (const auto &lengths : m_lengths) {
+            if (lengths.first == &store) {
+                return column < int(lengths.second.size()) ? lengths.second[column] : 0;
+            }
+        }
+
+        m_lengths.emplace_back(&store, store.prefixLengths(m_line));
+        const auto &lengths = m_lengths.back().second;
+        return column < int(lengths.size()) ? lengths[column] : 0;
+    }
+
+private:
+    const Kate::TextLine &m_line;
+    std::vector<std::pair<const KatePrefixStore *, std::vector<int>>> m_lengths;
 };
 
 #endif
@@ -35,6 +35,7 @@ void KateSpellCheckManager::ignoreWord(const QString &word, const QString &dicti
     Sonnet::Speller speller;
     speller.setLanguage(dictionary);
     speller.addToSession(word);
+    m_wordCache.remove(word);
     Q_EMIT wordIgnored(word);
 }
 
@@ -43,6 +44,12 @@ void KateSpellCheckManager::addToDictionary(const QString &word, const QString &
     Sonnet::Speller speller;
     speller.setLanguage(dictionary);
     speller.addToPersonal(word);
+    wordAddedToPersonal(word);
+}
+
+void KateSpellCheckManager::wordAddedToPersonal(const QString &word)
+{
+    m_wordCache.remove(word);
     Q_EMIT wordAddedToDictionary(word);
 }
 
@@ -144,13 +151,14 @@ QList<QPair<KTextEditor::Range, QString>> KateSpellCheckManager::spellCheckWrtHi
         bool inSpellCheckArea = false;
         for (int line = startLine; line <= endLine; ++line) {
             const auto kateTextLine = document->kateTextLine(line);
+            KatePrefixStoreLineMatches prefixMatches(kateTextLine);
             const int start = (line == startLine) ? startColumn : 0;
             const int end = (line == endLine) ? endColumn : kateTextLine.length();
             for (int i = start; i < end;) { // WARNING: 'i' has to be incremented manually!
                 int attr = kateTextLine.attribute(i);
                 const KatePrefixStore &prefixStore = highlighting->getCharacterEncodingsPrefixStore(attr);
-                QString prefixFound = prefixStore.findPrefix(kateTextLine, i);
-                if (!document->highlight()->attributeRequiresSpellchecking(static_cast<unsigned int>(attr)) && prefixFound.isEmpty()) {
+                const int prefixLength = prefixMatches.prefixLength(prefixStore, i);
+                if (!document->highlight()->attributeRequiresSpellchecking(static_cast<unsigned int>(attr)) && prefixLength == 0) {
                     if (i == start) {
                         ++i;
                         continue;
@@ -171,8 +179,8 @@ QList<QPair<KTextEditor::Range, QString>> KateSpellCheckManager::spellCheckWrtHi
                     begin = KTextEditor::Cursor(line, i);
                     inSpellCheckArea = true;
                 }
-                if (!prefixFound.isEmpty()) {
-                    i += prefixFound.length();
+                if (prefixLength > 0) {
+                    i += prefixLength;
                 } else {
                     ++i;
                 }
@@ -16,6 +16,8 @@
 #include <sonnet/backgroundchecker.h>
 #include <sonnet/speller.h>
 
+#include "spellcheckwordcache.h"
+
 namespace KTextEditor
 {
 class DocumentPrivate;
@@ -36,11 +38,25 @@ public:
     void ignoreWord(const QString &word, const QString &dictionary);
     void addToDictionary(const QString &word, const QString &dictionary);
 
+    /**
+     * Propagate that 'word' was added to the personal dictionary by a speller of
+     * its own, e.g. the one of the spell check bar, and forget its cached verdicts.
+     **/
+    void wordAddedToPersonal(const QString &word);
+
     /**
      * 'r2' is a subrange of 'r1', which is extracted from 'r1' and the remaining ranges are returned
      **/
     static QList<KTextEditor::Range> rangeDifference(KTextEditor::Range r1, KTextEditor::Range r2);
 
+    /**
+     * Verdicts of the on-the-fly spell checking for single words, shared by all documents.
+     **/
+    KateSpellCheckWordCache &wordCache()
+    {
+        return m_wordCache;
+    }
+
 Q_SIGNALS:
     /**
      * These signals are used to propagate the dictionary changes to the
@@ -63,6 +79,8 @@ public:
 
 private:
     static void trimRange(KTextEditor::DocumentPrivate *doc, KTextEditor::Range &r);
+
+    KateSpellCheckWordCache m_wordCache;
 };
 
 #endif
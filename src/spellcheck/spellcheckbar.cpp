@@ -6,6 +6,8 @@
 */
 
 #include "spellcheckbar.h"
+#include "kateglobal.h"
+#include "spellcheck.h"
 #include "ui_spellcheckbar.h"
 #include <KLocalizedString>
 
@@ -328,6 +330,7 @@ void SpellCheckBar::slotAddWord()
     setGuiEnabled(false);
     setProgressDialogVisible(true);
     d->checker->addWordToPersonal(d->currentWord.word);
+    KTextEditor::EditorPrivate::self()->spellCheckManager()->wordAddedToPersonal(d->currentWord.word);
     d->checker->continueChecking();
 }
 
@@ -370,6 +373,7 @@ void SpellCheckBar::slotSkipAll()
     Sonnet::Speller speller = d->checker->speller();
     speller.addToPersonal(d->currentWord.word);
     d->checker->setSpeller(speller);
+    KTextEditor::EditorPrivate::self()->spellCheckManager()->wordAddedToPersonal(d->currentWord.word);
     d->checker->continueChecking();
 }
 
@@ -33,7 +33,7 @@ class BackgroundChecker;
  * You can change buffer inside a slot connected to done() signal
  * and spellcheck will continue with new data automatically.
  */
-class SpellCheckBar : public KateViewBarWidget
+class KTEXTEDITOR_EXPORT SpellCheckBar : public KateViewBarWidget
 {
     Q_OBJECT
 public:
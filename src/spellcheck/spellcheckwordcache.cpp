@@ -0,0 +1,60 @@
+/*
+    SPDX-FileCopyrightText: 2026 KTextEditor contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#include "spellcheckwordcache.h"
+
+KateSpellCheckWordCache::Verdict KateSpellCheckWordCache::find(const QString &dictionary, const QString &word)
+{
+    const auto dictionaryIt = m_dictionaries.find(dictionary);
+    if (dictionaryIt == m_dictionaries.end()) {
+        return Verdict::Unknown;
+    }
+
+    Dictionary &cache = dictionaryIt.value();
+    const auto it = cache.verdicts.constFind(word);
+    if (it == cache.verdicts.cend()) {
+        return Verdict::Unknown;
+    }
+
+    // mark as most recently used
+    cache.words.splice(cache.words.begin(), cache.words, it->second);
+    return it->first ? Verdict::Correct : Verdict::Misspelled;
+}
+
+void KateSpellCheckWordCache::insert(const QString &dictionary, const QString &word, bool correct)
+{
+    Dictionary &cache = m_dictionaries[dictionary];
+    const auto it = cache.verdicts.find(word);
+    if (it != cache.verdicts.end()) {
+        it->first = correct;
+        cache.words.splice(cache.words.begin(), cache.words, it->second);
+        return;
+    }
+
+    cache.words.push_front(word);
+    cache.verdicts.insert(word, {correct, cache.words.begin()});
+
+    if (int(cache.words.size()) > MaximalSize) {
+        cache.verdicts.remove(cache.words.back());
+        cache.words.pop_back();
+    }
+}
+
+void KateSpellCheckWordCache::remove(const QString &word)
+{
+    for (Dictionary &cache : m_dictionaries) {
+        const auto it = cache.verdicts.find(word);
+        if (it != cache.verdicts.end()) {
+            cache.words.erase(it->second);
+            cache.verdicts.erase(it);
+        }
+    }
+}
+
+void KateSpellCheckWordCache::clear()
+{
+    m_dictionaries.clear();
+}
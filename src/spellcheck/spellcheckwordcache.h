@@ -0,0 +1,69 @@
+/*
+    SPDX-FileCopyrightText: 2026 KTextEditor contributors
+
+    SPDX-License-Identifier: LGPL-2.0-or-later
+*/
+
+#ifndef SPELLCHECKWORDCACHE_H
+#define SPELLCHECKWORDCACHE_H
+
+#include <QHash>
+#include <QString>
+
+#include <list>
+
+/**
+ * Verdicts of the spell checker for single words, one least recently used
+ * cache per dictionary.
+ *
+ * The on-the-fly spell checker rechecks whole lines after each edit, with
+ * this cache only the words it has not seen before reach the speller.
+ */
+class KateSpellCheckWordCache
+{
+public:
+    enum class Verdict { Unknown, Correct, Misspelled };
+
+    /**
+     * Maximal number of cached words per dictionary.
+     */
+    static constexpr int MaximalSize = 20000;
+
+    /**
+     * Lookup the verdict for a word.
+     * @param dictionary dictionary the word was checked with
+     * @param word word to lookup
+     * @return the cached verdict or Verdict::Unknown
+     */
+    Verdict find(const QString &dictionary, const QString &word);
+
+    /**
+     * Remember the verdict for a word.
+     * @param dictionary dictionary the word was checked with
+     * @param word checked word
+     * @param correct true if the word is spelled correctly
+     */
+    void insert(const QString &dictionary, const QString &word, bool correct);
+
+    /**
+     * Forget a word in all dictionaries, e.g. after it was added to one.
+     * @param word word to forget
+     */
+    void remove(const QString &word);
+
+    /**
+     * Forget everything.
+     */
+    void clear();
+
+private:
+    struct Dictionary {
+        // most recently used first
+        std::list<QString> words;
+        QHash<QString, std::pair<bool, std::list<QString>::iterator>> verdicts;
+    };
+
+    QHash<QString, Dictionary> m_dictionaries;
+};
+
+#endif
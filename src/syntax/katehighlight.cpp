@@ -19,8 +19,17 @@
 // END
 
 // BEGIN KateHighlighting
+QMutex &KateHighlighting::definitionMutex()
+{
+    static QMutex mutex;
+    return mutex;
+}
+
 KateHighlighting::KateHighlighting(const KSyntaxHighlighting::Definition &def)
 {
+    // the definitions might be in use by a background job
+    QMutexLocker locker(&definitionMutex());
+
     // get name and section, always works
     iName = def.name();
     iSection = def.translatedSection();
@@ -142,7 +151,12 @@ void KateHighlighting::doHighlight(const Kate::TextLine *prevLine, Kate::TextLin
     m_textLineToHighlight = textLine;
     m_foldings = foldings;
     const KSyntaxHighlighting::State initialState(!prevLine ? KSyntaxHighlighting::State() : prevLine->highlightingState());
-    const KSyntaxHighlighting::State endOfLineState = highlightLine(textLine->text(), initialState);
+    KSyntaxHighlighting::State endOfLineState;
+    {
+        // lock per line, the GUI thread waits at most for one line of a background job
+        QMutexLocker locker(&definitionMutex());
+        endOfLineState = highlightLine(textLine->text(), initialState);
+    }
     m_textLineToHighlight = nullptr;
     m_foldings = nullptr;
 
@@ -164,6 +178,11 @@ void KateHighlighting::doHighlight(const Kate::TextLine *prevLine, Kate::TextLin
     }
 }
 
+std::unique_ptr<KateHighlighting> KateHighlighting::clone() const
+{
+    return std::make_unique<KateHighlighting>(definition());
+}
+
 void KateHighlighting::applyFormat(int offset, int length, const KSyntaxHighlighting::Format &format)
 {
     Q_ASSERT(m_textLineToHighlight);
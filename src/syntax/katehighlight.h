@@ -22,10 +22,12 @@
 
 #include <QHash>
 #include <QList>
+#include <QMutex>
 
 #include <QRegularExpression>
 #include <QStringList>
 
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
@@ -128,6 +130,22 @@ public:
      */
     void doHighlight(const Kate::TextLine *prevLine, Kate::TextLine *textLine, bool &ctxChanged, Foldings *foldings = nullptr);
 
+    /**
+     * Create a second highlighting for the same definition, with identical attribute indices.
+     * doHighlight is not reentrant, a background thread needs its own instance.
+     * @return new highlighting instance
+     */
+    std::unique_ptr<KateHighlighting> clone() const;
+
+    /**
+     * KSyntaxHighlighting is not thread-safe. All highlighting instances of a definition share
+     * its rules, which set up parts of their state lazily, e.g. the ones of the background jobs.
+     * The highlighting of one line, the setup of new instances and the reload of the repository
+     * lock this mutex, the background jobs and the GUI thread never highlight at the same time.
+     * @return mutex guarding the use of the syntax definitions
+     */
+    static QMutex &definitionMutex();
+
     const QString &name() const
     {
         return iName;
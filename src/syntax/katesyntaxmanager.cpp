@@ -74,7 +74,10 @@ void KateHlManager::reload()
 
     // recreate repository
     // this might even remove highlighting modes known before
-    m_repository.reload();
+    {
+        QMutexLocker locker(&KateHighlighting::definitionMutex());
+        m_repository.reload();
+    }
 
     // let all documents use the new highlighters
     // will be created on demand
@@ -85,6 +88,9 @@ void KateHlManager::reload()
         if (nameFind(hlMode) < 0) {
             hlMode = QStringLiteral("None");
         }
+
+        // results of the old definitions can't be reused by the new ones
+        static_cast<KTextEditor::DocumentPrivate *>(doc)->buffer().discardEarlierHighlightingResults();
         doc->setHighlightingMode(hlMode);
     }
 
@@ -19,6 +19,8 @@
 #include <ktexteditor/cursor.h>
 #include <ktexteditor/view.h>
 
+#include <QDataStream>
+
 KateUndoGroup::KateUndoGroup(const KTextEditor::Cursor cursorPosition,
                              KTextEditor::Range selection,
                              const QList<KTextEditor::ViewPrivate::PlainSecondaryCursor> &secondary)
@@ -32,6 +34,7 @@ KateUndoGroup::KateUndoGroup(const KTextEditor::Cursor cursorPosition,
 
 void KateUndoGroup::undo(KateUndoManager *manager, KTextEditor::ViewPrivate *view)
 {
+    decompress();
     if (m_items.empty()) {
         return;
     }
@@ -104,6 +107,7 @@ void KateUndoGroup::undo(KateUndoManager *manager, KTextEditor::ViewPrivate *vie
 
 void KateUndoGroup::redo(KateUndoManager *manager, KTextEditor::ViewPrivate *view)
 {
+    decompress();
     if (m_items.empty()) {
         return;
     }
@@ -213,6 +217,11 @@ static bool mergeUndoItems(UndoItem &base, const UndoItem &u)
 
 void KateUndoGroup::addItem(UndoItem u)
 {
+    Q_ASSERT(!isCompressed());
+
+    // the text is kept in both cases
+    m_memoryUsage += u.text.size() * qsizetype(sizeof(QChar));
+
     // try to merge, do that only for equal types, inside mergeWith we do hard casts
     if (!m_items.empty() && mergeUndoItems(m_items.back(), u)) {
         return;
@@ -220,6 +229,67 @@ void KateUndoGroup::addItem(UndoItem u)
 
     // default: just add new item unchanged
     m_items.push_back(std::move(u));
+    m_memoryUsage += sizeof(UndoItem);
+}
+
+void KateUndoGroup::compress()
+{
+    if (isCompressed() || m_items.empty()) {
+        return;
+    }
+
+    QByteArray data;
+    {
+        QDataStream stream(&data, QIODevice::WriteOnly);
+        stream << quint32(m_items.size());
+        for (const UndoItem &item : m_items) {
+            stream << qint8(item.type) << qint32(item.lineModFlags.toInt()) << qint32(item.line) << qint32(item.col) << item.text << item.autowrapped
+                   << item.newLine << item.removeLine << qint32(item.len);
+        }
+    }
+
+    // keep the items if compression doesn't pay off
+    QByteArray compressed = qCompress(data);
+    if (compressed.size() >= m_memoryUsage) {
+        return;
+    }
+
+    m_compressedItems = std::move(compressed);
+    m_memoryUsage = m_compressedItems.size();
+    m_items.clear();
+    m_items.shrink_to_fit();
+}
+
+void KateUndoGroup::decompress()
+{
+    if (!isCompressed()) {
+        return;
+    }
+
+    const QByteArray data = qUncompress(m_compressedItems);
+    m_compressedItems.clear();
+    m_memoryUsage = 0;
+
+    QDataStream stream(data);
+    quint32 count = 0;
+    stream >> count;
+    m_items.reserve(count);
+    for (quint32 i = 0; i < count; ++i) {
+        qint8 type = UndoItem::editInvalid;
+        qint32 flags = 0;
+        qint32 line = 0;
+        qint32 col = 0;
+        qint32 len = 0;
+        UndoItem item;
+        stream >> type >> flags >> line >> col >> item.text >> item.autowrapped >> item.newLine >> item.removeLine >> len;
+        item.type = UndoItem::UndoType(type);
+        item.lineModFlags = UndoItem::ModificationFlags::fromInt(flags);
+        item.line = line;
+        item.col = col;
+        item.len = len;
+        m_memoryUsage += sizeof(UndoItem) + item.text.size() * qsizetype(sizeof(QChar));
+        m_items.push_back(std::move(item));
+    }
 }
 
 bool KateUndoGroup::merge(KateUndoGroup *newGroup, bool complex)
@@ -228,12 +298,15 @@ bool KateUndoGroup::merge(KateUndoGroup *newGroup, bool complex)
         return false;
     }
 
+    decompress();
+    newGroup->decompress();
     if (newGroup->isOnlyType(singleType()) || complex) {
         // Take all of its items first -> last
         for (auto &item : newGroup->m_items) {
             addItem(item);
         }
         newGroup->m_items.clear();
+        newGroup->m_memoryUsage = 0;
 
         if (newGroup->m_safePoint) {
             safePoint();
@@ -257,6 +330,10 @@ void KateUndoGroup::safePoint(bool safePoint)
 
 void KateUndoGroup::flagSavedAsModified()
 {
+    // compressed groups are changed in place
+    const bool wasCompressed = isCompressed();
+    decompress();
+
     for (UndoItem &item : m_items) {
         if (item.lineModFlags.testFlag(UndoItem::UndoLine1Saved)) {
             item.lineModFlags.setFlag(UndoItem::UndoLine1Saved, false);
@@ -278,6 +355,10 @@ void KateUndoGroup::flagSavedAsModified()
             item.lineModFlags.setFlag(UndoItem::RedoLine2Modified, true);
         }
     }
+
+    if (wasCompressed) {
+        compress();
+    }
 }
 
 static void updateUndoSavedOnDiskFlag(UndoItem &item, QBitArray &lines)
@@ -334,9 +415,16 @@ static void updateUndoSavedOnDiskFlag(UndoItem &item, QBitArray &lines)
 
 void KateUndoGroup::markUndoAsSaved(QBitArray &lines)
 {
+    const bool wasCompressed = isCompressed();
+    decompress();
+
     for (auto rit = m_items.rbegin(); rit != m_items.rend(); ++rit) {
         updateUndoSavedOnDiskFlag(*rit, lines);
     }
+
+    if (wasCompressed) {
+        compress();
+    }
 }
 
 static void updateRedoSavedOnDiskFlag(UndoItem &item, QBitArray &lines)
@@ -389,9 +477,16 @@ static void updateRedoSavedOnDiskFlag(UndoItem &item, QBitArray &lines)
 
 void KateUndoGroup::markRedoAsSaved(QBitArray &lines)
 {
+    const bool wasCompressed = isCompressed();
+    decompress();
+
     for (auto rit = m_items.rbegin(); rit != m_items.rend(); ++rit) {
         updateRedoSavedOnDiskFlag(*rit, lines);
     }
+
+    if (wasCompressed) {
+        compress();
+    }
 }
 
 UndoItem::UndoType KateUndoGroup::singleType() const
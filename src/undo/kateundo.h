@@ -105,9 +105,32 @@ public:
      */
     bool isEmpty() const
     {
-        return m_items.empty();
+        return m_items.empty() && m_compressedItems.isEmpty();
     }
 
+    /**
+     * Approximate memory used by the items of this group in bytes.
+     * For a compressed group this is the size of the compressed data.
+     */
+    qsizetype memoryUsage() const
+    {
+        return m_memoryUsage;
+    }
+
+    /**
+     * Is this group compressed?
+     */
+    bool isCompressed() const
+    {
+        return !m_compressedItems.isEmpty();
+    }
+
+    /**
+     * Compress the items of this group, if that saves memory.
+     * Used for groups deep in the history, the items are restored on demand.
+     */
+    void compress();
+
     /**
      * Change all LineSaved flags to LineModified of the line modification system.
      */
@@ -137,7 +160,25 @@ public:
         return m_redoCursor;
     }
 
+    /**
+     * Save revision the line modification flags of this group are up to date with.
+     */
+    int saveRevision() const
+    {
+        return m_saveRevision;
+    }
+
+    void setSaveRevision(int revision)
+    {
+        m_saveRevision = revision;
+    }
+
 private:
+    /**
+     * Restore the items of a compressed group.
+     */
+    void decompress();
+
     /**
      * singleType
      * @return the type if it's only one type, or editInvalid if it contains multiple types.
@@ -164,6 +205,21 @@ private:
      */
     std::vector<UndoItem> m_items;
 
+    /**
+     * the items serialized and compressed, if this group is compressed
+     */
+    QByteArray m_compressedItems;
+
+    /**
+     * memory used by the items or the compressed data
+     */
+    qsizetype m_memoryUsage = 0;
+
+    /**
+     * save revision of the undo manager the line modification flags belong to
+     */
+    int m_saveRevision = 0;
+
     /**
      * prohibit merging with the next group
      */
@@ -8,12 +8,30 @@
 
 #include <ktexteditor/view.h>
 
+#include "kateconfig.h"
 #include "katedocument.h"
 #include "katepartdebug.h"
 #include "kateview.h"
 
 #include <QBitArray>
 
+#include <algorithm>
+
+// the most recent undo groups stay uncompressed, they are the likely ones to be undone or merged
+static constexpr size_t UncompressedUndoGroups = 16;
+
+// groups smaller than this are not worth compressing
+static constexpr qsizetype MinimumCompressedGroupSize = 1024;
+
+static qsizetype memoryUsageOf(const std::vector<KateUndoGroup> &groups)
+{
+    qsizetype usage = 0;
+    for (const KateUndoGroup &group : groups) {
+        usage += group.memoryUsage();
+    }
+    return usage;
+}
+
 KateUndoManager::KateUndoManager(KTextEditor::DocumentPrivate *doc)
     : QObject(doc)
     , m_document(doc)
@@ -27,6 +45,9 @@ KateUndoManager::KateUndoManager(KTextEditor::DocumentPrivate *doc)
     connect(doc, &KTextEditor::DocumentPrivate::aboutToReload, this, [this] {
         savedUndoItems = std::move(undoItems);
         savedRedoItems = std::move(redoItems);
+        undoItems.clear();
+        redoItems.clear();
+        m_memoryUsage = 0;
         docChecksumBeforeReload = m_document->checksum();
     });
 
@@ -35,6 +56,7 @@ KateUndoManager::KateUndoManager(KTextEditor::DocumentPrivate *doc)
         if (doc && !doc->checksum().isEmpty() && !docChecksumBeforeReload.isEmpty() && doc->checksum() == docChecksumBeforeReload) {
             undoItems = std::move(savedUndoItems);
             redoItems = std::move(savedRedoItems);
+            updateMemoryUsage();
             Q_EMIT undoChanged();
         }
         docChecksumBeforeReload.clear();
@@ -95,11 +117,26 @@ void KateUndoManager::editEnd()
 
     if (m_editCurrentUndo->isEmpty()) {
         m_editCurrentUndo.reset();
-    } else if (!undoItems.empty() && undoItems.back().merge(&*m_editCurrentUndo, m_undoComplexMerge)) {
-        m_editCurrentUndo.reset();
     } else {
-        undoItems.push_back(std::move(*m_editCurrentUndo));
-        changedUndo = true;
+        // the last group might get new items, its flags must be up to date with the last save before,
+        // this and merging might restore compressed items of it, account for that, too
+        const qsizetype lastGroupUsage = undoItems.empty() ? 0 : undoItems.back().memoryUsage();
+        if (!undoItems.empty()) {
+            updateLineModifications(undoItems.back(), true);
+        }
+
+        const bool merged = !undoItems.empty() && undoItems.back().merge(&*m_editCurrentUndo, m_undoComplexMerge);
+        if (!undoItems.empty()) {
+            m_memoryUsage += undoItems.back().memoryUsage() - lastGroupUsage;
+        }
+
+        if (!merged) {
+            m_memoryUsage += m_editCurrentUndo->memoryUsage();
+            m_editCurrentUndo->setSaveRevision(m_saveRevision);
+            undoItems.push_back(std::move(*m_editCurrentUndo));
+            limitMemoryUsage();
+            changedUndo = true;
+        }
     }
 
     m_editCurrentUndo.reset();
@@ -349,7 +386,10 @@ void KateUndoManager::addUndoItem(UndoItem undo)
     m_editCurrentUndo->addItem(std::move(undo));
 
     // Clear redo buffer
-    redoItems.clear();
+    if (!redoItems.empty()) {
+        m_memoryUsage -= memoryUsageOf(redoItems);
+        redoItems.clear();
+    }
 }
 
 void KateUndoManager::setActive(bool enabled)
@@ -379,7 +419,11 @@ void KateUndoManager::undo()
     if (!undoItems.empty()) {
         Q_EMIT undoStart(document());
 
+        // undoing restores the items of a compressed group
+        const qsizetype groupUsage = undoItems.back().memoryUsage();
+        updateLineModifications(undoItems.back(), true);
         undoItems.back().undo(this, activeView());
+        m_memoryUsage += undoItems.back().memoryUsage() - groupUsage;
         redoItems.push_back(std::move(undoItems.back()));
         undoItems.pop_back();
         updateModified();
@@ -395,9 +439,15 @@ void KateUndoManager::redo()
     if (!redoItems.empty()) {
         Q_EMIT redoStart(document());
 
+        const qsizetype groupUsage = redoItems.back().memoryUsage();
+        updateLineModifications(redoItems.back(), false);
         redoItems.back().redo(this, activeView());
+        m_memoryUsage += redoItems.back().memoryUsage() - groupUsage;
         undoItems.push_back(std::move(redoItems.back()));
         redoItems.pop_back();
+
+        // the history grew like for a new edit, compress the group that left the recent part and respect the budget
+        limitMemoryUsage();
         updateModified();
 
         Q_EMIT redoEnd(document());
@@ -485,6 +535,7 @@ void KateUndoManager::updateModified()
 
 void KateUndoManager::clearUndo()
 {
+    m_memoryUsage -= memoryUsageOf(undoItems);
     undoItems.clear();
 
     lastUndoGroupWhenSaved = nullptr;
@@ -495,6 +546,7 @@ void KateUndoManager::clearUndo()
 
 void KateUndoManager::clearRedo()
 {
+    m_memoryUsage -= memoryUsageOf(redoItems);
     redoItems.clear();
 
     lastRedoGroupWhenSaved = nullptr;
@@ -521,24 +573,33 @@ void KateUndoManager::setModified(bool modified)
 
 void KateUndoManager::updateLineModifications()
 {
-    // change LineSaved flag of all undo & redo items to LineModified
-    for (KateUndoGroup &undoGroup : undoItems) {
-        undoGroup.flagSavedAsModified();
-    }
+    // only record the save, the flags of the groups are updated once they are undone or redone,
+    // this happens from the top of the history downwards, the same order the saved lines are collected in
+    ++m_saveRevision;
+    m_undoSavedLines.clear();
+    m_redoSavedLines.clear();
+}
 
-    for (KateUndoGroup &undoGroup : redoItems) {
-        undoGroup.flagSavedAsModified();
+void KateUndoManager::updateLineModifications(KateUndoGroup &group, bool inUndoHistory)
+{
+    if (group.saveRevision() == m_saveRevision) {
+        return;
     }
+    group.setSaveRevision(m_saveRevision);
+
+    // change LineSaved flags to LineModified
+    group.flagSavedAsModified();
 
-    // iterate all undo/redo items to find out, which item sets the flag LineSaved
-    QBitArray lines(document()->lines(), false);
-    for (int i = undoItems.size() - 1; i >= 0; --i) {
-        undoItems[i].markRedoAsSaved(lines);
+    // the first group touching a line since the save sets the flag LineSaved
+    QBitArray &lines = inUndoHistory ? m_undoSavedLines : m_redoSavedLines;
+    if (lines.isEmpty()) {
+        lines.resize(document()->lines());
     }
 
-    lines.fill(false);
-    for (int i = redoItems.size() - 1; i >= 0; --i) {
-        redoItems[i].markUndoAsSaved(lines);
+    if (inUndoHistory) {
+        group.markRedoAsSaved(lines);
+    } else {
+        group.markUndoAsSaved(lines);
     }
 }
 
@@ -563,9 +624,69 @@ KTextEditor::Cursor KateUndoManager::lastRedoCursor() const
 
 void KateUndoManager::updateConfig()
 {
+    setMemoryBudget(qsizetype(m_document->config()->undoMemoryBudget()) * 1024 * 1024);
     Q_EMIT undoChanged();
 }
 
+void KateUndoManager::setMemoryBudget(qsizetype bytes)
+{
+    m_memoryBudget = std::max<qsizetype>(bytes, 0);
+    limitMemoryUsage();
+}
+
+void KateUndoManager::limitMemoryUsage()
+{
+    // compress the group that just left the recent part of the history
+    if (undoItems.size() > UncompressedUndoGroups) {
+        KateUndoGroup &group = undoItems[undoItems.size() - 1 - UncompressedUndoGroups];
+        if (!group.isCompressed() && group.memoryUsage() >= MinimumCompressedGroupSize) {
+            const qsizetype groupUsage = group.memoryUsage();
+            group.compress();
+            m_memoryUsage += group.memoryUsage() - groupUsage;
+        }
+    }
+
+    if (m_memoryBudget <= 0 || m_memoryUsage <= m_memoryBudget) {
+        return;
+    }
+
+    // drop the oldest groups, first from the undo history, keeping the most recent undo group, then from the redo history
+    const auto dropOldest = [this](std::vector<KateUndoGroup> &groups, size_t keep, bool &docWasSavedWhenEmpty) {
+        size_t dropped = 0;
+        while (m_memoryUsage > m_memoryBudget && groups.size() - dropped > keep) {
+            m_memoryUsage -= groups[dropped].memoryUsage();
+            ++dropped;
+        }
+
+        if (dropped == 0) {
+            return;
+        }
+
+        // the groups marking the saved state move with the remaining ones or are gone,
+        // either one may refer to a position in these groups, see updateModified()
+        for (KateUndoGroup **lastGroupWhenSaved : {&lastUndoGroupWhenSaved, &lastRedoGroupWhenSaved}) {
+            const auto it = std::find_if(groups.begin(), groups.end(), [lastGroupWhenSaved](const KateUndoGroup &group) {
+                return &group == *lastGroupWhenSaved;
+            });
+            if (it != groups.end()) {
+                const size_t index = it - groups.begin();
+                *lastGroupWhenSaved = (index < dropped) ? nullptr : groups.data() + (index - dropped);
+            }
+        }
+
+        groups.erase(groups.begin(), groups.begin() + dropped);
+        docWasSavedWhenEmpty = false;
+    };
+
+    dropOldest(undoItems, 1, docWasSavedWhenUndoWasEmpty);
+    dropOldest(redoItems, 0, docWasSavedWhenRedoWasEmpty);
+}
+
+void KateUndoManager::updateMemoryUsage()
+{
+    m_memoryUsage = memoryUsageOf(undoItems) + memoryUsageOf(redoItems);
+}
+
 void KateUndoManager::setAllowComplexMerge(bool allow)
 {
     m_undoComplexMerge = allow;
@@ -12,6 +12,7 @@
 
 #include <ktexteditor_export.h>
 
+#include <QBitArray>
 #include <QList>
 
 #include <optional>
@@ -110,6 +111,22 @@ public:
      */
     KTextEditor::Cursor lastRedoCursor() const;
 
+    /**
+     * Approximate memory used by the undo and redo history in bytes.
+     */
+    qsizetype memoryUsage() const
+    {
+        return m_memoryUsage;
+    }
+
+    /**
+     * Limit the memory used by the undo and redo history.
+     * If the history grows beyond the budget, the oldest groups are dropped,
+     * the most recent undo group is always kept.
+     * @param bytes memory budget in bytes, 0 for no limit
+     */
+    KTEXTEDITOR_EXPORT void setMemoryBudget(qsizetype bytes);
+
 public Q_SLOTS:
     /**
      * Undo the latest undo group.
@@ -206,6 +223,28 @@ private:
     KTEXTEDITOR_NO_EXPORT
     KTextEditor::ViewPrivate *activeView();
 
+    /**
+     * Compress undo groups that are deep enough in the history
+     * and drop the oldest groups if the memory budget is exceeded.
+     */
+    KTEXTEDITOR_NO_EXPORT
+    void limitMemoryUsage();
+
+    /**
+     * Recompute the memory usage of the undo and redo history.
+     */
+    KTEXTEDITOR_NO_EXPORT
+    void updateMemoryUsage();
+
+    /**
+     * Bring the line modification flags of @p group up to date with the last save.
+     * Groups must be passed in the order they are undone or redone, starting at the top of the history.
+     * @param group undo group to update
+     * @param inUndoHistory @p group belongs to the undo history, else to the redo history
+     */
+    KTEXTEDITOR_NO_EXPORT
+    void updateLineModifications(KateUndoGroup &group, bool inUndoHistory);
+
 private:
     KTextEditor::DocumentPrivate *m_document = nullptr;
     bool m_undoComplexMerge = false;
@@ -220,6 +259,16 @@ private:
     bool docWasSavedWhenUndoWasEmpty = true;
     bool docWasSavedWhenRedoWasEmpty = true;
 
+    // incremented on every save, groups with an older revision have outdated line modification flags
+    int m_saveRevision = 0;
+    // lines already marked as saved by updated groups of the undo/redo history, since the last save
+    QBitArray m_undoSavedLines;
+    QBitArray m_redoSavedLines;
+
+    // memory used by undoItems and redoItems and the allowed maximum, 0 for no limit
+    qsizetype m_memoryUsage = 0;
+    qsizetype m_memoryBudget = 0;
+
     // saved undo items that are used to restore state on doc reload
     std::vector<KateUndoGroup> savedUndoItems;
     std::vector<KateUndoGroup> savedRedoItems;
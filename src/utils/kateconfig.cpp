@@ -361,6 +361,11 @@ KateDocumentConfig::KateDocumentConfig()
     // Shall we do auto reloading for stuff e.g. in Git?
     addConfigEntry(ConfigEntry(AutoReloadIfStateIsInVersionControl, "Auto Reload If State Is In Version Control", QString(), true));
 
+    // Limit the memory of the undo history, old steps are dropped if it is exceeded
+    addConfigEntry(ConfigEntry(UndoMemoryBudget, "Undo Memory Budget", QString(), 0, [](const QVariant &value) {
+        return value.toInt() >= 0;
+    }));
+
     // finalize the entries, e.g. hashs them
     finalizeConfigEntries();
 
@@ -550,6 +555,10 @@ KateViewConfig::KateViewConfig()
                                    return inBounds(0, value, 99);
                                }));
     addConfigEntry(ConfigEntry(WordCompletionRemoveTail, "Word Completion Remove Tail", QString(), true));
+    addConfigEntry(ConfigEntry(WordCompletionAllDocuments,
+                               "Word Completion All Documents",
+                               QStringLiteral("word-completion-all-documents"),
+                               false));
     addConfigEntry(ConfigEntry(ShowDocWithCompletion, "Show Documentation With Completion", QString(), true));
     addConfigEntry(ConfigEntry(MultiCursorModifier, "Multiple Cursor Modifier", QString(), (int)Qt::AltModifier));
     addConfigEntry(ConfigEntry(ShowFoldingOnHoverOnly, "Show Folding Icons On Hover Only", QString(), true));
@@ -540,7 +540,12 @@ public:
         /**
          * Should we auto-reload if the old state is in version control?
          */
-        AutoReloadIfStateIsInVersionControl
+        AutoReloadIfStateIsInVersionControl,
+
+        /**
+         * Memory budget of the undo history in MiB, 0 for no limit
+         */
+        UndoMemoryBudget
     };
 
 public:
@@ -903,6 +908,16 @@ public:
         setValue(LineLengthLimit, limit);
     }
 
+    int undoMemoryBudget() const
+    {
+        return value(UndoMemoryBudget).toInt();
+    }
+
+    void setUndoMemoryBudget(int mebibytes)
+    {
+        setValue(UndoMemoryBudget, mebibytes);
+    }
+
     void setCamelCursor(bool on)
     {
         setValue(CamelCursor, on);
@@ -1024,6 +1039,7 @@ public:
         WordCompletion,
         WordCompletionMinimalWordLength,
         WordCompletionRemoveTail,
+        WordCompletionAllDocuments,
         ShowDocWithCompletion,
         MultiCursorModifier,
         ShowFoldingOnHoverOnly,
@@ -1261,6 +1277,11 @@ public:
         return value(WordCompletionRemoveTail).toBool();
     }
 
+    bool wordCompletionAllDocuments() const
+    {
+        return value(WordCompletionAllDocuments).toBool();
+    }
+
     bool textDragAndDrop() const
     {
         return value(TextDragAndDrop).toBool();
@@ -3735,7 +3735,7 @@ bool KTextEditor::ViewPrivate::isLineRTL(int line) const
     }
 }
 
-QTextLayout *KTextEditor::ViewPrivate::textLayout(const KTextEditor::Cursor pos) const
+const QTextLayout *KTextEditor::ViewPrivate::textLayout(const KTextEditor::Cursor pos) const
 {
     KateLineLayout *thisLine = m_viewInternal->cache()->line(pos.line());
     return thisLine && thisLine->isValid() ? thisLine->layout() : nullptr;
@@ -4709,6 +4709,7 @@ void KTextEditor::ViewPrivate::slotDelayedUpdateOfView()
 
     // update view, if valid line range, else only feedback update wanted anyway
     if (m_lineToUpdateRange.isValid()) {
+        m_viewInternal->m_lineScroll->invalidateMiniMapLines(m_lineToUpdateRange.start(), m_lineToUpdateRange.end());
         tagLines(m_lineToUpdateRange, true);
         updateView(true);
     }
@@ -64,6 +64,8 @@
 #include <QWhatsThis>
 #include <QtAlgorithms>
 
+#include <algorithm>
+#include <limits>
 #include <math.h>
 
 // BEGIN KateMessageLayout
@@ -175,6 +177,18 @@ KateScrollBar::KateScrollBar(Qt::Orientation orientation, KateViewInternal *pare
     m_updateTimer.setInterval(300);
     m_updateTimer.setSingleShot(true);
 
+    m_miniMapSnapshotTimer.setInterval(0);
+    m_miniMapSnapshotTimer.setSingleShot(true);
+    connect(&m_miniMapSnapshotTimer, &QTimer::timeout, this, &KateScrollBar::updatePixmap);
+
+    // the minimap tiles track all changes, they are cheap to invalidate even if the minimap is hidden
+    m_miniMapPool.setMaxThreadCount(1);
+    connect(&m_doc->buffer(), &KateBuffer::tagLines, this, &KateScrollBar::miniMapTagLines);
+    connect(m_view, &KTextEditor::ViewPrivate::selectionChanged, this, &KateScrollBar::miniMapSelectionChanged);
+    connect(&(m_view->textFolding()), &Kate::TextFolding::foldingRangesChanged, this, &KateScrollBar::invalidateMiniMap);
+    connect(m_doc, &KTextEditor::DocumentPrivate::loaded, this, &KateScrollBar::invalidateMiniMap);
+    connect(m_doc, &KTextEditor::DocumentPrivate::modifiedChanged, this, &KateScrollBar::invalidateMiniMap);
+
     // track mouse for text preview widget
     setMouseTracking(orientation == Qt::Vertical);
 
@@ -196,6 +210,8 @@ void KateScrollBar::showEvent(QShowEvent *event)
 
 KateScrollBar::~KateScrollBar()
 {
+    // running tile jobs report back to us
+    m_miniMapPool.waitForDone();
     delete m_textPreview;
 }
 
@@ -205,9 +221,11 @@ void KateScrollBar::setShowMiniMap(bool b)
         auto timerSlot = qOverload<>(&QTimer::start);
         connect(m_view, &KTextEditor::ViewPrivate::selectionChanged, &m_updateTimer, timerSlot, Qt::UniqueConnection);
         connect(m_doc, &KTextEditor::DocumentPrivate::textChanged, &m_updateTimer, timerSlot, Qt::UniqueConnection);
+        connect(&m_doc->buffer(), &KateBuffer::tagLines, &m_updateTimer, timerSlot, Qt::UniqueConnection);
         connect(m_view, &KTextEditor::ViewPrivate::delayedUpdateOfView, &m_updateTimer, timerSlot, Qt::UniqueConnection);
         connect(&m_updateTimer, &QTimer::timeout, this, &KateScrollBar::updatePixmap, Qt::UniqueConnection);
         connect(&(m_view->textFolding()), &Kate::TextFolding::foldingRangesChanged, &m_updateTimer, timerSlot, Qt::UniqueConnection);
+        connect(m_doc, &KTextEditor::DocumentPrivate::modifiedChanged, &m_updateTimer, timerSlot, Qt::UniqueConnection);
     } else if (!b) {
         disconnect(&m_updateTimer);
     }
@@ -519,6 +537,55 @@ void KateScrollBar::getCharColorRanges(const QList<Kate::TextLine::Attribute> &a
     }
 }
 
+void KateScrollBar::invalidateMiniMap()
+{
+    for (auto &tile : m_miniMapTiles) {
+        tile.valid = false;
+        ++tile.version;
+    }
+}
+
+void KateScrollBar::invalidateMiniMapLines(int startLine, int endLine)
+{
+    if (m_miniMapLinesPerTile <= 0 || m_miniMapTiles.empty()) {
+        return;
+    }
+
+    // the tiles cover visible lines, edits that add or remove lines shift all tiles behind
+    const auto &folding = m_view->textFolding();
+    const size_t firstTile = size_t(std::max(0, folding.lineToVisibleLine(std::max(0, startLine)))) / m_miniMapLinesPerTile;
+    size_t lastTile = m_miniMapTiles.size() - 1;
+    if (endLine >= 0) {
+        lastTile = std::min(lastTile, size_t(std::max(0, folding.lineToVisibleLine(endLine))) / m_miniMapLinesPerTile);
+    }
+
+    for (size_t i = firstTile; i <= lastTile && i < m_miniMapTiles.size(); ++i) {
+        m_miniMapTiles[i].valid = false;
+        ++m_miniMapTiles[i].version;
+    }
+}
+
+void KateScrollBar::miniMapTagLines(KTextEditor::LineRange lineRange)
+{
+    invalidateMiniMapLines(lineRange.start(), lineRange.end());
+}
+
+void KateScrollBar::miniMapSelectionChanged()
+{
+    // redraw the lines that were selected before and the ones selected now
+    const KTextEditor::Range selection = m_view->selectionRange();
+    if (selection == m_miniMapSelection) {
+        return;
+    }
+    if (m_miniMapSelection.isValid() && !m_miniMapSelection.isEmpty()) {
+        invalidateMiniMapLines(m_miniMapSelection.start().line(), m_miniMapSelection.end().line());
+    }
+    if (selection.isValid() && !selection.isEmpty()) {
+        invalidateMiniMapLines(selection.start().line(), selection.end().line());
+    }
+    m_miniMapSelection = selection;
+}
+
 void KateScrollBar::updatePixmap()
 {
     // QElapsedTimer time;
@@ -564,6 +631,17 @@ void KateScrollBar::updatePixmap()
     // qCDebug(LOG_KTE) << "l" << lineIncrement << "c" << charIncrement << "d";
     // qCDebug(LOG_KTE) << "pixmap" << pixmapLineCount << pixmapLineWidth << "docLines" << m_view->textFolding().visibleLines() << "height" << m_grooveHeight;
 
+    // the tiles are only reusable as long as the scaling stays the same
+    if (lineIncrement != m_miniMapLineIncrement || charIncrement != m_miniMapCharIncrement) {
+        m_miniMapTiles.clear();
+        ++m_miniMapGeneration;
+        m_miniMapLineIncrement = lineIncrement;
+        m_miniMapCharIncrement = charIncrement;
+    }
+    m_miniMapLinesPerTile = MiniMapTileRows * charIncrement * lineIncrement;
+    m_miniMapTiles.resize((docLineCount + m_miniMapLinesPerTile - 1) / m_miniMapLinesPerTile);
+    m_miniMapPixmapSize = QSize(pixmapLineWidth, pixmapLineCount);
+
     const QBrush backgroundColor = m_view->defaultStyleAttribute(KSyntaxHighlighting::Theme::TextStyle::Normal)->background();
     const QBrush defaultTextColor = m_view->defaultStyleAttribute(KSyntaxHighlighting::Theme::TextStyle::Normal)->foreground();
     const QBrush selectionBgColor = m_view->rendererConfig()->selectionColor();
@@ -574,167 +652,294 @@ void KateScrollBar::updatePixmap()
     modifiedLineColor.setHsv(modifiedLineColor.hue(), 255, 255 - backgroundColor.color().value() / 3);
     savedLineColor.setHsv(savedLineColor.hue(), 100, 255 - backgroundColor.color().value() / 3);
 
-    const QBrush modifiedLineBrush = modifiedLineColor;
-    const QBrush savedLineBrush = savedLineColor;
+    m_miniMapStyle.defaultTextPen = QPen(defaultTextColor, 1);
+    m_miniMapStyle.selectionPen = QPen(selectionBgColor, 1);
+    m_miniMapStyle.modifiedLineBrush = modifiedLineColor;
+    m_miniMapStyle.savedLineBrush = savedLineColor;
+    m_miniMapStyle.width = pixmapLineWidth;
+    m_miniMapStyle.charIncrement = charIncrement;
+
+    // the displayed tiles first, then the ones further and further away
+    const int tileCount = int(m_miniMapTiles.size());
+    const int firstShownTile = std::clamp(m_viewInternal->startLine() / m_miniMapLinesPerTile, 0, std::max(0, tileCount - 1));
+    const int lastShownTile = std::clamp(m_viewInternal->endLine() / m_miniMapLinesPerTile, firstShownTile, std::max(0, tileCount - 1));
+    std::vector<int> tileOrder;
+    tileOrder.reserve(tileCount);
+    for (int tileIndex = firstShownTile; tileIndex <= lastShownTile && tileIndex < tileCount; ++tileIndex) {
+        tileOrder.push_back(tileIndex);
+    }
+    for (int distance = 1; int(tileOrder.size()) < tileCount; ++distance) {
+        if (lastShownTile + distance < tileCount) {
+            tileOrder.push_back(lastShownTile + distance);
+        }
+        if (firstShownTile - distance >= 0) {
+            tileOrder.push_back(firstShownTile - distance);
+        }
+    }
 
-    // increase dimensions by ratio
-    m_pixmap = QPixmap(pixmapLineWidth * m_view->devicePixelRatioF(), pixmapLineCount * m_view->devicePixelRatioF());
-    m_pixmap.fill(QColor("transparent"));
+    // snapshotting is done on the GUI thread, after a full invalidation of a large document
+    // only take some tiles at once and continue after pending events got processed
+    int snapshottedLines = 0;
+    for (const int tileIndex : tileOrder) {
+        MiniMapTile &tile = m_miniMapTiles[tileIndex];
+        if (tile.valid || tile.pending) {
+            continue;
+        }
+
+        if (snapshottedLines >= MiniMapSnapshotLines) {
+            m_miniMapSnapshotTimer.start();
+            break;
+        }
+        snapshottedLines += m_miniMapLinesPerTile;
+
+        tile.pending = true;
+        m_miniMapPool.start([this, generation = m_miniMapGeneration, tileIndex, version = tile.version, data = snapshotMiniMapTile(tileIndex)]() {
+            QImage image = renderMiniMapTile(data);
+            QMetaObject::invokeMethod(
+                this,
+                [this, generation, tileIndex, version, image = std::move(image)]() {
+                    finishMiniMapTile(generation, tileIndex, version, image);
+                },
+                Qt::QueuedConnection);
+        });
+    }
 
-    // The text currently selected in the document, to be drawn later.
+    // show what we have, outdated tiles are replaced once they are rendered
+    updateMiniMapPixmap();
+
+    // qCDebug(LOG_KTE) << time.elapsed();
+}
+
+KateScrollBar::MiniMapTileData KateScrollBar::snapshotMiniMapTile(int tileIndex)
+{
+    // snapshot the lines of the tile, only the painting is done in the background
+    MiniMapTileData data = m_miniMapStyle;
+    const int charIncrement = m_miniMapCharIncrement;
+    const int lineIncrement = m_miniMapLineIncrement;
+    data.lines.reserve(MiniMapTileRows * charIncrement);
+
+    // The text currently selected in the document
     const KTextEditor::Range selection = m_view->selectionRange();
     const bool hasSelection = !selection.isEmpty();
-    // reusable buffer for color->range
-    QList<KateScrollBar::ColumnRangeWithColor> colorRangesForLine;
-    const QPen defaultTextPen = QPen(defaultTextColor, 1);
     // resusable buffer for line ranges;
     QList<Kate::TextRange *> decorations;
 
-    QPainter painter;
-    if (painter.begin(&m_pixmap)) {
-        // init pen once, afterwards, only change it if color changes to avoid a lot of allocation for setPen
-        painter.setPen(QPen(selectionBgColor, 1));
+    // don't request the highlighting of the whole document for large ones,
+    // what got highlighted for other reasons is still shown in color
+    const bool simpleMode = m_doc->lines() > 7500;
 
-        // Do not force updates of the highlighting if the document is very large
-        const bool simpleMode = m_doc->lines() > 7500;
+    const int docLineCount = m_view->textFolding().visibleLines();
+    const int firstLine = tileIndex * m_miniMapLinesPerTile;
+    const int endLine = std::min(firstLine + m_miniMapLinesPerTile, docLineCount);
+    for (int virtualLine = firstLine; virtualLine < endLine; virtualLine += lineIncrement) {
+        int realLineNumber = m_view->textFolding().visibleLineToLine(virtualLine);
 
-        int pixelY = 0;
-        int drawnLines = 0;
+        // far away lines are highlighted in the background, we get notified via tagLines
+        if (!simpleMode) {
+            m_doc->buffer().ensureHighlightedAsync(realLineNumber);
+        }
+
+        const Kate::TextLine kateline = m_doc->plainKateTextLine(realLineNumber);
+        MiniMapLine &line = data.lines.emplace_back();
+        line.text = kateline.text();
 
-        // pen cache to avoid a lot of allocations from pen creation
-        QVarLengthArray<std::pair<QRgb, QPen>, 20> penCache;
+        // get moving ranges with attribs (semantic highlighting and co.)
+        m_view->doc()->buffer().rangesForLine(realLineNumber, m_view, true, decorations);
+        getCharColorRanges(kateline.attributesList(), decorations, line.text, line.colorRanges, data.penCache);
 
-        // Iterate over all visible lines, drawing them.
-        for (int virtualLine = 0; virtualLine < docLineCount; virtualLine += lineIncrement) {
-            int realLineNumber = m_view->textFolding().visibleLineToLine(virtualLine);
-            const Kate::TextLine kateline = m_doc->plainKateTextLine(realLineNumber);
-            const QString lineText = kateline.text();
+        if (hasSelection && selection.start().line() <= realLineNumber && realLineNumber <= selection.end().line()) {
+            line.selectionStart = (selection.start().line() == realLineNumber) ? selection.start().column() : 0;
+            line.selectionEnd = (selection.end().line() == realLineNumber) ? selection.end().column() : std::numeric_limits<int>::max();
+        }
+    }
 
-            if (!simpleMode) {
-                m_doc->buffer().ensureHighlighted(realLineNumber);
+    // Draw line modification marker map.
+    // Disable this if the document is really huge,
+    // since it requires querying every line.
+    if (m_doc->lines() < 50000) {
+        data.markers.resize(MiniMapTileRows);
+        const int linesPerRow = charIncrement * lineIncrement;
+        for (int lineno = firstLine; lineno < endLine; ++lineno) {
+            const auto line = m_doc->plainKateTextLine(m_view->textFolding().visibleLineToLine(lineno));
+            quint8 &marker = data.markers[(lineno - firstLine) / linesPerRow];
+            if (line.markedAsModified()) {
+                marker = 2;
+            } else if (line.markedAsSavedOnDisk()) {
+                marker = std::max<quint8>(marker, 1);
             }
+        }
+    }
 
-            // get normal highlighting stuff
-            const auto &attributes = kateline.attributesList();
+    return data;
+}
 
-            // get moving ranges with attribs (semantic highlighting and co.)
-            m_view->doc()->buffer().rangesForLine(realLineNumber, m_view, true, decorations);
+QImage KateScrollBar::renderMiniMapTile(const MiniMapTileData &data)
+{
+    QImage image(data.width, MiniMapTileRows, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
 
-            // Draw selection if it is on an empty line
+    const int charIncrement = data.charIncrement;
 
-            int pixelX = s_pixelMargin; // use this to control the offset of the text from the left
+    QPainter painter;
+    if (!painter.begin(&image)) {
+        return image;
+    }
 
-            if (hasSelection) {
-                if (selection.contains(KTextEditor::Cursor(realLineNumber, 0)) && lineText.size() == 0) {
-                    if (selectionBgColor != painter.pen().brush()) {
-                        painter.setPen(QPen(selectionBgColor, 1));
-                    }
-                    painter.drawLine(s_pixelMargin, pixelY, s_pixelMargin + s_lineWidth - 1, pixelY);
-                }
-                // Iterate over the line to draw the background
-                int selStartX = -1;
-                int selEndX = -1;
-                for (int x = 0; (x < lineText.size() && x < s_lineWidth); x += charIncrement) {
-                    if (pixelX >= s_lineWidth + s_pixelMargin) {
-                        break;
-                    }
-                    // Query the selection and draw it behind the character
-                    if (selection.contains(KTextEditor::Cursor(realLineNumber, x))) {
-                        if (selStartX == -1) {
-                            selStartX = pixelX;
-                        }
-                        selEndX = pixelX;
-                        if (lineText.size() - 1 == x) {
-                            selEndX = s_lineWidth + s_pixelMargin - 1;
-                        }
-                    }
+    // init pen once, afterwards, only change it if color changes to avoid a lot of allocation for setPen
+    painter.setPen(data.selectionPen);
 
-                    if (lineText[x] == QLatin1Char('\t')) {
-                        pixelX += qMax(4 / charIncrement, 1); // FIXME: tab width...
-                    } else {
-                        pixelX++;
-                    }
-                }
+    int pixelY = 0;
+    int drawnLines = 0;
 
-                if (selStartX != -1) {
-                    if (selectionBgColor != painter.pen().brush()) {
-                        painter.setPen(QPen(selectionBgColor, 1));
-                    }
-                    painter.drawLine(selStartX, pixelY, selEndX, pixelY);
+    // Iterate over all lines of the tile, drawing them.
+    for (const MiniMapLine &line : data.lines) {
+        const QString &lineText = line.text;
+
+        // Draw selection if it is on an empty line
+
+        int pixelX = s_pixelMargin; // use this to control the offset of the text from the left
+
+        if (line.selectionStart != -1) {
+            auto isSelected = [&line](int column) {
+                return line.selectionStart <= column && column < line.selectionEnd;
+            };
+            if (isSelected(0) && lineText.size() == 0) {
+                if (data.selectionPen != painter.pen()) {
+                    painter.setPen(data.selectionPen);
                 }
+                painter.drawLine(s_pixelMargin, pixelY, s_pixelMargin + s_lineWidth - 1, pixelY);
             }
-
-            // Iterate over all the characters in the current line
-            getCharColorRanges(attributes, decorations, lineText, colorRangesForLine, penCache);
-            pixelX = s_pixelMargin;
+            // Iterate over the line to draw the background
+            int selStartX = -1;
+            int selEndX = -1;
             for (int x = 0; (x < lineText.size() && x < s_lineWidth); x += charIncrement) {
                 if (pixelX >= s_lineWidth + s_pixelMargin) {
                     break;
                 }
+                // Query the selection and draw it behind the character
+                if (isSelected(x)) {
+                    if (selStartX == -1) {
+                        selStartX = pixelX;
+                    }
+                    selEndX = pixelX;
+                    if (lineText.size() - 1 == x) {
+                        selEndX = s_lineWidth + s_pixelMargin - 1;
+                    }
+                }
 
-                // draw the pixels
-                if (lineText[x] == QLatin1Char(' ')) {
-                    pixelX++;
-                } else if (lineText[x] == QLatin1Char('\t')) {
+                if (lineText[x] == QLatin1Char('\t')) {
                     pixelX += qMax(4 / charIncrement, 1); // FIXME: tab width...
                 } else {
-                    const QPen *pen = nullptr;
-                    int rangeEnd = x + 1;
-                    for (const auto &cr : colorRangesForLine) {
-                        if (cr.startColumn <= x && x <= cr.endColumn) {
-                            rangeEnd = cr.endColumn;
-                            if (cr.penIndex != -1) {
-                                pen = &penCache[cr.penIndex].second;
-                            }
+                    pixelX++;
+                }
+            }
+
+            if (selStartX != -1) {
+                if (data.selectionPen != painter.pen()) {
+                    painter.setPen(data.selectionPen);
+                }
+                painter.drawLine(selStartX, pixelY, selEndX, pixelY);
+            }
+        }
+
+        // Iterate over all the characters in the current line
+        pixelX = s_pixelMargin;
+        for (int x = 0; (x < lineText.size() && x < s_lineWidth); x += charIncrement) {
+            if (pixelX >= s_lineWidth + s_pixelMargin) {
+                break;
+            }
+
+            // draw the pixels
+            if (lineText[x] == QLatin1Char(' ')) {
+                pixelX++;
+            } else if (lineText[x] == QLatin1Char('\t')) {
+                pixelX += qMax(4 / charIncrement, 1); // FIXME: tab width...
+            } else {
+                const QPen *pen = nullptr;
+                int rangeEnd = x + 1;
+                for (const auto &cr : line.colorRanges) {
+                    if (cr.startColumn <= x && x <= cr.endColumn) {
+                        rangeEnd = cr.endColumn;
+                        if (cr.penIndex != -1) {
+                            pen = &data.penCache[cr.penIndex].second;
                         }
                     }
+                }
 
-                    if (!pen) {
-                        pen = &defaultTextPen;
-                    }
-                    // get the column range and color in which this 'x' lies
-                    painter.setPen(*pen);
+                if (!pen) {
+                    pen = &data.defaultTextPen;
+                }
+                // get the column range and color in which this 'x' lies
+                painter.setPen(*pen);
 
-                    // Actually draw the pixels with the color queried from the renderer.
-                    QVarLengthArray<QPoint, 100> points;
-                    for (; x < rangeEnd; x += charIncrement) {
-                        if (pixelX >= s_lineWidth + s_pixelMargin) {
-                            break;
-                        }
-                        points.append({pixelX++, pixelY});
+                // Actually draw the pixels with the color queried from the renderer.
+                QVarLengthArray<QPoint, 100> points;
+                for (; x < rangeEnd; x += charIncrement) {
+                    if (pixelX >= s_lineWidth + s_pixelMargin) {
+                        break;
                     }
-                    painter.drawPoints(points.data(), points.size());
+                    points.append({pixelX++, pixelY});
                 }
-            }
-            drawnLines++;
-            if (((drawnLines) % charIncrement) == 0) {
-                pixelY++;
+                painter.drawPoints(points.data(), points.size());
             }
         }
-        // qCDebug(LOG_KTE) << drawnLines;
-        // Draw line modification marker map.
-        // Disable this if the document is really huge,
-        // since it requires querying every line.
-        if (m_doc->lines() < 50000) {
-            for (int lineno = 0; lineno < docLineCount; lineno++) {
-                int realLineNo = m_view->textFolding().visibleLineToLine(lineno);
-                const auto line = m_doc->plainKateTextLine(realLineNo);
-                const QBrush &col = line.markedAsModified() ? modifiedLineBrush : savedLineBrush;
-                if (line.markedAsModified() || line.markedAsSavedOnDisk()) {
-                    int pos = (lineno * pixmapLineCount) / pixmapLinesUnscaled;
-                    painter.fillRect(2, pos, 3, 1, col);
-                }
-            }
+        drawnLines++;
+        if (((drawnLines) % charIncrement) == 0) {
+            pixelY++;
+        }
+    }
+
+    // Draw line modification marker map.
+    for (size_t row = 0; row < data.markers.size(); ++row) {
+        if (data.markers[row] != 0) {
+            painter.fillRect(2, int(row), 3, 1, data.markers[row] == 2 ? data.modifiedLineBrush : data.savedLineBrush);
         }
+    }
+
+    // end painting
+    painter.end();
+    return image;
+}
 
-        // end painting
+void KateScrollBar::finishMiniMapTile(quint64 generation, int tileIndex, quint64 version, const QImage &image)
+{
+    // layout changed meanwhile? the tiles got recreated
+    if (generation != m_miniMapGeneration || tileIndex >= int(m_miniMapTiles.size())) {
+        return;
+    }
+
+    // outdated results are still better than nothing, but the tile needs another run
+    MiniMapTile &tile = m_miniMapTiles[tileIndex];
+    tile.pending = false;
+    tile.image = image;
+    if (version == tile.version) {
+        tile.valid = true;
+    } else {
+        m_updateTimer.start();
+    }
+
+    updateMiniMapPixmap();
+}
+
+void KateScrollBar::updateMiniMapPixmap()
+{
+    // increase dimensions by ratio
+    m_pixmap = QPixmap(m_miniMapPixmapSize.width() * m_view->devicePixelRatioF(), m_miniMapPixmapSize.height() * m_view->devicePixelRatioF());
+    m_pixmap.fill(QColor("transparent"));
+
+    QPainter painter;
+    if (painter.begin(&m_pixmap)) {
+        for (size_t i = 0; i < m_miniMapTiles.size(); ++i) {
+            if (!m_miniMapTiles[i].image.isNull()) {
+                painter.drawImage(0, int(i) * MiniMapTileRows, m_miniMapTiles[i].image);
+            }
+        }
         painter.end();
     }
 
     // set right ratio
     m_pixmap.setDevicePixelRatio(m_view->devicePixelRatioF());
 
-    // qCDebug(LOG_KTE) << time.elapsed();
     // Redraw the scrollbar widget with the updated pixmap.
     update();
 }
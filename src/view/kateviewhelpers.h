@@ -17,15 +17,20 @@
 
 #include <QColor>
 #include <QHash>
+#include <QImage>
 #include <QLayout>
 #include <QPixmap>
 #include <QPointer>
 #include <QScrollBar>
+#include <QThreadPool>
 #include <QTimer>
 
 #include "katetextline.h"
 #include <ktexteditor/cursor.h>
 #include <ktexteditor/message.h>
+#include <ktexteditor/range.h>
+
+#include <vector>
 
 namespace KTextEditor
 {
@@ -151,9 +156,18 @@ public:
 
     inline void queuePixmapUpdate()
     {
+        // colors might have changed, all tiles need to be redrawn
+        invalidateMiniMap();
         m_updateTimer.start();
     }
 
+    /**
+     * Mark the minimap tiles showing the given lines as outdated.
+     * @param startLine first changed line
+     * @param endLine last changed line, -1 for all lines until the end of the document
+     */
+    void invalidateMiniMapLines(int startLine, int endLine);
+
 Q_SIGNALS:
     void sliderMMBMoved(int value);
 
@@ -174,8 +188,15 @@ protected Q_SLOTS:
 public Q_SLOTS:
     void updatePixmap();
 
+    /**
+     * Mark all minimap tiles as outdated, they keep their images until they got redrawn.
+     */
+    void invalidateMiniMap();
+
 private Q_SLOTS:
     void showTextPreview();
+    void miniMapTagLines(KTextEditor::LineRange lineRange);
+    void miniMapSelectionChanged();
 
 private:
     void showTextPreviewDelayed();
@@ -200,6 +221,58 @@ private:
                             QList<KateScrollBar::ColumnRangeWithColor> &ranges,
                             QVarLengthArray<std::pair<QRgb, QPen>, 20> &penCache);
 
+    /**
+     * Number of pixel rows of one minimap tile, a tile covers
+     * MiniMapTileRows * charIncrement * lineIncrement visible lines.
+     */
+    static constexpr int MiniMapTileRows = 64;
+
+    /**
+     * Snapshot of one drawn line for the background rendering.
+     */
+    struct MiniMapLine {
+        QString text;
+        QList<ColumnRangeWithColor> colorRanges;
+        // selected columns [selectionStart, selectionEnd), -1 if nothing is selected
+        int selectionStart = -1;
+        int selectionEnd = -1;
+    };
+
+    /**
+     * Everything needed to render one tile without touching the document.
+     */
+    struct MiniMapTileData {
+        std::vector<MiniMapLine> lines;
+        // line modification marker per pixel row: 0 none, 1 saved, 2 modified
+        std::vector<quint8> markers;
+        QVarLengthArray<std::pair<QRgb, QPen>, 20> penCache;
+        QPen defaultTextPen;
+        QPen selectionPen;
+        QBrush modifiedLineBrush;
+        QBrush savedLineBrush;
+        int width = 0;
+        int charIncrement = 1;
+    };
+
+    struct MiniMapTile {
+        QImage image;
+        // incremented on invalidation, results of jobs started before get dropped
+        quint64 version = 0;
+        bool valid = false;
+        bool pending = false;
+    };
+
+    /**
+     * Number of document lines snapshotted per event loop iteration,
+     * more outdated tiles are picked up by m_miniMapSnapshotTimer.
+     */
+    static constexpr int MiniMapSnapshotLines = 4096;
+
+    MiniMapTileData snapshotMiniMapTile(int tileIndex);
+    static QImage renderMiniMapTile(const MiniMapTileData &data);
+    void finishMiniMapTile(quint64 generation, int tile, quint64 version, const QImage &image);
+    void updateMiniMapPixmap();
+
     bool m_middleMouseDown;
     bool m_leftMouseDown;
 
@@ -225,6 +298,23 @@ private:
     QTimer m_updateTimer;
     QPoint m_toolTipPos;
 
+    // minimap tiles, the pixmap is composed of them
+    std::vector<MiniMapTile> m_miniMapTiles;
+    QSize m_miniMapPixmapSize;
+    int m_miniMapLineIncrement = 0;
+    int m_miniMapCharIncrement = 0;
+    int m_miniMapLinesPerTile = 0;
+    // colors and sizes of the current layout, the lines are snapshotted per tile
+    MiniMapTileData m_miniMapStyle;
+    // continues the snapshotting of outdated tiles after the event loop did run
+    QTimer m_miniMapSnapshotTimer;
+    // incremented if the tile layout changes, results of older jobs get dropped
+    quint64 m_miniMapGeneration = 0;
+    // selection shown in the tiles, to redraw only the changed lines
+    KTextEditor::Range m_miniMapSelection = KTextEditor::Range::invalid();
+    // tiles are rendered one at a time in the background
+    QThreadPool m_miniMapPool;
+
     // lists of lines added/removed recently to avoid scrollbar flickering
     QHash<int, int> m_linesAdded;
 
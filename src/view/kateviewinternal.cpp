@@ -4371,6 +4371,7 @@ void KateViewInternal::clear()
     view()->clearSecondaryCursors();
     cache()->clear();
     updateView(true);
+    m_lineScroll->invalidateMiniMap();
     m_lineScroll->updatePixmap();
 }
 
@@ -4578,6 +4579,9 @@ void KateViewInternal::editEnd(int editTagLineStart, int editTagLineEnd, bool ta
     }
     m_startPos.setPosition(startLine(), col);
 
+    // only the minimap tiles showing the changed lines need to be redrawn
+    m_lineScroll->invalidateMiniMapLines(editTagLineStart, tagFrom ? -1 : editTagLineEnd);
+
     if (tagFrom && (editTagLineStart <= int(view()->textFolding().visibleLineToLine(startLine())))) {
         tagAll();
     } else {